@@ -8,25 +8,150 @@
 #include "metaldata/array.h"
 #include "metaldata/errors.h"
 #include "metaldata/internal/annotations.h"
+#include "metaldata/internal/array.h"
+#include "metaldata/internal/cstdlib.h"
 #include "metaldata/metaldata.h"
 
+#include <limits.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Ranges with at most this many elements are sorted with insertion sort instead of being
+ * partitioned further.
+ */
+#define INSERTION_SORT_THRESHOLD 16
+
+/**
+ * A range of elements waiting to be sorted, [start, end).
+ */
+typedef struct
+{
+    size_t start;
+    size_t end;
+    unsigned depth_limit;
+} SortRange;
+
+MDL_ANNOTN__NONNULL_ARGS(1, 2)
+static int init_array(MDLState *mds, MDLArray *array, size_t elem_size,
+                      bool inline_values, mdl_destructor_fptr elem_destructor,
+                      size_t block_size);
+
+MDL_ANNOTN__NONNULL
+static int grow_for_append(MDLArray *array, size_t n_new_elements, size_t min_new_blocks);
+
+MDL_ANNOTN__NONNULL
+static int grow_for_prepend(MDLArray *array);
+
+MDL_ANNOTN__NONNULL
+static int allocate_slab(MDLArray *array, size_t n_blocks, bool at_front);
+
+MDL_ANNOTN__NONNULL
+static void free_all_slabs(MDLArray *array);
+
+MDL_ANNOTN__NONNULL
+static int compact(MDLArray *array, size_t n_blocks);
+
+MDL_ANNOTN__NONNULL
+static void reclaim_unused_memory(MDLArray *array);
+
+MDL_ANNOTN__NONNULL
+static void update_shrink_length(MDLArray *array);
+
+MDL_ANNOTN__NONNULL
+static int reserve_table_slots(MDLArray *array, size_t n_front, size_t n_back);
+
+MDL_ANNOTN__NONNULL
+static int resolve_index(const MDLArray *array, int index, size_t *absolute_index);
+
+MDL_ANNOTN__NONNULL
+static size_t get_block_size_bytes(const MDLArray *array);
+
+MDL_ANNOTN__NONNULL
+static size_t get_block_count_for_length(const MDLArray *array, size_t length);
+
+MDL_ANNOTN__NONNULL
+MDL_ANNOTN__RETURNS_NONNULL
+static void *get_element_slot(const MDLArray *array, size_t index);
+
+MDL_ANNOTN__NONNULL
+MDL_ANNOTN__RETURNS_NONNULL
+static void **get_pointer_slot(const MDLArray *array, size_t index);
+
+MDL_ANNOTN__NONNULL
+static void *get_element_value(const MDLArray *array, const void *slot);
+
+MDL_ANNOTN__NONNULL
+static size_t get_comparator_size(const MDLArray *array);
 
 MDL_ANNOTN__NONNULL
-static int resize_block_list(MDLArray *array, size_t new_total);
+static void destroy_element(const MDLArray *array, void *slot);
 
 MDL_ANNOTN__NONNULL
-static int get_node_location_by_index(const MDLArray *array, int index,
-                                      MDLArrayBlock **block, size_t *offset);
+static size_t get_contiguous_run_length(const MDLArray *array, size_t index);
+
+MDL_ANNOTN__NONNULL
+static void move_elements(MDLArray *array, size_t dest_index, size_t src_index,
+                          size_t count);
+
+MDL_ANNOTN__NONNULL
+static int insert_element(MDLArray *array, size_t index);
+
+MDL_ANNOTN__NONNULL
+static void remove_element(MDLArray *array, size_t index);
+
+MDL_ANNOTN__NONNULL_ARGS(1, 4)
+static size_t find_value(const MDLArray *array, const void *value, bool reverse,
+                         mdl_comparator_fptr cmp);
+
+MDL_ANNOTN__NONNULL_ARGS(1, 2, 5)
+static size_t search_run(const MDLArray *array, const char *run, size_t run_length,
+                         const void *value, mdl_comparator_fptr cmp, bool reverse);
+
+MDL_ANNOTN__NONNULL_ARGS(1)
+static size_t search_run_for_pointer(void *const *run, size_t run_length,
+                                     const void *value, bool reverse);
+
+MDL_ANNOTN__NONNULL
+static int compare_elements(const MDLArray *array, size_t first, size_t second,
+                            mdl_comparator_fptr cmp);
+
+MDL_ANNOTN__NONNULL
+static void swap_elements(MDLArray *array, size_t first, size_t second);
+
+MDL_ANNOTN__NONNULL
+static size_t partition(MDLArray *array, size_t start, size_t end,
+                        mdl_comparator_fptr cmp);
+
+MDL_ANNOTN__NONNULL
+static void insertion_sort(MDLArray *array, size_t start, size_t end,
+                           mdl_comparator_fptr cmp);
+
+MDL_ANNOTN__NONNULL
+static void heap_sort(MDLArray *array, size_t start, size_t end, mdl_comparator_fptr cmp);
+
+MDL_ANNOTN__NONNULL
+static void sift_down(MDLArray *array, size_t start, size_t root, size_t heap_size,
+                      mdl_comparator_fptr cmp);
+
+MDL_ANNOTN__NONNULL
+static void copy_elements_out(const MDLArray *array, size_t start, size_t count,
+                              void *dest);
 
 MDLArray *mdl_array_new(MDLState *mds, mdl_destructor_fptr elem_destructor)
+{
+    return mdl_array_newwithblocksize(mds, elem_destructor, MDL_DEFAULT_ARRAY_BLOCK_SIZE);
+}
+
+MDLArray *mdl_array_newwithblocksize(MDLState *mds, mdl_destructor_fptr elem_destructor,
+                                     size_t block_size)
 {
     MDLArray *array = mdl_malloc(mds, sizeof(*array));
     if (array == NULL)
         return NULL;
 
-    int result = mdl_array_init(mds, array, elem_destructor);
+    int result = mdl_array_initwithblocksize(mds, array, elem_destructor, block_size);
     if (result != MDL_OK)
     {
         mdl_free(mds, array, sizeof(*array));
@@ -37,24 +162,54 @@ MDLArray *mdl_array_new(MDLState *mds, mdl_destructor_fptr elem_destructor)
     return array;
 }
 
-int mdl_array_init(MDLState *mds, MDLArray *array, mdl_destructor_fptr elem_destructor)
+MDLArray *mdl_array_newwithelemsize(MDLState *mds, size_t elem_size,
+                                    mdl_destructor_fptr elem_destructor)
 {
-    array->blocks = (MDLArrayBlock **)mdl_malloc(mds, sizeof(MDLArrayBlock *));
-    if (array->blocks == NULL)
-        return MDL_ERROR_NOMEM;
+    MDLArray *array = mdl_malloc(mds, sizeof(*array));
+    if (array == NULL)
+        return NULL;
 
-    array->blocks[0] = mdl_malloc(mds, sizeof(MDLArrayBlock));
-    if (array->blocks[0] == NULL)
+    int result = mdl_array_initwithelemsize(mds, array, elem_size, elem_destructor);
+    if (result != MDL_OK)
     {
-        mdl_free(mds, (void *)array->blocks, sizeof(MDLArrayBlock *));
-        return MDL_ERROR_NOMEM;
+        mdl_free(mds, array, sizeof(*array));
+        return NULL;
     }
 
-    array->mds = mds;
-    array->length = 0;
-    array->was_allocated = false;
-    array->elem_destructor = elem_destructor;
-    array->n_allocated_blocks = 1;
+    array->was_allocated = true;
+    return array;
+}
+
+int mdl_array_init(MDLState *mds, MDLArray *array, mdl_destructor_fptr elem_destructor)
+{
+    return mdl_array_initwithblocksize(mds, array, elem_destructor,
+                                       MDL_DEFAULT_ARRAY_BLOCK_SIZE);
+}
+
+int mdl_array_initwithblocksize(MDLState *mds, MDLArray *array,
+                                mdl_destructor_fptr elem_destructor, size_t block_size)
+{
+    return init_array(mds, array, sizeof(void *), false, elem_destructor, block_size);
+}
+
+int mdl_array_initwithelemsize(MDLState *mds, MDLArray *array, size_t elem_size,
+                               mdl_destructor_fptr elem_destructor)
+{
+    if (elem_size == 0)
+        return MDL_ERROR_INVALID_ARGUMENT;
+    return init_array(mds, array, elem_size, true, elem_destructor,
+                      MDL_DEFAULT_ARRAY_BLOCK_SIZE);
+}
+
+int mdl_array_setshrinkthreshold(MDLArray *array, unsigned percent)
+{
+    // The array is compacted so that it's half full, so a threshold of 50% or more would
+    // compact it again on the very next pop.
+    if (percent >= 50)
+        return MDL_ERROR_INVALID_ARGUMENT;
+
+    array->shrink_threshold = percent;
+    update_shrink_length(array);
     return MDL_OK;
 }
 
@@ -64,10 +219,8 @@ int mdl_array_destroy(MDLArray *array)
     if (result != MDL_OK)
         return result;
 
-    // After the array has been cleared there will be exactly one allocated block left.
-    mdl_free(array->mds, array->blocks[0], sizeof(MDLArrayBlock));
-    mdl_free(array->mds, (void *)array->blocks, sizeof(MDLArrayBlock *));
-
+    // Clearing the array frees all of its blocks and the block table, so all that's left
+    // is the array itself.
     if (array->was_allocated)
         mdl_free(array->mds, array, sizeof(*array));
 
@@ -79,161 +232,421 @@ size_t mdl_array_length(const MDLArray *array)
     return array->length;
 }
 
+size_t mdl_array_getelementsize(const MDLArray *array)
+{
+    return array->elem_size;
+}
+
 int mdl_array_head(const MDLArray *array, void **item)
 {
+    if (array->inline_values)
+        return MDL_ERROR_NOT_SUPPORTED;
     if (array->length == 0)
         return MDL_ERROR_OUT_OF_RANGE;
 
-    *item = array->blocks[0]->values[0];
+    *item = *get_pointer_slot(array, 0);
     return MDL_OK;
 }
 
 int mdl_array_tail(const MDLArray *array, void **item)
 {
+    if (array->inline_values)
+        return MDL_ERROR_NOT_SUPPORTED;
     if (array->length == 0)
         return MDL_ERROR_OUT_OF_RANGE;
 
-    *item = array->blocks[array->length / MDL_DEFAULT_ARRAY_BLOCK_SIZE]
-                ->values[array->length % MDL_DEFAULT_ARRAY_BLOCK_SIZE];
+    *item = *get_pointer_slot(array, array->length - 1);
     return MDL_OK;
 }
 
 int mdl_array_push(MDLArray *array, void *item)
 {
-    int error = mdl_array_ensurecapacity(array, array->length + 1);
+    if (array->inline_values)
+        return MDL_ERROR_NOT_SUPPORTED;
+    return mdl_array_pushcopy(array, &item);
+}
+
+int mdl_array_pushcopy(MDLArray *array, const void *src)
+{
+    int error = grow_for_append(array, 1, array->n_allocated_blocks / 2);
     if (error != MDL_OK)
         return error;
 
-    array->blocks[array->length / MDL_DEFAULT_ARRAY_BLOCK_SIZE]
-        ->values[array->length % MDL_DEFAULT_ARRAY_BLOCK_SIZE] = item;
+    mdl_memcpy(get_element_slot(array, array->length), src, array->elem_size);
     array->length++;
     return MDL_OK;
 }
 
 int mdl_array_bulkpush(MDLArray *array, void *const *items, size_t count)
 {
-    int error = mdl_array_ensurecapacity(array, array->length + count);
+    if (array->inline_values)
+        return MDL_ERROR_NOT_SUPPORTED;
+
+    int error = grow_for_append(array, count, array->n_allocated_blocks / 2);
     if (error != MDL_OK)
         return error;
 
     for (size_t i = 0; i < count; i++, array->length++)
-    {
-        array->blocks[array->length / MDL_DEFAULT_ARRAY_BLOCK_SIZE]
-            ->values[array->length % MDL_DEFAULT_ARRAY_BLOCK_SIZE] = items[i];
-    }
+        *get_pointer_slot(array, array->length) = items[i];
     return MDL_OK;
 }
 
 int mdl_array_pop(MDLArray *array, void **item)
+{
+    if (array->inline_values)
+        return MDL_ERROR_NOT_SUPPORTED;
+    return mdl_array_popcopy(array, (void *)item);
+}
+
+int mdl_array_popcopy(MDLArray *array, void *buf)
 {
     if (array->length == 0)
         return MDL_ERROR_EMPTY;
 
-    MDLArrayBlock *block;
-    size_t element_index;
+    if (buf != NULL)
+        mdl_memcpy(buf, get_element_slot(array, array->length - 1), array->elem_size);
 
-    int error = get_node_location_by_index(array, -1, &block, &element_index);
-    if (error != MDL_OK)
-        return error;
+    // The block stays allocated even if it's now empty, so pushing and popping across a
+    // block boundary doesn't hit the allocator every time. Memory is only given back once
+    // the array is mostly empty.
+    array->length--;
+    if (array->length < array->shrink_length)
+        reclaim_unused_memory(array);
+    return MDL_OK;
+}
 
-    if (item != NULL)
-        *item = block->values[element_index];
+int mdl_array_bulkpop(MDLArray *array, void **items, size_t count)
+{
+    if (array->inline_values)
+        return MDL_ERROR_NOT_SUPPORTED;
+    if (count > array->length)
+        return MDL_ERROR_OUT_OF_RANGE;
 
-    array->length--;
+    if (items != NULL)
+        copy_elements_out(array, array->length - count, count, (void *)items);
 
-    // If the index of the element we just popped is 0, that means the last block in the
-    // array is now empty. We always want to ensure that there's at least one block in the
-    // array, so if the list is empty we won't deallocate the last block either.
-    if ((element_index != 0) || (array->length == 0))
-        return MDL_OK;
+    // The length is only adjusted once, and memory is reclaimed at most once no matter
+    // how many blocks were emptied.
+    array->length -= count;
+    if (array->length < array->shrink_length)
+        reclaim_unused_memory(array);
+    return MDL_OK;
+}
+
+int mdl_array_pushfront(MDLArray *array, void *item)
+{
+    if (array->inline_values)
+        return MDL_ERROR_NOT_SUPPORTED;
+    return mdl_array_pushfrontcopy(array, &item);
+}
+
+int mdl_array_pushfrontcopy(MDLArray *array, const void *src)
+{
+    int error = grow_for_prepend(array);
+    if (error != MDL_OK)
+        return error;
 
-    return resize_block_list(array, array->n_allocated_blocks - 1);
+    // There's guaranteed to be at least one free slot before the head now, so nothing
+    // needs to be moved.
+    array->head_offset--;
+    array->length++;
+    mdl_memcpy(get_element_slot(array, 0), src, array->elem_size);
+    return MDL_OK;
+}
+
+int mdl_array_popfront(MDLArray *array, void **item)
+{
+    if (array->inline_values)
+        return MDL_ERROR_NOT_SUPPORTED;
+    return mdl_array_popfrontcopy(array, (void *)item);
 }
 
-// int mdl_array_bulkpop(MDLArray *array, size_t count, void **items);
+int mdl_array_popfrontcopy(MDLArray *array, void *buf)
+{
+    if (array->length == 0)
+        return MDL_ERROR_EMPTY;
 
-// int mdl_array_pushfront(MDLArray *array, void *item);
+    if (buf != NULL)
+        mdl_memcpy(buf, get_element_slot(array, 0), array->elem_size);
 
-// int mdl_array_popfront(MDLArray *array, void **item);
+    // Like with pop, blocks emptied by this stay allocated. They'll be moved to the back
+    // of the array when more room is needed there.
+    array->head_offset++;
+    array->length--;
+    if (array->length < array->shrink_length)
+        reclaim_unused_memory(array);
+    return MDL_OK;
+}
 
 int mdl_array_getat(const MDLArray *array, int index, void **value)
 {
-    MDLArrayBlock *block;
-    size_t block_offset;
+    if (array->inline_values)
+        return MDL_ERROR_NOT_SUPPORTED;
+    return mdl_array_getcopy(array, index, (void *)value);
+}
+
+int mdl_array_getcopy(const MDLArray *array, int index, void *buf)
+{
+    size_t absolute_index;
 
-    int result = get_node_location_by_index(array, index, &block, &block_offset);
+    int result = resolve_index(array, index, &absolute_index);
     if (result != MDL_OK)
         return result;
 
-    *value = block->values[block_offset];
+    mdl_memcpy(buf, get_element_slot(array, absolute_index), array->elem_size);
     return MDL_OK;
 }
 
+void *mdl_array_getptrat(const MDLArray *array, int index)
+{
+    size_t absolute_index;
+
+    if (resolve_index(array, index, &absolute_index) != MDL_OK)
+        return NULL;
+    return get_element_slot(array, absolute_index);
+}
+
 int mdl_array_setat(MDLArray *array, int index, void *new_value)
 {
-    MDLArrayBlock *block;
-    size_t block_offset;
+    if (array->inline_values)
+        return MDL_ERROR_NOT_SUPPORTED;
+    return mdl_array_setcopy(array, index, &new_value);
+}
+
+int mdl_array_setcopy(MDLArray *array, int index, const void *src)
+{
+    size_t absolute_index;
 
-    int result = get_node_location_by_index(array, index, &block, &block_offset);
+    int result = resolve_index(array, index, &absolute_index);
     if (result != MDL_OK)
         return result;
 
-    block->values[block_offset] = new_value;
+    mdl_memcpy(get_element_slot(array, absolute_index), src, array->elem_size);
     return MDL_OK;
 }
 
-// int mdl_array_insertafter(MDLArray *array, int index, void *new_value);
+int mdl_array_insertafter(MDLArray *array, int index, void *new_value)
+{
+    if (array->inline_values)
+        return MDL_ERROR_NOT_SUPPORTED;
 
-// int mdl_array_removeat(MDLArray *array, int index, void **value);
+    size_t absolute_index;
+    int error = resolve_index(array, index, &absolute_index);
+    if (error != MDL_OK)
+        return error;
 
-int mdl_array_clear(MDLArray *array)
+    // The new element goes right after the one at `absolute_index`.
+    error = insert_element(array, absolute_index + 1);
+    if (error != MDL_OK)
+        return error;
+
+    *get_pointer_slot(array, absolute_index + 1) = new_value;
+    return MDL_OK;
+}
+
+int mdl_array_removeat(MDLArray *array, int index, void **value)
+{
+    if (array->inline_values)
+        return MDL_ERROR_NOT_SUPPORTED;
+
+    size_t absolute_index;
+    int error = resolve_index(array, index, &absolute_index);
+    if (error != MDL_OK)
+        return error;
+
+    if (value != NULL)
+        *value = *get_pointer_slot(array, absolute_index);
+
+    remove_element(array, absolute_index);
+    return MDL_OK;
+}
+
+int mdl_array_copyrange(const MDLArray *array, size_t start, size_t end, void **items)
 {
-    size_t num_blocks = array->n_allocated_blocks;
+    if (array->inline_values)
+        return MDL_ERROR_NOT_SUPPORTED;
+    if ((start > end) || (end > array->length))
+        return MDL_ERROR_OUT_OF_RANGE;
+
+    copy_elements_out(array, start, end - start, (void *)items);
+    return MDL_OK;
+}
 
+int mdl_array_clear(MDLArray *array)
+{
     if (array->elem_destructor != NULL)
     {
-        size_t elements_remaining = array->length;
+        size_t position = array->head_offset;
+        size_t end = array->head_offset + array->length;
 
-        for (size_t block_i = 0; block_i < num_blocks; block_i++)
+        // Go one block at a time so that we don't need to compute the location of every
+        // element individually.
+        while (position < end)
         {
-            size_t loop_limit = (MDL_DEFAULT_ARRAY_BLOCK_SIZE < elements_remaining)
-                                    ? MDL_DEFAULT_ARRAY_BLOCK_SIZE
-                                    : elements_remaining;
+            MDLArrayBlock block =
+                array->blocks[array->first_block + (position >> array->block_shift)];
+            size_t offset = position & (array->block_size - 1);
+            size_t run_length = array->block_size - offset;
 
-            for (size_t elem_i = 0; elem_i < loop_limit; elem_i++)
-            {
-                array->elem_destructor(array->mds,
-                                       array->blocks[block_i]->values[elem_i]);
-                elements_remaining--;
-            }
+            if (run_length > end - position)
+                run_length = end - position;
+
+            char *element = block + (offset * array->elem_size);
+            for (size_t i = 0; i < run_length; i++, element += array->elem_size)
+                destroy_element(array, element);
+
+            position += run_length;
         }
     }
 
     array->length = 0;
 
-    // Always keep at least one block allocated so that we don't have to do null checks
-    // everywhere.
-    return resize_block_list(array, 1);
+    // Every block lives in a slab, so this is one call to the allocator per slab rather
+    // than one per block.
+    free_all_slabs(array);
+
+    if (array->blocks != NULL)
+    {
+        mdl_free(array->mds, (void *)array->blocks,
+                 array->table_capacity * sizeof(MDLArrayBlock));
+        array->blocks = NULL;
+    }
+
+    array->first_block = 0;
+    array->head_offset = 0;
+    array->n_allocated_blocks = 0;
+    array->table_capacity = 0;
+    update_shrink_length(array);
+    return MDL_OK;
 }
 
-// int mdl_array_find(const MDLArray *array, const void *value, mdl_comparator_fptr cmp);
+int mdl_array_shrinktofit(MDLArray *array)
+{
+    size_t n_blocks = get_block_count_for_length(array, array->length);
+    if ((n_blocks == array->n_allocated_blocks) && (n_blocks == array->table_capacity))
+        return MDL_OK;
+    return compact(array, n_blocks);
+}
 
-// int mdl_array_rfind(const MDLArray *array, const void *value, mdl_comparator_fptr cmp);
+int mdl_array_find(const MDLArray *array, const void *value, mdl_comparator_fptr cmp)
+{
+    size_t index = find_value(array, value, false, cmp);
+    if (index == MDL_INVALID_INDEX)
+        return -1;
+    return (int)index;
+}
 
-// int mdl_array_removevalue(MDLArray *array, const void *value, mdl_comparator_fptr cmp);
+int mdl_array_rfind(const MDLArray *array, const void *value, mdl_comparator_fptr cmp)
+{
+    size_t index = find_value(array, value, true, cmp);
+    if (index == MDL_INVALID_INDEX)
+        return -1;
+    return (int)index;
+}
 
-int mdl_array_ensurecapacity(MDLArray *array, size_t capacity)
+int mdl_array_removevalue(MDLArray *array, const void *value, mdl_comparator_fptr cmp)
 {
-    size_t min_required_blocks = capacity / MDL_DEFAULT_ARRAY_BLOCK_SIZE;
+    size_t index = find_value(array, value, false, cmp);
+    if (index == MDL_INVALID_INDEX)
+        return 0;
 
-    if (min_required_blocks % MDL_DEFAULT_ARRAY_BLOCK_SIZE > 0)
-        min_required_blocks++;
+    destroy_element(array, get_element_slot(array, index));
+    remove_element(array, index);
+    return 1;
+}
 
-    size_t n_current_blocks = array->n_allocated_blocks;
-    if (n_current_blocks >= min_required_blocks)
+int mdl_array_sort(MDLArray *array, mdl_comparator_fptr cmp)
+{
+    // This is an introsort. We always defer the larger of the two partitions and keep
+    // working on the smaller one, so the deferred range is at least twice the size of the
+    // one we're working on. Thus, the stack never needs more entries than there are bits
+    // in the length.
+    SortRange stack[sizeof(size_t) * CHAR_BIT];
+    size_t stack_size = 0;
+    size_t start = 0;
+    size_t end = array->length;
+
+    // If partitioning goes more than 2 * log2(n) levels deep, we're hitting the quicksort
+    // worst case. Switch to heapsort for that range to keep this O(n log n).
+    unsigned depth_limit = 0;
+    for (size_t length = array->length; length > 1; length >>= 1)
+        depth_limit += 2;
+
+    while (true)
+    {
+        while (end - start > INSERTION_SORT_THRESHOLD)
+        {
+            if (depth_limit == 0)
+            {
+                heap_sort(array, start, end, cmp);
+                start = end;
+                break;
+            }
+            depth_limit--;
+
+            size_t split = partition(array, start, end, cmp);
+            if (split - start < end - split)
+            {
+                stack[stack_size++] = (SortRange){split, end, depth_limit};
+                end = split;
+            }
+            else
+            {
+                stack[stack_size++] = (SortRange){start, split, depth_limit};
+                start = split;
+            }
+        }
+
+        insertion_sort(array, start, end, cmp);
+        if (stack_size == 0)
+            return MDL_OK;
+
+        stack_size--;
+        start = stack[stack_size].start;
+        end = stack[stack_size].end;
+        depth_limit = stack[stack_size].depth_limit;
+    }
+}
+
+size_t mdl_array_lowerbound(const MDLArray *array, const void *value,
+                            mdl_comparator_fptr cmp)
+{
+    size_t low = 0;
+    size_t high = array->length;
+    size_t cmp_size = get_comparator_size(array);
+
+    while (low < high)
+    {
+        size_t middle = low + (high - low) / 2;
+        void *element = get_element_value(array, get_element_slot(array, middle));
+
+        if (cmp(array->mds, element, value, cmp_size) < 0)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low;
+}
+
+int mdl_array_bsearch(const MDLArray *array, const void *value, mdl_comparator_fptr cmp)
+{
+    size_t index = mdl_array_lowerbound(array, value, cmp);
+    if (index >= array->length)
+        return -1;
+
+    void *element = get_element_value(array, get_element_slot(array, index));
+    if (cmp(array->mds, element, value, get_comparator_size(array)) == 0)
+        return (int)index;
+    return -1;
+}
+
+int mdl_array_ensurecapacity(MDLArray *array, size_t capacity)
+{
+    if (capacity <= array->length)
         return MDL_OK;
 
-    return resize_block_list(array, min_required_blocks);
+    // All the missing blocks come from a single allocation.
+    return grow_for_append(array, capacity - array->length, 0);
 }
 
 MDLArrayIterator *mdl_array_getiterator(const MDLArray *array, bool reverse)
@@ -252,138 +665,875 @@ void mdl_arrayiter_init(const MDLArray *array, MDLArrayIterator *iter, bool reve
     iter->array = array;
     iter->reverse = reverse;
     iter->was_allocated = false;
+    iter->n_remaining = array->length;
 
-    if (!reverse)
-    {
+    if ((array->length == 0) || !reverse)
         iter->absolute_index = 0;
-        iter->block_element_index = 0;
-        iter->block_index = 0;
-    }
     else
-    {
         iter->absolute_index = array->length - 1;
-        iter->block_element_index = array->length / MDL_DEFAULT_ARRAY_BLOCK_SIZE;
-        iter->block_index = array->length % MDL_DEFAULT_ARRAY_BLOCK_SIZE;
-    }
+
+    // This is the only place we need to compute the location of an element from scratch.
+    // Stepping through the array from here on only increments or decrements the offset,
+    // and moves to the adjacent block when it runs off the end of the current one.
+    size_t position = array->head_offset + iter->absolute_index;
+    iter->block_index = array->first_block + (position >> array->block_shift);
+    iter->block_element_index = position & (array->block_size - 1);
 }
 
 void *mdl_arrayiter_get(const MDLArrayIterator *iter)
 {
-    // Because there is always at least one block allocated, and we don't advance the
-    // iterator past the end of the array, we don't need to do bounds checking here. Doing
-    // so would only protect us against the case where this is called on an empty list, so
-    // it isn't useful for most cases. The documentation explicitly states that calling
-    // this on an empty list returns an undefined value, so we can get away with it.
-    return iter->array->blocks[iter->block_index]->values[iter->block_element_index];
+    void **ptr = mdl_arrayiter_getptr(iter);
+    if (ptr == NULL)
+        return NULL;
+    return *ptr;
+}
+
+void *mdl_arrayiter_getptr(const MDLArrayIterator *iter)
+{
+    const MDLArray *array = iter->array;
+
+    // Because we don't advance the iterator past the end of the array, the only time it
+    // can point outside the array is when the array is empty. Empty arrays may not have
+    // any blocks allocated at all.
+    if (array->length == 0)
+        return NULL;
+
+    size_t offset = iter->block_element_index * array->elem_size;
+    return array->blocks[iter->block_index] + offset;
 }
 
 int mdl_arrayiter_next(MDLArrayIterator *iter)
 {
-    if ((!iter->reverse && (iter->absolute_index + 1 >= iter->array->length)) ||
-        (iter->reverse && (iter->absolute_index == 0)))
+    if (iter->n_remaining <= 1)
         return MDL_EOF;
 
+    iter->n_remaining--;
     if (!iter->reverse)
+    {
         iter->absolute_index++;
+        iter->block_element_index++;
+        if (iter->block_element_index == iter->array->block_size)
+        {
+            iter->block_index++;
+            iter->block_element_index = 0;
+        }
+    }
     else
+    {
         iter->absolute_index--;
-    iter->block_index = iter->absolute_index / MDL_DEFAULT_ARRAY_BLOCK_SIZE;
-    iter->block_element_index = iter->absolute_index % MDL_DEFAULT_ARRAY_BLOCK_SIZE;
+        if (iter->block_element_index == 0)
+        {
+            iter->block_index--;
+            iter->block_element_index = iter->array->block_size;
+        }
+        iter->block_element_index--;
+    }
     return MDL_OK;
 }
 
-bool mdl_arrayiter_hasnext(const MDLArrayIterator *iter)
-{
-    if (iter->array->length > 0)
-        return iter->absolute_index < (iter->array->length - 1);
-    return false;
-}
-
-void mdl_arrayiter_destroy(MDLArrayIterator *iter)
+size_t mdl_arrayiter_nextspan(MDLArrayIterator *iter, const void **span)
 {
-    if (iter->was_allocated)
-        mdl_free(iter->array->mds, iter, sizeof(*iter));
-}
-
-/******** Helper functions ********/
+    if (iter->n_remaining == 0)
+        return 0;
 
-static int resize_block_list(MDLArray *array, size_t new_total)
-{
-    size_t n_current_blocks = array->n_allocated_blocks;
+    size_t first_element_index;
+    size_t span_length;
 
-    // Always keep at least one block allocated.
-    if (new_total == 0)
-        return MDL_ERROR_INVALID_ARGUMENT;
+    if (!iter->reverse)
+    {
+        span_length = iter->array->block_size - iter->block_element_index;
+        if (span_length > iter->n_remaining)
+            span_length = iter->n_remaining;
+        first_element_index = iter->block_element_index;
+    }
+    else
+    {
+        span_length = iter->block_element_index + 1;
+        if (span_length > iter->n_remaining)
+            span_length = iter->n_remaining;
+        first_element_index = iter->block_element_index - (span_length - 1);
+    }
+
+    *span = iter->array->blocks[iter->block_index] +
+            (first_element_index * iter->array->elem_size);
+    iter->n_remaining -= span_length;
+
+    // If that was the last span, leave the iterator on the last element like we do when
+    // calling next(). Otherwise, the span always ends at a block boundary so the next
+    // element is at one end of the adjacent block.
+    if (iter->n_remaining == 0)
+    {
+        if (!iter->reverse)
+        {
+            iter->absolute_index += span_length - 1;
+            iter->block_element_index += span_length - 1;
+        }
+        else
+        {
+            iter->absolute_index -= span_length - 1;
+            iter->block_element_index -= span_length - 1;
+        }
+    }
+    else if (!iter->reverse)
+    {
+        iter->absolute_index += span_length;
+        iter->block_index++;
+        iter->block_element_index = 0;
+    }
+    else
+    {
+        iter->absolute_index -= span_length;
+        iter->block_index--;
+        iter->block_element_index = iter->array->block_size - 1;
+    }
+    return span_length;
+}
+
+bool mdl_arrayiter_hasnext(const MDLArrayIterator *iter)
+{
+    return iter->n_remaining > 1;
+}
+
+void mdl_arrayiter_destroy(MDLArrayIterator *iter)
+{
+    if (iter->was_allocated)
+        mdl_free(iter->array->mds, iter, sizeof(*iter));
+}
+
+/******** Helper functions ********/
+
+static int init_array(MDLState *mds, MDLArray *array, size_t elem_size,
+                      bool inline_values, mdl_destructor_fptr elem_destructor,
+                      size_t block_size)
+{
+    // The block size must be a power of 2 so that we can use shifts and masks instead of
+    // division and modulo everywhere.
+    if ((block_size == 0) || ((block_size & (block_size - 1)) != 0))
+        return MDL_ERROR_INVALID_ARGUMENT;
 
-    if (new_total == n_current_blocks)
+    if (block_size > SIZE_MAX / elem_size)
+        return MDL_ERROR_INVALID_ARGUMENT;
+
+    unsigned block_shift = 0;
+    while (((size_t)1 << block_shift) < block_size)
+        block_shift++;
+
+    array->mds = mds;
+    array->length = 0;
+    array->was_allocated = false;
+    array->elem_destructor = elem_destructor;
+    array->elem_size = elem_size;
+    array->inline_values = inline_values;
+    array->block_size = block_size;
+    array->block_shift = block_shift;
+    array->shrink_threshold = MDL_DEFAULT_ARRAY_SHRINK_THRESHOLD;
+    array->shrink_length = 0;
+
+    // Nothing is allocated until the first element is added.
+    array->blocks = NULL;
+    array->slabs = NULL;
+    array->first_block = 0;
+    array->head_offset = 0;
+    array->n_allocated_blocks = 0;
+    array->table_capacity = 0;
+    return MDL_OK;
+}
+
+static int grow_for_append(MDLArray *array, size_t n_new_elements, size_t min_new_blocks)
+{
+    if (n_new_elements > SIZE_MAX - array->length - array->head_offset)
+        return MDL_ERROR_NOMEM;
+
+    size_t min_required_blocks = get_block_count_for_length(
+        array, array->head_offset + array->length + n_new_elements);
+    size_t n_current_blocks = array->n_allocated_blocks;
+
+    if (n_current_blocks >= min_required_blocks)
+        return MDL_OK;
+
+    size_t n_blocks_to_add = min_required_blocks - n_current_blocks;
+
+    // Recycle unused blocks at the front of the array before allocating new ones. This
+    // way an array used as a FIFO queue stops allocating once it reaches a steady size.
+    size_t n_blocks_to_move = array->head_offset >> array->block_shift;
+    if (n_blocks_to_move > n_blocks_to_add)
+        n_blocks_to_move = n_blocks_to_add;
+
+    if (n_blocks_to_move > 0)
+    {
+        int error = reserve_table_slots(array, 0, n_blocks_to_move);
+        if (error != MDL_OK)
+            return error;
+
+        MDLArrayBlock *first_block = array->blocks + array->first_block;
+        for (size_t i = 0; i < n_blocks_to_move; i++)
+            first_block[n_current_blocks + i] = first_block[i];
+
+        array->first_block += n_blocks_to_move;
+        array->head_offset -= n_blocks_to_move << array->block_shift;
+        n_blocks_to_add -= n_blocks_to_move;
+        if (n_blocks_to_add == 0)
+            return MDL_OK;
+    }
+
+    // Pushes pass half of the current block count as the minimum, so appending n elements
+    // one at a time only needs O(log n) slabs.
+    if (n_blocks_to_add < min_new_blocks)
+        n_blocks_to_add = min_new_blocks;
+    return allocate_slab(array, n_blocks_to_add, false);
+}
+
+static int grow_for_prepend(MDLArray *array)
+{
+    if (array->head_offset > 0)
+        return MDL_OK;
+
+    size_t n_blocks_in_use = get_block_count_for_length(array, array->length);
+    size_t n_current_blocks = array->n_allocated_blocks;
+
+    // If there's an unused block at the back of the array, move it to the front instead
+    // of allocating a new one.
+    if (n_blocks_in_use < n_current_blocks)
+    {
+        int error = reserve_table_slots(array, 1, 0);
+        if (error != MDL_OK)
+            return error;
+
+        array->first_block--;
+        array->blocks[array->first_block] =
+            array->blocks[array->first_block + n_current_blocks];
+        array->head_offset = array->block_size;
         return MDL_OK;
+    }
+
+    // Grow by at least half of what we already have, same as when appending.
+    size_t n_blocks_to_add = n_current_blocks / 2;
+    if (n_blocks_to_add == 0)
+        n_blocks_to_add = 1;
+    return allocate_slab(array, n_blocks_to_add, true);
+}
+
+static int allocate_slab(MDLArray *array, size_t n_blocks, bool at_front)
+{
+    size_t block_size_bytes = get_block_size_bytes(array);
 
-    MDLArrayBlock **new_block_list;
-    if (new_total > n_current_blocks)
+    if (n_blocks > (SIZE_MAX - sizeof(MDLArraySlab)) / block_size_bytes)
+        return MDL_ERROR_NOMEM;
+
+    // Make sure the block table has room first. If allocating the slab fails afterward,
+    // the extra room will be used next time.
+    int error;
+    if (at_front)
+        error = reserve_table_slots(array, n_blocks, 0);
+    else
+        error = reserve_table_slots(array, 0, n_blocks);
+
+    if (error != MDL_OK)
+        return error;
+
+    size_t slab_size = sizeof(MDLArraySlab) + (n_blocks * block_size_bytes);
+    MDLArraySlab *slab = mdl_malloc(array->mds, slab_size);
+    if (slab == NULL)
+        return MDL_ERROR_NOMEM;
+
+    slab->next = array->slabs;
+    slab->size = slab_size;
+    array->slabs = slab;
+
+    size_t first_new_block;
+    if (at_front)
+    {
+        array->first_block -= n_blocks;
+        array->head_offset += n_blocks << array->block_shift;
+        first_new_block = array->first_block;
+    }
+    else
+        first_new_block = array->first_block + array->n_allocated_blocks;
+
+    // The blocks are laid out back to back immediately after the slab header.
+    char *block_memory = (char *)(slab + 1);
+    for (size_t i = 0; i < n_blocks; i++, block_memory += block_size_bytes)
+        array->blocks[first_new_block + i] = block_memory;
+
+    array->n_allocated_blocks += n_blocks;
+    update_shrink_length(array);
+    return MDL_OK;
+}
+
+static void free_all_slabs(MDLArray *array)
+{
+    MDLArraySlab *slab = array->slabs;
+    while (slab != NULL)
     {
-        // Growing the array.
-        new_block_list = mdl_realloc(array->mds, (void *)array->blocks,
-                                     new_total * sizeof(MDLArrayBlock *),
-                                     n_current_blocks * sizeof(MDLArrayBlock *));
+        MDLArraySlab *next_slab = slab->next;
+        mdl_free(array->mds, slab, slab->size);
+        slab = next_slab;
+    }
+    array->slabs = NULL;
+}
+
+static int compact(MDLArray *array, size_t n_blocks)
+{
+    size_t block_size_bytes = get_block_size_bytes(array);
+    MDLArraySlab *slab = NULL;
 
-        if (new_block_list == NULL)
+    // Copy everything into a single new slab first, so that the array is untouched if the
+    // allocation fails.
+    if (n_blocks > 0)
+    {
+        if (n_blocks > (SIZE_MAX - sizeof(MDLArraySlab)) / block_size_bytes)
+            return MDL_ERROR_NOMEM;
+
+        size_t slab_size = sizeof(MDLArraySlab) + (n_blocks * block_size_bytes);
+        slab = mdl_malloc(array->mds, slab_size);
+        if (slab == NULL)
             return MDL_ERROR_NOMEM;
 
-        for (size_t i = n_current_blocks; i < new_total; i++)
+        slab->next = NULL;
+        slab->size = slab_size;
+
+        // The blocks in a slab are contiguous, so the elements can be copied in as if it
+        // were one big block.
+        copy_elements_out(array, 0, array->length, (void *)(slab + 1));
+    }
+
+    free_all_slabs(array);
+    array->slabs = slab;
+
+    if (n_blocks == 0)
+    {
+        if (array->blocks != NULL)
+        {
+            mdl_free(array->mds, (void *)array->blocks,
+                     array->table_capacity * sizeof(MDLArrayBlock));
+            array->blocks = NULL;
+        }
+        array->table_capacity = 0;
+    }
+    else
+    {
+        if (array->table_capacity > n_blocks)
         {
-            MDLArrayBlock *new_block = mdl_malloc(array->mds, sizeof(MDLArrayBlock));
-            if (new_block == NULL)
+            // If shrinking the table fails, we can keep using the old one.
+            size_t old_table_size = array->table_capacity * sizeof(MDLArrayBlock);
+            MDLArrayBlock *new_table = mdl_realloc(array->mds, (void *)array->blocks,
+                                                   n_blocks * sizeof(MDLArrayBlock),
+                                                   old_table_size);
+            if (new_table != NULL)
             {
-                // Failed to allocate a new block. Free any new blocks we'd previously
-                // allocated inside this loop, as well as the resized block list. We
-                // decrement i in the initial condition because `new_block_list[i]` hasn't
-                // been set yet.
-                for (--i; i >= n_current_blocks; i--)
-                    mdl_free(array->mds, new_block_list[i], sizeof(MDLArrayBlock));
-
-                mdl_free(array->mds, new_block_list, new_total * sizeof(MDLArrayBlock *));
-                return MDL_ERROR_NOMEM;
+                array->blocks = new_table;
+                array->table_capacity = n_blocks;
             }
-
-            new_block_list[i] = new_block;
         }
+
+        // Only compute this once we know the slab exists; slab + 1 is undefined if it's
+        // NULL.
+        char *block_memory = (char *)(slab + 1);
+        for (size_t i = 0; i < n_blocks; i++, block_memory += block_size_bytes)
+            array->blocks[i] = block_memory;
     }
-    else
+
+    array->first_block = 0;
+    array->head_offset = 0;
+    array->n_allocated_blocks = n_blocks;
+    update_shrink_length(array);
+    return MDL_OK;
+}
+
+static void reclaim_unused_memory(MDLArray *array)
+{
+    // Leave enough room for the array to double in size before it needs to allocate
+    // again. Together with the threshold being under 50%, this guarantees that pushing
+    // and popping around the same length can't make us compact the array repeatedly.
+    // We also always keep at least one block so that an array going back and forth
+    // between empty and not empty doesn't hit the allocator every time.
+    size_t n_blocks = 1;
+    if (array->length <= SIZE_MAX / 2)
+        n_blocks = get_block_count_for_length(array, 2 * array->length);
+    if (n_blocks == 0)
+        n_blocks = 1;
+
+    // If this fails, the array stays the way it is, which is fine.
+    if (n_blocks < array->n_allocated_blocks)
+        (void)compact(array, n_blocks);
+}
+
+static void update_shrink_length(MDLArray *array)
+{
+    if ((array->shrink_threshold == 0) || (array->n_allocated_blocks <= 1))
     {
-        // Shrinking the array. Free blocks from the end.
-        for (size_t i = n_current_blocks - 1; i >= new_total; i--)
-            mdl_free(array->mds, array->blocks[i], sizeof(MDLArrayBlock));
+        array->shrink_length = 0;
+        return;
+    }
+
+    // Compute capacity * threshold / 100 without overflowing.
+    size_t capacity = array->n_allocated_blocks << array->block_shift;
+    array->shrink_length = (capacity / 100) * array->shrink_threshold +
+                           (capacity % 100) * array->shrink_threshold / 100;
+}
+
+static int reserve_table_slots(MDLArray *array, size_t n_front, size_t n_back)
+{
+    size_t old_capacity = array->table_capacity;
+    size_t first_block = array->first_block;
+    size_t n_current_blocks = array->n_allocated_blocks;
+
+    if ((first_block >= n_front) &&
+        (old_capacity - first_block - n_current_blocks >= n_back))
+        return MDL_OK;
+
+    if ((n_front > SIZE_MAX / sizeof(MDLArrayBlock) - n_current_blocks) ||
+        (n_back > SIZE_MAX / sizeof(MDLArrayBlock) - n_current_blocks - n_front))
+        return MDL_ERROR_NOMEM;
 
-        // Shrink the top-level block array. This shouldn't fail.
-        new_block_list =
-            mdl_realloc(array->mds, array->blocks, new_total * sizeof(MDLArrayBlock *),
-                        n_current_blocks * sizeof(MDLArrayBlock *));
+    size_t required = n_front + n_current_blocks + n_back;
+    size_t new_capacity = old_capacity;
 
-        if (new_block_list == NULL)
+    // If the table is less than half full, there's plenty of room and the blocks are just
+    // bunched up at one end. Recenter them instead of growing the table. Otherwise, grow
+    // geometrically so that adding n elements only resizes the table O(log n) times.
+    if (required > old_capacity / 2)
+    {
+        new_capacity = old_capacity * 2;
+        if (new_capacity < required)
+            new_capacity = required;
+
+        MDLArrayBlock *new_table;
+        if (array->blocks == NULL)
+            new_table = mdl_malloc(array->mds, new_capacity * sizeof(MDLArrayBlock));
+        else
+        {
+            new_table = mdl_realloc(array->mds, (void *)array->blocks,
+                                    new_capacity * sizeof(MDLArrayBlock),
+                                    old_capacity * sizeof(MDLArrayBlock));
+        }
+
+        if (new_table == NULL)
             return MDL_ERROR_NOMEM;
+
+        array->blocks = new_table;
+        array->table_capacity = new_capacity;
     }
 
-    array->blocks = new_block_list;
-    array->n_allocated_blocks = new_total;
+    // Split the free space evenly between both ends, on top of what was asked for.
+    size_t new_first_block = n_front + (new_capacity - required) / 2;
+    if (n_current_blocks > 0)
+    {
+        mdl_memmove((void *)(array->blocks + new_first_block),
+                    (void *)(array->blocks + first_block),
+                    n_current_blocks * sizeof(MDLArrayBlock));
+    }
+    array->first_block = new_first_block;
     return MDL_OK;
 }
 
-static int get_node_location_by_index(const MDLArray *array, int index,
-                                      MDLArrayBlock **block, size_t *offset)
+static int resolve_index(const MDLArray *array, int index, size_t *absolute_index)
 {
-    size_t absolute_index;
-
     if (index >= 0)
-        absolute_index = (size_t)index;
+        *absolute_index = (size_t)index;
     else
-        absolute_index = array->length - ((size_t)-index);
+        *absolute_index = array->length - ((size_t)-index);
 
-    if (absolute_index >= array->length)
+    if (*absolute_index >= array->length)
         return MDL_ERROR_OUT_OF_RANGE;
+    return MDL_OK;
+}
 
-    size_t block_number = absolute_index / MDL_DEFAULT_ARRAY_BLOCK_SIZE;
+static size_t get_block_size_bytes(const MDLArray *array)
+{
+    return array->block_size * array->elem_size;
+}
 
-    *block = array->blocks[block_number];
-    *offset = absolute_index % MDL_DEFAULT_ARRAY_BLOCK_SIZE;
-    return 0;
+static size_t get_block_count_for_length(const MDLArray *array, size_t length)
+{
+    size_t n_blocks = length >> array->block_shift;
+    if ((length & (array->block_size - 1)) != 0)
+        n_blocks++;
+    return n_blocks;
+}
+
+static void *get_element_slot(const MDLArray *array, size_t index)
+{
+    size_t position = array->head_offset + index;
+    size_t block_index = array->first_block + (position >> array->block_shift);
+    MDLArrayBlock block = array->blocks[block_index];
+    return block + ((position & (array->block_size - 1)) * array->elem_size);
+}
+
+static void **get_pointer_slot(const MDLArray *array, size_t index)
+{
+    return (void **)get_element_slot(array, index);
+}
+
+static void *get_element_value(const MDLArray *array, const void *slot)
+{
+    // Callbacks get a pointer to inline values, and the values themselves for arrays of
+    // pointers.
+    if (array->inline_values)
+        return (void *)slot;
+    return *(void *const *)slot;
+}
+
+static size_t get_comparator_size(const MDLArray *array)
+{
+    return array->inline_values ? array->elem_size : 0;
+}
+
+static void destroy_element(const MDLArray *array, void *slot)
+{
+    if (array->elem_destructor != NULL)
+        array->elem_destructor(array->mds, get_element_value(array, slot));
+}
+
+static size_t get_contiguous_run_length(const MDLArray *array, size_t index)
+{
+    return array->block_size - ((array->head_offset + index) & (array->block_size - 1));
+}
+
+static void move_elements(MDLArray *array, size_t dest_index, size_t src_index,
+                          size_t count)
+{
+    if (dest_index < src_index)
+    {
+        // Moving toward the front. Go forward so that nothing is overwritten before it's
+        // been moved.
+        while (count > 0)
+        {
+            size_t run_length = get_contiguous_run_length(array, src_index);
+            size_t dest_run_length = get_contiguous_run_length(array, dest_index);
+
+            if (run_length > dest_run_length)
+                run_length = dest_run_length;
+            if (run_length > count)
+                run_length = count;
+
+            mdl_memmove(get_element_slot(array, dest_index),
+                        get_element_slot(array, src_index),
+                        run_length * array->elem_size);
+            dest_index += run_length;
+            src_index += run_length;
+            count -= run_length;
+        }
+    }
+    else if (dest_index > src_index)
+    {
+        // Moving toward the back, so go backward. The run lengths here are measured from
+        // the beginning of the block to the last element being moved.
+        size_t mask = array->block_size - 1;
+
+        while (count > 0)
+        {
+            size_t src_last = src_index + count - 1;
+            size_t dest_last = dest_index + count - 1;
+            size_t run_length = ((array->head_offset + src_last) & mask) + 1;
+            size_t dest_run_length = ((array->head_offset + dest_last) & mask) + 1;
+
+            if (run_length > dest_run_length)
+                run_length = dest_run_length;
+            if (run_length > count)
+                run_length = count;
+
+            count -= run_length;
+            mdl_memmove(get_element_slot(array, dest_index + count),
+                        get_element_slot(array, src_index + count),
+                        run_length * array->elem_size);
+        }
+    }
+}
+
+static void copy_elements_out(const MDLArray *array, size_t start, size_t count,
+                              void *dest)
+{
+    char *dest_bytes = dest;
+
+    // One memcpy per block instead of looking up every element individually.
+    while (count > 0)
+    {
+        size_t run_length = get_contiguous_run_length(array, start);
+        if (run_length > count)
+            run_length = count;
+
+        size_t run_size = run_length * array->elem_size;
+        mdl_memcpy(dest_bytes, get_element_slot(array, start), run_size);
+        dest_bytes += run_size;
+        start += run_length;
+        count -= run_length;
+    }
+}
+
+static int insert_element(MDLArray *array, size_t index)
+{
+    int error;
+
+    // Shift whichever side of the insertion point is shorter to make room.
+    if (index < array->length - index)
+    {
+        error = grow_for_prepend(array);
+        if (error != MDL_OK)
+            return error;
+
+        // Moving the head back by one shifts every element's index up by one. Move the
+        // elements before the insertion point back down to fill the gap.
+        array->head_offset--;
+        array->length++;
+        move_elements(array, 0, 1, index);
+    }
+    else
+    {
+        error = grow_for_append(array, 1, array->n_allocated_blocks / 2);
+        if (error != MDL_OK)
+            return error;
+
+        array->length++;
+        move_elements(array, index + 1, index, array->length - index - 1);
+    }
+    return MDL_OK;
+}
+
+static void remove_element(MDLArray *array, size_t index)
+{
+    // Close the gap by shifting whichever side of the removed element is shorter.
+    size_t n_after = array->length - index - 1;
+    if (index < n_after)
+    {
+        move_elements(array, 1, 0, index);
+        array->head_offset++;
+    }
+    else
+        move_elements(array, index, index + 1, n_after);
+
+    array->length--;
+    if (array->length < array->shrink_length)
+        reclaim_unused_memory(array);
+}
+
+static size_t find_value(const MDLArray *array, const void *value, bool reverse,
+                         mdl_comparator_fptr cmp)
+{
+    if (!reverse)
+    {
+        size_t start = 0;
+        while (start < array->length)
+        {
+            size_t run_length = get_contiguous_run_length(array, start);
+            if (run_length > array->length - start)
+                run_length = array->length - start;
+
+            size_t run_index = search_run(array, get_element_slot(array, start),
+                                          run_length, value, cmp, false);
+            if (run_index != MDL_INVALID_INDEX)
+                return start + run_index;
+            start += run_length;
+        }
+    }
+    else
+    {
+        size_t end = array->length;
+        while (end > 0)
+        {
+            // The run goes from the beginning of the block to the last element we haven't
+            // searched yet.
+            size_t run_length =
+                ((array->head_offset + end - 1) & (array->block_size - 1)) + 1;
+            if (run_length > end)
+                run_length = end;
+
+            size_t start = end - run_length;
+            size_t run_index = search_run(array, get_element_slot(array, start),
+                                          run_length, value, cmp, true);
+            if (run_index != MDL_INVALID_INDEX)
+                return start + run_index;
+            end = start;
+        }
+    }
+    return MDL_INVALID_INDEX;
+}
+
+static size_t search_run(const MDLArray *array, const char *run, size_t run_length,
+                         const void *value, mdl_comparator_fptr cmp, bool reverse)
+{
+    // Comparing pointer values is by far the most common case. Don't make an indirect
+    // function call for every element if we don't have to.
+    if (!array->inline_values && (cmp == mdl_default_ptr_value_comparator))
+    {
+        return search_run_for_pointer((void *const *)(const void *)run, run_length, value,
+                                      reverse);
+    }
+
+    size_t elem_size = array->elem_size;
+    size_t cmp_size = get_comparator_size(array);
+
+    if (!reverse)
+    {
+        for (size_t i = 0; i < run_length; i++)
+        {
+            void *element = get_element_value(array, run + (i * elem_size));
+            if (cmp(array->mds, element, value, cmp_size) == 0)
+                return i;
+        }
+    }
+    else
+    {
+        for (size_t i = run_length; i > 0; i--)
+        {
+            void *element = get_element_value(array, run + ((i - 1) * elem_size));
+            if (cmp(array->mds, element, value, cmp_size) == 0)
+                return i - 1;
+        }
+    }
+    return MDL_INVALID_INDEX;
+}
+
+static size_t search_run_for_pointer(void *const *run, size_t run_length,
+                                     const void *value, bool reverse)
+{
+    // Check the entire run for a match before figuring out where it is. This loop has no
+    // early exit so the compiler can vectorize it, and most runs won't have a match.
+    bool found = false;
+    for (size_t i = 0; i < run_length; i++)
+        found |= (run[i] == value);
+
+    if (!found)
+        return MDL_INVALID_INDEX;
+
+    if (!reverse)
+    {
+        for (size_t i = 0; i < run_length; i++)
+        {
+            if (run[i] == value)
+                return i;
+        }
+    }
+    else
+    {
+        for (size_t i = run_length; i > 0; i--)
+        {
+            if (run[i - 1] == value)
+                return i - 1;
+        }
+    }
+    return MDL_INVALID_INDEX;
+}
+
+static int compare_elements(const MDLArray *array, size_t first, size_t second,
+                            mdl_comparator_fptr cmp)
+{
+    return cmp(array->mds, get_element_value(array, get_element_slot(array, first)),
+               get_element_value(array, get_element_slot(array, second)),
+               get_comparator_size(array));
+}
+
+static void swap_elements(MDLArray *array, size_t first, size_t second)
+{
+    if (!array->inline_values)
+    {
+        void **first_slot = get_pointer_slot(array, first);
+        void **second_slot = get_pointer_slot(array, second);
+        void *temp = *first_slot;
+
+        *first_slot = *second_slot;
+        *second_slot = temp;
+        return;
+    }
+
+    // Inline values can be any size, so swap them one byte at a time rather than needing
+    // a temporary buffer.
+    char *first_bytes = get_element_slot(array, first);
+    char *second_bytes = get_element_slot(array, second);
+    for (size_t i = 0; i < array->elem_size; i++)
+    {
+        char temp = first_bytes[i];
+        first_bytes[i] = second_bytes[i];
+        second_bytes[i] = temp;
+    }
+}
+
+static size_t partition(MDLArray *array, size_t start, size_t end,
+                        mdl_comparator_fptr cmp)
+{
+    size_t last = end - 1;
+    size_t pivot = start + (last - start) / 2;
+
+    // Use the median of the first, middle, and last elements as the pivot. This avoids
+    // the quadratic worst case for arrays that are already sorted or reverse sorted.
+    if (compare_elements(array, pivot, start, cmp) < 0)
+        swap_elements(array, pivot, start);
+    if (compare_elements(array, last, pivot, cmp) < 0)
+    {
+        swap_elements(array, last, pivot);
+        if (compare_elements(array, pivot, start, cmp) < 0)
+            swap_elements(array, pivot, start);
+    }
+
+    // Hoare partitioning. Afterward, everything in [start, j] is less than or equal to
+    // the pivot, and everything in [j + 1, end) is greater than or equal to it. Inline
+    // values can't be copied out without a buffer, so instead of holding onto the pivot's
+    // value we follow it around when it gets swapped.
+    size_t i = start;
+    size_t j = last;
+
+    while (true)
+    {
+        while (compare_elements(array, i, pivot, cmp) < 0)
+            i++;
+        while (compare_elements(array, j, pivot, cmp) > 0)
+            j--;
+        if (i >= j)
+            return j + 1;
+
+        swap_elements(array, i, j);
+        if (pivot == i)
+            pivot = j;
+        else if (pivot == j)
+            pivot = i;
+        i++;
+        j--;
+    }
+}
+
+static void insertion_sort(MDLArray *array, size_t start, size_t end,
+                           mdl_comparator_fptr cmp)
+{
+    for (size_t i = start + 1; i < end; i++)
+    {
+        size_t j = i;
+        while ((j > start) && (compare_elements(array, j - 1, j, cmp) > 0))
+        {
+            swap_elements(array, j - 1, j);
+            j--;
+        }
+    }
+}
+
+static void heap_sort(MDLArray *array, size_t start, size_t end, mdl_comparator_fptr cmp)
+{
+    size_t n_elements = end - start;
+
+    for (size_t i = n_elements / 2; i > 0; i--)
+        sift_down(array, start, i - 1, n_elements, cmp);
+
+    for (size_t heap_size = n_elements - 1; heap_size > 0; heap_size--)
+    {
+        swap_elements(array, start, start + heap_size);
+        sift_down(array, start, 0, heap_size, cmp);
+    }
+}
+
+static void sift_down(MDLArray *array, size_t start, size_t root, size_t heap_size,
+                      mdl_comparator_fptr cmp)
+{
+    while (2 * root + 1 < heap_size)
+    {
+        size_t child = 2 * root + 1;
+
+        if ((child + 1 < heap_size) &&
+            (compare_elements(array, start + child + 1, start + child, cmp) > 0))
+            child++;
+
+        if (compare_elements(array, start + root, start + child, cmp) >= 0)
+            return;
+
+        swap_elements(array, start + root, start + child);
+        root = child;
+    }
 }
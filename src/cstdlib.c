@@ -30,6 +30,25 @@ void *mdl_memcpy(void *restrict dest, const void *restrict src, size_t size)
 }
 #endif
 
+#if MDL_LIBC_NEED_CUSTOM_MEMMOVE && !MDL_LIBC_HAVE_BUILTIN_MEMMOVE
+void *mdl_memmove(void *dest, const void *src, size_t size)
+{
+    // Copy back to front if the destination is after the source, so that we don't
+    // overwrite bytes we haven't copied yet.
+    if ((const char *)dest > (const char *)src)
+    {
+        for (size_t i = size; i > 0; i--)
+            ((char *)dest)[i - 1] = ((const char *)src)[i - 1];
+    }
+    else
+    {
+        for (size_t i = 0; i < size; i++)
+            ((char *)dest)[i] = ((const char *)src)[i];
+    }
+    return dest;
+}
+#endif
+
 #if MDL_LIBC_NEED_CUSTOM_MEMSET && !MDL_LIBC_HAVE_BUILTIN_MEMSET
 void *mdl_memset(void *restrict ptr, int value, size_t size)
 {
@@ -0,0 +1,176 @@
+// SPDX-License-Identifier: MPL-2.0+
+// Copyright (C) 2020-2025  Diego Argueta
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "metaldata/intrusivelist.h"
+#include "metaldata/errors.h"
+#include "metaldata/internal/circularlist.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+MDL_ANNOTN__NONNULL
+static void link_only(MDLIntrusiveList *list, MDLIntrusiveLink *link);
+
+void mdl_intrusivelist_init(MDLIntrusiveList *list)
+{
+    list->head = NULL;
+    list->length = 0;
+}
+
+void mdl_intrusivelink_init(MDLIntrusiveLink *link)
+{
+    link->prev = NULL;
+    link->next = NULL;
+}
+
+bool mdl_intrusivelink_islinked(const MDLIntrusiveLink *link)
+{
+    return link->next != NULL;
+}
+
+size_t mdl_intrusivelist_length(const MDLIntrusiveList *list)
+{
+    return list->length;
+}
+
+MDLIntrusiveLink *mdl_intrusivelist_head(const MDLIntrusiveList *list)
+{
+    return list->head;
+}
+
+MDLIntrusiveLink *mdl_intrusivelist_tail(const MDLIntrusiveList *list)
+{
+    if (list->head == NULL)
+        return NULL;
+    return list->head->prev;
+}
+
+MDLIntrusiveLink *mdl_intrusivelist_next(const MDLIntrusiveList *list,
+                                         const MDLIntrusiveLink *link)
+{
+    if (link->next == list->head)
+        return NULL;
+    return link->next;
+}
+
+MDLIntrusiveLink *mdl_intrusivelist_prev(const MDLIntrusiveList *list,
+                                         const MDLIntrusiveLink *link)
+{
+    if (link == list->head)
+        return NULL;
+    return link->prev;
+}
+
+int mdl_intrusivelist_push(MDLIntrusiveList *list, MDLIntrusiveLink *link)
+{
+    if (mdl_intrusivelink_islinked(link))
+        return MDL_ERROR_ALREADY_EXISTS;
+
+    if (list->head == NULL)
+        link_only(list, link);
+    else
+    {
+        MDL_CIRCULARLIST_LINKAFTER(link, list->head->prev);
+        list->length++;
+    }
+    return MDL_OK;
+}
+
+int mdl_intrusivelist_pushfront(MDLIntrusiveList *list, MDLIntrusiveLink *link)
+{
+    /* Same as for MDLMemBlkList: append to the back of the circle, then move the head
+     * back to point to it. */
+    int result = mdl_intrusivelist_push(list, link);
+    if (result == MDL_OK)
+        list->head = link;
+    return result;
+}
+
+int mdl_intrusivelist_insertafter(MDLIntrusiveList *list, MDLIntrusiveLink *existing,
+                                  MDLIntrusiveLink *link)
+{
+    if (mdl_intrusivelink_islinked(link))
+        return MDL_ERROR_ALREADY_EXISTS;
+
+    MDL_CIRCULARLIST_LINKAFTER(link, existing);
+    list->length++;
+    return MDL_OK;
+}
+
+int mdl_intrusivelist_insertbefore(MDLIntrusiveList *list, MDLIntrusiveLink *existing,
+                                   MDLIntrusiveLink *link)
+{
+    if (mdl_intrusivelink_islinked(link))
+        return MDL_ERROR_ALREADY_EXISTS;
+
+    MDL_CIRCULARLIST_LINKAFTER(link, existing->prev);
+    if (existing == list->head)
+        list->head = link;
+    list->length++;
+    return MDL_OK;
+}
+
+MDLIntrusiveLink *mdl_intrusivelist_pop(MDLIntrusiveList *list)
+{
+    MDLIntrusiveLink *tail = mdl_intrusivelist_tail(list);
+    if (tail != NULL)
+        mdl_intrusivelist_remove(list, tail);
+    return tail;
+}
+
+MDLIntrusiveLink *mdl_intrusivelist_popfront(MDLIntrusiveList *list)
+{
+    MDLIntrusiveLink *head = list->head;
+    if (head != NULL)
+        mdl_intrusivelist_remove(list, head);
+    return head;
+}
+
+int mdl_intrusivelist_remove(MDLIntrusiveList *list, MDLIntrusiveLink *link)
+{
+    if (!mdl_intrusivelink_islinked(link))
+        return MDL_ERROR_NOT_FOUND;
+
+    if (list->length == 1)
+        list->head = NULL;
+    else
+    {
+        if (link == list->head)
+            list->head = link->next;
+        MDL_CIRCULARLIST_UNLINK(link);
+    }
+
+    list->length--;
+    mdl_intrusivelink_init(link);
+    return MDL_OK;
+}
+
+void mdl_intrusivelist_clear(MDLIntrusiveList *list)
+{
+    MDLIntrusiveLink *link = list->head;
+    for (size_t i = 0; i < list->length; i++)
+    {
+        MDLIntrusiveLink *next = link->next;
+        mdl_intrusivelink_init(link);
+        link = next;
+    }
+
+    list->head = NULL;
+    list->length = 0;
+}
+
+/******** Helper functions ********/
+
+/**
+ * Make @a link the only one in the (empty) list.
+ */
+static void link_only(MDLIntrusiveList *list, MDLIntrusiveLink *link)
+{
+    link->prev = link;
+    link->next = link;
+    list->head = link;
+    list->length = 1;
+}
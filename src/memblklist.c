@@ -7,28 +7,91 @@
 
 #include "metaldata/internal/memblklist.h"
 #include "metaldata/errors.h"
+#include "metaldata/internal/circularlist.h"
 #include "metaldata/internal/cstdlib.h"
 #include "metaldata/memblklist.h"
 #include "metaldata/metaldata.h"
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
+
+/**
+ * A type with the strictest alignment requirement we need to care about. Nodes carved out
+ * of a slab are padded to a multiple of its size so that every node is aligned as well as
+ * one returned by @ref mdl_malloc would be.
+ */
+typedef union
+{
+    long double f;
+    mdl_scalar_type i;
+    void *p;
+    void (*fp)(void);
+} MaxAlignType;
 
 MDL_ANNOTN__NONNULL
 static void unlink_node(MDLMemBlkListNode *node);
 
 MDL_ANNOTN__NONNULL
-static void unlink_and_free_node(MDLMemBlkList *list, MDLMemBlkListNode *node);
+static void remove_node(MDLMemBlkList *list, MDLMemBlkListNode *node, size_t index);
+
+MDL_ANNOTN__NONNULL_ARGS(1)
+static MDLMemBlkListNode *insert_new_node(MDLMemBlkList *list, MDLMemBlkListNode *prev,
+                                          size_t index);
+
+MDL_ANNOTN__NONNULL
+static MDLMemBlkListNode *acquire_node(MDLMemBlkList *list);
+
+MDL_ANNOTN__NONNULL
+static void release_node(MDLMemBlkList *list, MDLMemBlkListNode *node);
 
 MDL_ANNOTN__NONNULL
-static void unlink_and_maybe_free_node(MDLMemBlkList *list, MDLMemBlkListNode *node);
+static int allocate_slab(MDLMemBlkList *list, size_t n_nodes);
 
 MDL_ANNOTN__NONNULL
-static MDLMemBlkListNode *get_node_at_abs_index(const MDLMemBlkList *list, size_t index);
+static int acquire_chain(MDLMemBlkList *list, size_t count, const void *items,
+                         MDLMemBlkListNode **first, MDLMemBlkListNode **last);
+
+MDL_ANNOTN__NONNULL
+static void free_all_slabs(MDLMemBlkList *list);
+
+MDL_ANNOTN__REPRODUCIBLE
+static size_t round_up_to_alignment(size_t size);
+
+MDL_ANNOTN__NONNULL
+static MDLMemBlkListNode *find_node_at_abs_index(const MDLMemBlkList *list,
+                                                 size_t index);
+static MDLMemBlkListNode *get_node_at_abs_index(MDLMemBlkList *list, size_t index);
 
 MDL_ANNOTN__NONNULL
 MDL_ANNOTN__REPRODUCIBLE
 static size_t get_node_size(const MDLMemBlkList *list);
 
+MDL_ANNOTN__NONNULL
+static int check_can_move_nodes(const MDLMemBlkList *dest, const MDLMemBlkList *src);
+
+MDL_ANNOTN__NONNULL
+static size_t get_iterator_index(const MDLMemBlkList *list,
+                                 const MDLMemBlkListIterator *iter);
+
+MDL_ANNOTN__NONNULL_ARGS(1, 2)
+static bool matches_value(MDLState *mds, const void *item, size_t size, void *udata);
+
+MDL_ANNOTN__NONNULL
+static void move_nodes(MDLMemBlkList *dest, MDLMemBlkList *src, MDLMemBlkListNode *first,
+                       MDLMemBlkListNode *last, size_t first_index, size_t count);
+
+MDL_ANNOTN__NONNULL
+static void detach_run(MDLMemBlkList *list, MDLMemBlkListNode *first,
+                       MDLMemBlkListNode *last, size_t first_index, size_t count);
+
+MDL_ANNOTN__NONNULL
+static void append_chain(MDLMemBlkList *list, MDLMemBlkListNode *first,
+                         MDLMemBlkListNode *last, size_t count);
+
+MDL_ANNOTN__NONNULL_ARGS(1)
+static void release_run(MDLMemBlkList *list, MDLMemBlkListNode *first, size_t count,
+                        void *buf);
+
 void mdl_memblklist_init(MDLState *mds, MDLMemBlkList *list, size_t elem_size)
 {
     list->was_allocated = false;
@@ -36,6 +99,13 @@ void mdl_memblklist_init(MDLState *mds, MDLMemBlkList *list, size_t elem_size)
     list->length = 0;
     list->elem_size = elem_size;
     list->head = NULL;
+    list->cursor_node = NULL;
+    list->cursor_index = 0;
+    list->free_nodes = NULL;
+    list->n_free_nodes = 0;
+    list->max_free_nodes = 0;
+    list->nodes_per_slab = 0;
+    list->slabs = NULL;
 }
 
 MDLMemBlkList *mdl_memblklist_new(MDLState *mds, size_t elem_size)
@@ -49,6 +119,20 @@ MDLMemBlkList *mdl_memblklist_new(MDLState *mds, size_t elem_size)
     return list;
 }
 
+int mdl_memblklist_setnodecache(MDLMemBlkList *list, size_t max_free_nodes,
+                                size_t nodes_per_slab)
+{
+    if (list->length != 0)
+        return MDL_ERROR_NOT_SUPPORTED;
+
+    // Cached nodes may have been allocated differently than the new settings would, so
+    // get rid of them first.
+    mdl_memblklist_clear(list);
+    list->max_free_nodes = max_free_nodes;
+    list->nodes_per_slab = nodes_per_slab;
+    return MDL_OK;
+}
+
 int mdl_memblklist_destroy(MDLMemBlkList *list)
 {
     mdl_memblklist_clear(list);
@@ -103,8 +187,7 @@ int mdl_memblklist_pop(MDLMemBlkList *list)
     if (list->length == 0)
         return MDL_ERROR_EMPTY;
 
-    unlink_and_free_node(list, list->head->prev);
-    list->length--;
+    remove_node(list, list->head->prev, list->length - 1);
     return MDL_OK;
 }
 
@@ -113,9 +196,9 @@ int mdl_memblklist_popcopy(MDLMemBlkList *list, void *buf)
     if (list->length == 0)
         return MDL_ERROR_EMPTY;
 
-    MDLMemBlkListNode *tail = mdl_memblklist_tail(list);
+    MDLMemBlkListNode *tail = list->head->prev;
     mdl_memcpy(buf, tail->data, list->elem_size);
-    unlink_and_maybe_free_node(list, tail);
+    remove_node(list, tail, list->length - 1);
     return MDL_OK;
 }
 
@@ -139,7 +222,10 @@ void *mdl_memblklist_pushfront(MDLMemBlkList *list)
      * list by appending it to the back and moving the head back to point to it. */
     void *new_buffer = mdl_memblklist_push(list);
     if (new_buffer != NULL)
+    {
         list->head = list->head->prev;
+        list->cursor_index++;
+    }
     return new_buffer;
 }
 
@@ -148,10 +234,7 @@ int mdl_memblklist_popfront(MDLMemBlkList *list)
     if (list->length == 0)
         return MDL_ERROR_EMPTY;
 
-    MDLMemBlkListNode *next_head = list->head->next;
-    unlink_and_free_node(list, list->head);
-    list->head = next_head;
-    list->length--;
+    remove_node(list, list->head, 0);
     return 0;
 }
 
@@ -164,12 +247,85 @@ int mdl_memblklist_popfrontcopy(MDLMemBlkList *list, void *buf)
     return mdl_memblklist_popfront(list);
 }
 
+int mdl_memblklist_pushmany(MDLMemBlkList *list, const void *items, size_t count)
+{
+    if (count == 0)
+        return MDL_OK;
+
+    MDLMemBlkListNode *first;
+    MDLMemBlkListNode *last;
+    if (acquire_chain(list, count, items, &first, &last) != MDL_OK)
+        return MDL_ERROR_NOMEM;
+
+    append_chain(list, first, last, count);
+    return MDL_OK;
+}
+
+int mdl_memblklist_pushfrontmany(MDLMemBlkList *list, const void *items, size_t count)
+{
+    if (count == 0)
+        return MDL_OK;
+
+    MDLMemBlkListNode *first;
+    MDLMemBlkListNode *last;
+    if (acquire_chain(list, count, items, &first, &last) != MDL_OK)
+        return MDL_ERROR_NOMEM;
+
+    // Like pushfront, append and then move the head back.
+    append_chain(list, first, last, count);
+    list->head = first;
+    list->cursor_index += count;
+    return MDL_OK;
+}
+
+int mdl_memblklist_popmany(MDLMemBlkList *list, void *buf, size_t count)
+{
+    if (count > list->length)
+        return MDL_ERROR_OUT_OF_RANGE;
+    if (count == 0)
+        return MDL_OK;
+
+    MDLMemBlkListNode *last = list->head->prev;
+    MDLMemBlkListNode *first = last;
+    for (size_t i = 1; i < count; i++)
+        first = first->prev;
+
+    detach_run(list, first, last, list->length - count, count);
+    release_run(list, first, count, buf);
+    return MDL_OK;
+}
+
+int mdl_memblklist_popfrontmany(MDLMemBlkList *list, void *buf, size_t count)
+{
+    if (count > list->length)
+        return MDL_ERROR_OUT_OF_RANGE;
+    if (count == 0)
+        return MDL_OK;
+
+    MDLMemBlkListNode *first = list->head;
+    MDLMemBlkListNode *last = first;
+    for (size_t i = 1; i < count; i++)
+        last = last->next;
+
+    detach_run(list, first, last, 0, count);
+    release_run(list, first, count, buf);
+    return MDL_OK;
+}
+
 void *mdl_memblklist_getblockat(const MDLMemBlkList *list, size_t index)
 {
-    const MDLMemBlkListNode *node = get_node_at_abs_index(list, index);
+    MDLMemBlkListNode *node = find_node_at_abs_index(list, index);
+    if (node == NULL)
+        return NULL;
+    return node->data;
+}
+
+void *mdl_memblklist_getblockatcached(MDLMemBlkList *list, size_t index)
+{
+    MDLMemBlkListNode *node = get_node_at_abs_index(list, index);
     if (node == NULL)
         return NULL;
-    return (void *)node->data;
+    return node->data;
 }
 
 int mdl_memblklist_set(MDLMemBlkList *list, size_t index, const void *src)
@@ -182,13 +338,39 @@ int mdl_memblklist_set(MDLMemBlkList *list, size_t index, const void *src)
     return 0;
 }
 
+int mdl_memblklist_insertafter(MDLMemBlkList *list, size_t index, void **ptr)
+{
+    MDLMemBlkListNode *node = get_node_at_abs_index(list, index);
+    if (node == NULL)
+        return MDL_ERROR_OUT_OF_RANGE;
+
+    MDLMemBlkListNode *new_node = insert_new_node(list, node, index + 1);
+    if (new_node == NULL)
+        return MDL_ERROR_NOMEM;
+
+    if (ptr != NULL)
+        *ptr = new_node->data;
+    return MDL_OK;
+}
+
+int mdl_memblklist_insertaftercopy(MDLMemBlkList *list, size_t index, const void *buf)
+{
+    void *block;
+    int result = mdl_memblklist_insertafter(list, index, &block);
+    if (result != MDL_OK)
+        return result;
+
+    mdl_memcpy(block, buf, list->elem_size);
+    return MDL_OK;
+}
+
 int mdl_memblklist_removeat(MDLMemBlkList *list, size_t index)
 {
     MDLMemBlkListNode *node = get_node_at_abs_index(list, index);
     if (node == NULL)
         return MDL_ERROR_OUT_OF_RANGE;
 
-    unlink_and_free_node(list, node);
+    remove_node(list, node, index);
     return 0;
 }
 
@@ -199,22 +381,39 @@ int mdl_memblklist_removeatcopy(MDLMemBlkList *list, size_t index, void *buf)
         return MDL_ERROR_OUT_OF_RANGE;
 
     mdl_memcpy(buf, node->data, list->elem_size);
-    unlink_and_free_node(list, node);
+    remove_node(list, node, index);
     return 0;
 }
 
 void mdl_memblklist_clear(MDLMemBlkList *list)
 {
-    MDLMemBlkListNode *current_node = list->head;
-    size_t node_size = get_node_size(list);
-
-    for (size_t i = 0; i < list->length; i++)
+    // Nodes carved out of slabs are freed all at once with their slabs, so only nodes
+    // allocated individually need to be freed one by one.
+    if (list->nodes_per_slab == 0)
     {
-        MDLMemBlkListNode *next_node = current_node->next;
-        mdl_free(list->mds, current_node, node_size);
-        current_node = next_node;
+        MDLMemBlkListNode *current_node = list->head;
+        size_t node_size = get_node_size(list);
+
+        for (size_t i = 0; i < list->length; i++)
+        {
+            MDLMemBlkListNode *next_node = current_node->next;
+            mdl_free(list->mds, current_node, node_size);
+            current_node = next_node;
+        }
+
+        current_node = list->free_nodes;
+        while (current_node != NULL)
+        {
+            MDLMemBlkListNode *next_node = current_node->next;
+            mdl_free(list->mds, current_node, node_size);
+            current_node = next_node;
+        }
     }
 
+    free_all_slabs(list);
+    list->cursor_node = NULL;
+    list->free_nodes = NULL;
+    list->n_free_nodes = 0;
     list->head = NULL;
     list->length = 0;
 }
@@ -281,22 +480,195 @@ int mdl_memblklist_rotate(MDLMemBlkList *list, long places)
     if (list->length == 0)
         return MDL_ERROR_EMPTY;
 
-    if (places > 0)
+    // Reduce `places` to the equivalent number of places to rotate toward higher indexes,
+    // in the range [0, length). We negate negative numbers in two steps to avoid overflow
+    // if `places` is LONG_MIN.
+    size_t shift;
+    if (places >= 0)
+        shift = (size_t)places % list->length;
+    else
     {
-        /* Rotate to the right; the head moves to higher indexes. */
-        for (; places > 0; places--)
-            list->head = list->head->next;
+        size_t magnitude = ((size_t)(-(places + 1)) + 1) % list->length;
+        shift = (list->length - magnitude) % list->length;
     }
-    else
+
+    if (shift == 0)
+        return MDL_OK;
+
+    // The element that ends up at index 0 is the one currently `shift` places from the
+    // end. Looking it up walks from whichever of the head, tail, or cursor is closest, so
+    // this takes at most min(shift, length - shift) steps, and rotating by one place is
+    // always O(1).
+    size_t new_head_index = list->length - shift;
+    list->head = get_node_at_abs_index(list, new_head_index);
+
+    // The lookup left the cursor on the node that just became the head, so the cursor
+    // stays valid as long as we fix its index.
+    list->cursor_index = 0;
+    return MDL_OK;
+}
+
+int mdl_memblklist_concat(MDLMemBlkList *dest, MDLMemBlkList *src)
+{
+    int result = check_can_move_nodes(dest, src);
+    if (result != MDL_OK)
+        return result;
+
+    if (src->length == 0)
+        return MDL_OK;
+
+    move_nodes(dest, src, src->head, src->head->prev, 0, src->length);
+    return MDL_OK;
+}
+
+int mdl_memblklist_split(MDLMemBlkList *list, const MDLMemBlkListIterator *at,
+                         MDLMemBlkList *dest)
+{
+    int result = check_can_move_nodes(dest, list);
+    if (result != MDL_OK)
+        return result;
+
+    size_t first_index = get_iterator_index(list, at);
+    if (first_index == MDL_INVALID_INDEX)
+        return MDL_ERROR_INVALID_ARGUMENT;
+
+    move_nodes(dest, list, at->current, list->head->prev, first_index,
+               list->length - first_index);
+    return MDL_OK;
+}
+
+int mdl_memblklist_splice(MDLMemBlkList *dest, MDLMemBlkList *src,
+                          const MDLMemBlkListIterator *first,
+                          const MDLMemBlkListIterator *last)
+{
+    int result = check_can_move_nodes(dest, src);
+    if (result != MDL_OK)
+        return result;
+
+    size_t first_index = get_iterator_index(src, first);
+    size_t last_index = get_iterator_index(src, last);
+    if ((first_index == MDL_INVALID_INDEX) || (last_index == MDL_INVALID_INDEX) ||
+        (first_index > last_index))
+        return MDL_ERROR_INVALID_ARGUMENT;
+
+    move_nodes(dest, src, first->current, last->current, first_index,
+               last_index - first_index + 1);
+    return MDL_OK;
+}
+
+int mdl_memblklist_sort(MDLMemBlkList *list, mdl_comparator_fptr cmp)
+{
+    if (list->length < 2)
+        return MDL_OK;
+
+    // Break the circle so we can work with a null-terminated singly-linked list. The
+    // `prev` pointers are ignored until the end, when we fix them all up in one pass.
+    MDLMemBlkListNode *sorted = list->head;
+    sorted->prev->next = NULL;
+
+    // Bottom-up merge sort: merge adjacent runs of length 1, then 2, 4, and so on, until
+    // a single pass only needs one merge. This needs no recursion or temporary storage.
+    size_t run_length = 1;
+    size_t n_merges;
+    do
     {
-        /* Rotate to the left; the head moves to the end, then to lower indexes from
-         * there. */
-        for (; places < 0; places++)
-            list->head = list->head->prev;
+        MDLMemBlkListNode *left = sorted;
+        MDLMemBlkListNode *tail = NULL;
+        n_merges = 0;
+        sorted = NULL;
+
+        while (left != NULL)
+        {
+            MDLMemBlkListNode *right = left;
+            size_t left_length = 0;
+            size_t right_length = run_length;
+
+            n_merges++;
+            while ((left_length < run_length) && (right != NULL))
+            {
+                left_length++;
+                right = right->next;
+            }
+
+            while ((left_length > 0) || ((right_length > 0) && (right != NULL)))
+            {
+                MDLMemBlkListNode *next;
+
+                // Taking from the left run when the two are equal keeps the sort stable.
+                if ((left_length == 0) ||
+                    ((right_length > 0) && (right != NULL) &&
+                     (cmp(list->mds, left->data, right->data, list->elem_size) > 0)))
+                {
+                    next = right;
+                    right = right->next;
+                    right_length--;
+                }
+                else
+                {
+                    next = left;
+                    left = left->next;
+                    left_length--;
+                }
+
+                if (tail == NULL)
+                    sorted = next;
+                else
+                    tail->next = next;
+                tail = next;
+            }
+            left = right;
+        }
+
+        tail->next = NULL;
+        run_length *= 2;
+    } while (n_merges > 1);
+
+    // Restore the `prev` pointers and close the circle again.
+    MDLMemBlkListNode *prev = sorted;
+    for (MDLMemBlkListNode *node = sorted->next; node != NULL; node = node->next)
+    {
+        node->prev = prev;
+        prev = node;
     }
+    prev->next = sorted;
+    sorted->prev = prev;
+
+    list->head = sorted;
+    list->cursor_node = NULL;
     return MDL_OK;
 }
 
+void *mdl_memblklist_insertsorted(MDLMemBlkList *list, const void *value,
+                                  mdl_comparator_fptr cmp)
+{
+    // Search backward from the tail for the last element that doesn't compare greater
+    // than the new value. This puts the new element after any equal ones so insertion
+    // order is preserved, and makes the common case of inserting values in mostly
+    // increasing order (e.g. timer deadlines) fast.
+    MDLMemBlkListNode *prev = NULL;
+    size_t index = list->length;
+
+    if (list->head != NULL)
+    {
+        MDLMemBlkListNode *node = list->head->prev;
+        for (; index > 0; index--, node = node->prev)
+        {
+            if (cmp(list->mds, node->data, value, list->elem_size) <= 0)
+            {
+                prev = node;
+                break;
+            }
+        }
+    }
+
+    MDLMemBlkListNode *new_node = insert_new_node(list, prev, index);
+    if (new_node == NULL)
+        return NULL;
+
+    mdl_memcpy(new_node->data, value, list->elem_size);
+    return new_node->data;
+}
+
 int mdl_memblklist_removevalue(MDLMemBlkList *list, const void *value,
                                mdl_comparator_fptr cmp)
 {
@@ -304,10 +676,137 @@ int mdl_memblklist_removevalue(MDLMemBlkList *list, const void *value,
     if (node == NULL)
         return 0;
 
-    unlink_and_free_node(list, node);
+    remove_node(list, node, MDL_INVALID_INDEX);
     return 1;
 }
 
+void *mdl_memblklist_insertbeforeiter(MDLMemBlkList *list, MDLMemBlkListIterator *iter)
+{
+    size_t index = get_iterator_index(list, iter);
+    if (index == MDL_INVALID_INDEX)
+        return NULL;
+
+    MDLMemBlkListNode *new_node =
+        insert_new_node(list, (index == 0) ? NULL : iter->current->prev, index);
+    if (new_node == NULL)
+        return NULL;
+
+    // The iterator's element moved up one index. Forward iterators count the elements
+    // before it, so they need to be adjusted; reverse iterators count the elements after
+    // it, which haven't changed.
+    if (!iter->reverse)
+        iter->n_seen++;
+    return new_node->data;
+}
+
+void *mdl_memblklist_insertafteriter(MDLMemBlkList *list, MDLMemBlkListIterator *iter)
+{
+    size_t index = get_iterator_index(list, iter);
+    if (index == MDL_INVALID_INDEX)
+        return NULL;
+
+    MDLMemBlkListNode *new_node = insert_new_node(list, iter->current, index + 1);
+    if (new_node == NULL)
+        return NULL;
+
+    // The opposite of insertbeforeiter: there's one more element after the iterator.
+    if (iter->reverse)
+        iter->n_seen++;
+    return new_node->data;
+}
+
+int mdl_memblklist_removeatiter(MDLMemBlkList *list, MDLMemBlkListIterator *iter)
+{
+    size_t index = get_iterator_index(list, iter);
+    if (index == MDL_INVALID_INDEX)
+        return MDL_ERROR_INVALID_ARGUMENT;
+
+    MDLMemBlkListNode *node = iter->current;
+    if (iter->reverse)
+        iter->current = node->prev;
+    else
+        iter->current = node->next;
+
+    // The element that takes the removed one's place in the iteration has the same
+    // number of elements before it (forward) or after it (reverse) that the removed one
+    // did, so `n_seen` doesn't change.
+    remove_node(list, node, index);
+    if (list->length == 0)
+        iter->current = NULL;
+
+    if (iter->n_seen >= list->length)
+        return MDL_EOF;
+    return MDL_OK;
+}
+
+size_t mdl_memblklist_removeif(MDLMemBlkList *list, mdl_predicate_fptr predicate,
+                               void *udata)
+{
+    size_t n_removed = 0;
+    size_t index = 0;
+    MDLMemBlkListNode *node = list->head;
+
+    // Count down from the original length rather than checking for the head, since it
+    // changes if we remove the first element.
+    for (size_t n_remaining = list->length; n_remaining > 0; n_remaining--)
+    {
+        MDLMemBlkListNode *next = node->next;
+        if (predicate(list->mds, node->data, list->elem_size, udata))
+        {
+            remove_node(list, node, index);
+            n_removed++;
+        }
+        else
+            index++;
+        node = next;
+    }
+    return n_removed;
+}
+
+/** The user data passed to @ref matches_value. */
+typedef struct
+{
+    const void *value;
+    mdl_comparator_fptr cmp;
+} ValueMatch;
+
+size_t mdl_memblklist_removeallvalue(MDLMemBlkList *list, const void *value,
+                                     mdl_comparator_fptr cmp)
+{
+    ValueMatch match = {value, cmp};
+    return mdl_memblklist_removeif(list, matches_value, &match);
+}
+
+size_t mdl_memblklist_removeadjacentdups(MDLMemBlkList *list, mdl_comparator_fptr cmp)
+{
+    if (list->length < 2)
+        return 0;
+
+    // Compare each element against the last one we kept, so that a run of duplicates is
+    // collapsed into its first element.
+    size_t n_removed = 0;
+    size_t index = 1;
+    MDLMemBlkListNode *kept = list->head;
+    MDLMemBlkListNode *node = kept->next;
+
+    for (size_t n_remaining = list->length - 1; n_remaining > 0; n_remaining--)
+    {
+        MDLMemBlkListNode *next = node->next;
+        if (cmp(list->mds, kept->data, node->data, list->elem_size) == 0)
+        {
+            remove_node(list, node, index);
+            n_removed++;
+        }
+        else
+        {
+            kept = node;
+            index++;
+        }
+        node = next;
+    }
+    return n_removed;
+}
+
 MDLMemBlkListIterator *mdl_memblklist_getiterator(const MDLMemBlkList *list, bool reverse)
 {
     MDLMemBlkListIterator *iter = mdl_malloc(list->mds, sizeof(*iter));
@@ -323,7 +822,10 @@ void mdl_memblklistiter_init(const MDLMemBlkList *list, MDLMemBlkListIterator *i
                              bool reverse)
 {
     iterator->list = list;
-    iterator->current = list->head;
+    if (reverse && (list->head != NULL))
+        iterator->current = list->head->prev;
+    else
+        iterator->current = list->head;
     iterator->n_seen = 0;
     iterator->reverse = reverse;
     iterator->was_allocated = false;
@@ -350,7 +852,7 @@ int mdl_memblklistiter_next(MDLMemBlkListIterator *iter)
 
 int mdl_memblklistiter_hasnext(const MDLMemBlkListIterator *iter)
 {
-    return iter->n_seen < iter->list->length;
+    return iter->n_seen + 1 < iter->list->length;
 }
 
 void mdl_memblklistiter_destroy(MDLMemBlkListIterator *iter)
@@ -367,50 +869,191 @@ static void unlink_node(MDLMemBlkListNode *node)
     if (node->next == node)
         return;
 
-    node->prev->next = node->next;
-    node->next->prev = node->prev;
+    MDL_CIRCULARLIST_UNLINK(node);
+}
+
+static void remove_node(MDLMemBlkList *list, MDLMemBlkListNode *node, size_t index)
+{
+    // Keep the cursor pointing at the same element if we can. If the cursor itself is
+    // being removed, move it to the next element, which takes over its index.
+    if (list->cursor_node != NULL)
+    {
+        if (node == list->cursor_node)
+        {
+            if (list->cursor_index + 1 < list->length)
+                list->cursor_node = node->next;
+            else
+                list->cursor_node = NULL;
+        }
+        else if (index == MDL_INVALID_INDEX)
+            list->cursor_node = NULL;
+        else if (index < list->cursor_index)
+            list->cursor_index--;
+    }
+
+    if (list->length == 1)
+        list->head = NULL;
+    else
+    {
+        if (node == list->head)
+            list->head = node->next;
+        unlink_node(node);
+    }
+
+    list->length--;
+    release_node(list, node);
+}
+
+static MDLMemBlkListNode *acquire_node(MDLMemBlkList *list)
+{
+    if ((list->free_nodes == NULL) && (list->nodes_per_slab > 0))
+    {
+        if (allocate_slab(list, list->nodes_per_slab) != MDL_OK)
+            return NULL;
+    }
+
+    MDLMemBlkListNode *node = list->free_nodes;
+    if (node == NULL)
+        return mdl_malloc(list->mds, get_node_size(list));
+
+    list->free_nodes = node->next;
+    list->n_free_nodes--;
+    return node;
+}
+
+static void release_node(MDLMemBlkList *list, MDLMemBlkListNode *node)
+{
+    // Nodes from slabs can't be freed individually, so they always go back on the free
+    // list. Nodes allocated on their own are only kept if there's room.
+    if ((list->nodes_per_slab > 0) || (list->n_free_nodes < list->max_free_nodes))
+    {
+        node->next = list->free_nodes;
+        list->free_nodes = node;
+        list->n_free_nodes++;
+    }
+    else
+        mdl_free(list->mds, node, get_node_size(list));
 }
 
-static void unlink_and_free_node(MDLMemBlkList *list, MDLMemBlkListNode *node)
+static int allocate_slab(MDLMemBlkList *list, size_t n_nodes)
 {
-    unlink_node(node);
-    mdl_free(list->mds, node, get_node_size(list));
+    size_t header_size = round_up_to_alignment(sizeof(MDLMemBlkListSlab));
+    size_t node_stride = round_up_to_alignment(get_node_size(list));
+
+    if (n_nodes > (SIZE_MAX - header_size) / node_stride)
+        return MDL_ERROR_NOMEM;
+
+    size_t slab_size = header_size + (n_nodes * node_stride);
+    MDLMemBlkListSlab *slab = mdl_malloc(list->mds, slab_size);
+    if (slab == NULL)
+        return MDL_ERROR_NOMEM;
+
+    slab->next = list->slabs;
+    slab->size = slab_size;
+    list->slabs = slab;
+
+    // Push the nodes onto the free list back to front so that they're handed out in
+    // order of increasing address.
+    char *node_memory = (char *)slab + header_size + (n_nodes * node_stride);
+    for (size_t i = 0; i < n_nodes; i++)
+    {
+        node_memory -= node_stride;
+
+        MDLMemBlkListNode *node = (MDLMemBlkListNode *)(void *)node_memory;
+        node->next = list->free_nodes;
+        list->free_nodes = node;
+    }
+    list->n_free_nodes += n_nodes;
+    return MDL_OK;
 }
 
-static void unlink_and_maybe_free_node(MDLMemBlkList *list, MDLMemBlkListNode *node)
+static void free_all_slabs(MDLMemBlkList *list)
 {
-    unlink_node(node);
-    mdl_free(list->mds, node, get_node_size(list));
+    MDLMemBlkListSlab *slab = list->slabs;
+    while (slab != NULL)
+    {
+        MDLMemBlkListSlab *next_slab = slab->next;
+        mdl_free(list->mds, slab, slab->size);
+        slab = next_slab;
+    }
+    list->slabs = NULL;
+}
+
+static size_t round_up_to_alignment(size_t size)
+{
+    size_t alignment = sizeof(MaxAlignType);
+    return ((size + alignment - 1) / alignment) * alignment;
 }
 
 void mdl_memblklist_movenodeafter(MDLMemBlkListNode *new_node,
                                   MDLMemBlkListNode *prev_node)
 {
-    new_node->prev = prev_node;
-    new_node->next = prev_node->next;
-    new_node->next->prev = new_node;
-    prev_node->next = new_node;
+    MDL_CIRCULARLIST_LINKAFTER(new_node, prev_node);
 }
 
-/* TODO (dargueta): Iterate backwards if the node is past the halfway point.
+/**
+ * Find the node at @a index without updating the cursor.
  *
- * The algorithm is still O(n) but for iterations forward or backward it can
- * save a lot of time.
+ * The cursor is still used as a starting point if it's the closest to @a index.
  */
-static MDLMemBlkListNode *get_node_at_abs_index(const MDLMemBlkList *list, size_t index)
+static MDLMemBlkListNode *find_node_at_abs_index(const MDLMemBlkList *list,
+                                                 size_t index)
 {
     if (index >= list->length)
         return NULL;
 
-    const MDLMemBlkListNode *node = list->head;
-    for (size_t i = 0; i < index; i++)
+    // Start from whichever of the head, the tail, or the cursor is closest to the node we
+    // want.
+    MDLMemBlkListNode *node = list->head;
+    size_t position = 0;
+    size_t distance = index;
+
+    if (list->length - 1 - index < distance)
+    {
+        node = list->head->prev;
+        position = list->length - 1;
+        distance = list->length - 1 - index;
+    }
+
+    if (list->cursor_node != NULL)
+    {
+        size_t cursor_distance;
+        if (list->cursor_index > index)
+            cursor_distance = list->cursor_index - index;
+        else
+            cursor_distance = index - list->cursor_index;
+
+        if (cursor_distance < distance)
+        {
+            node = list->cursor_node;
+            position = list->cursor_index;
+        }
+    }
+
+    for (; position < index; position++)
         node = node->next;
-    return (MDLMemBlkListNode *)node;
+    for (; position > index; position--)
+        node = node->prev;
+    return node;
+}
+
+/**
+ * Like @ref find_node_at_abs_index, but also moves the cursor to the node found.
+ */
+static MDLMemBlkListNode *get_node_at_abs_index(MDLMemBlkList *list, size_t index)
+{
+    MDLMemBlkListNode *node = find_node_at_abs_index(list, index);
+    if (node != NULL)
+    {
+        list->cursor_node = node;
+        list->cursor_index = index;
+    }
+    return node;
 }
 
 MDLMemBlkListNode *mdl_memblklist_appendnewnode(MDLMemBlkList *list)
 {
-    MDLMemBlkListNode *node = mdl_malloc(list->mds, get_node_size(list));
+    MDLMemBlkListNode *node = acquire_node(list);
     if (node == NULL)
         return NULL;
 
@@ -429,3 +1072,228 @@ size_t get_node_size(const MDLMemBlkList *list)
 {
     return sizeof(*list->head) + list->elem_size;
 }
+
+/**
+ * Determine if nodes can be moved from @a src to @a dest without copying them.
+ *
+ * Nodes are only interchangeable between lists that have the same state and element
+ * size. Nodes carved out of a slab belong to the list that allocated the slab, so lists
+ * using slabs can't give or take nodes.
+ */
+static int check_can_move_nodes(const MDLMemBlkList *dest, const MDLMemBlkList *src)
+{
+    if ((dest == src) || (dest->mds != src->mds) || (dest->elem_size != src->elem_size))
+        return MDL_ERROR_INVALID_ARGUMENT;
+    if ((dest->nodes_per_slab != 0) || (src->nodes_per_slab != 0))
+        return MDL_ERROR_NOT_SUPPORTED;
+    return MDL_OK;
+}
+
+/**
+ * Get the index of the element an iterator is on.
+ *
+ * @return The index, or @ref MDL_INVALID_INDEX if @a iter isn't an iterator over @a list
+ *         or has run off the end of it.
+ */
+static size_t get_iterator_index(const MDLMemBlkList *list,
+                                 const MDLMemBlkListIterator *iter)
+{
+    if ((iter->list != list) || (iter->n_seen >= list->length))
+        return MDL_INVALID_INDEX;
+
+    if (iter->reverse)
+        return list->length - 1 - iter->n_seen;
+    return iter->n_seen;
+}
+
+/**
+ * Unlink the run of @a count nodes from @a first to @a last from @a src, and append them
+ * to @a dest.
+ *
+ * @param first_index The index of @a first in @a src.
+ */
+static void move_nodes(MDLMemBlkList *dest, MDLMemBlkList *src, MDLMemBlkListNode *first,
+                       MDLMemBlkListNode *last, size_t first_index, size_t count)
+{
+    detach_run(src, first, last, first_index, count);
+    append_chain(dest, first, last, count);
+}
+
+/**
+ * Unlink the run of @a count nodes from @a first to @a last from the list. The nodes
+ * still point to each other, but the `prev` of @a first and `next` of @a last are stale.
+ *
+ * @param first_index The index of @a first.
+ */
+static void detach_run(MDLMemBlkList *list, MDLMemBlkListNode *first,
+                       MDLMemBlkListNode *last, size_t first_index, size_t count)
+{
+    if (count == list->length)
+        list->head = NULL;
+    else
+    {
+        first->prev->next = last->next;
+        last->next->prev = first->prev;
+        if (first_index == 0)
+            list->head = last->next;
+    }
+
+    // Nodes before the removed run keep their indexes, and nodes after it shift down.
+    if (list->cursor_node != NULL)
+    {
+        if (list->cursor_index >= first_index + count)
+            list->cursor_index -= count;
+        else if (list->cursor_index >= first_index)
+            list->cursor_node = NULL;
+    }
+    list->length -= count;
+}
+
+/**
+ * Link a chain of @a count nodes from @a first to @a last onto the end of the list. Only
+ * the `next` pointers of all but @a last and the `prev` pointers of all but @a first need
+ * to be set beforehand.
+ */
+static void append_chain(MDLMemBlkList *list, MDLMemBlkListNode *first,
+                         MDLMemBlkListNode *last, size_t count)
+{
+    // Appending doesn't change the index of any existing node, so the cursor is still
+    // valid.
+    if (list->head == NULL)
+    {
+        list->head = first;
+        first->prev = last;
+        last->next = first;
+    }
+    else
+    {
+        MDLMemBlkListNode *tail = list->head->prev;
+        tail->next = first;
+        first->prev = tail;
+        last->next = list->head;
+        list->head->prev = last;
+    }
+    list->length += count;
+}
+
+/**
+ * Get @a count nodes for new elements, copy @a items into them, and link them to each
+ * other in order.
+ *
+ * If the list allocates from slabs, all the nodes come from the free list and at most
+ * one new slab, big enough for all the nodes that aren't already free. This is
+ * all-or-nothing: if any allocation fails, the nodes acquired so far are given back and
+ * the list is unmodified.
+ *
+ * @param items An array of @a count elements to copy into the nodes.
+ * @param[out] first Receives the first node of the chain.
+ * @param[out] last Receives the last node of the chain.
+ * @return 0 on success, @ref MDL_ERROR_NOMEM if allocation failed.
+ */
+static int acquire_chain(MDLMemBlkList *list, size_t count, const void *items,
+                         MDLMemBlkListNode **first, MDLMemBlkListNode **last)
+{
+    if ((list->nodes_per_slab > 0) && (list->n_free_nodes < count))
+    {
+        size_t n_needed = count - list->n_free_nodes;
+        if (n_needed < list->nodes_per_slab)
+            n_needed = list->nodes_per_slab;
+        if (allocate_slab(list, n_needed) != MDL_OK)
+            return MDL_ERROR_NOMEM;
+    }
+
+    const char *item = items;
+    MDLMemBlkListNode *head = NULL;
+    MDLMemBlkListNode *tail = NULL;
+
+    for (size_t i = 0; i < count; i++, item += list->elem_size)
+    {
+        MDLMemBlkListNode *node = acquire_node(list);
+        if (node == NULL)
+        {
+            release_run(list, head, i, NULL);
+            return MDL_ERROR_NOMEM;
+        }
+
+        mdl_memcpy(node->data, item, list->elem_size);
+        node->prev = tail;
+
+        // A fresh node's next pointer is uninitialized and a recycled one's is stale.
+        // Clear it so releasing a partial chain after a failed allocation never reads it.
+        node->next = NULL;
+        if (tail == NULL)
+            head = node;
+        else
+            tail->next = node;
+        tail = node;
+    }
+
+    *first = head;
+    *last = tail;
+    return MDL_OK;
+}
+
+/**
+ * Release @a count nodes linked by their `next` pointers, starting at @a first,
+ * optionally copying their data to @a buf in order first.
+ */
+static void release_run(MDLMemBlkList *list, MDLMemBlkListNode *first, size_t count,
+                        void *buf)
+{
+    char *output = buf;
+    MDLMemBlkListNode *node = first;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        MDLMemBlkListNode *next = node->next;
+        if (output != NULL)
+        {
+            mdl_memcpy(output, node->data, list->elem_size);
+            output += list->elem_size;
+        }
+        release_node(list, node);
+        node = next;
+    }
+}
+
+/**
+ * Allocate a node and link it into the list after @a prev.
+ *
+ * @param list The list to operate on.
+ * @param prev The node to insert after, or NULL to insert at the head of the list.
+ * @param index The index the new node will have.
+ * @return The new node, or NULL if allocation failed. If this fails, the list is
+ *         unmodified.
+ */
+static MDLMemBlkListNode *insert_new_node(MDLMemBlkList *list, MDLMemBlkListNode *prev,
+                                          size_t index)
+{
+    MDLMemBlkListNode *new_node = acquire_node(list);
+    if (new_node == NULL)
+        return NULL;
+
+    if (list->head == NULL)
+    {
+        new_node->prev = new_node;
+        new_node->next = new_node;
+        list->head = new_node;
+    }
+    else if (prev == NULL)
+    {
+        mdl_memblklist_movenodeafter(new_node, list->head->prev);
+        list->head = new_node;
+    }
+    else
+        mdl_memblklist_movenodeafter(new_node, prev);
+
+    if ((list->cursor_node != NULL) && (list->cursor_index >= index))
+        list->cursor_index++;
+    list->length++;
+    return new_node;
+}
+
+static bool matches_value(MDLState *mds, const void *item, size_t size, void *udata)
+{
+    const ValueMatch *match = udata;
+    return match->cmp(mds, item, match->value, size) == 0;
+}
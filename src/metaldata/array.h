@@ -6,11 +6,15 @@
 // file, You can obtain one at https://mozilla.org/MPL/2.0/.
 
 /**
- * A resizable array of pointers.
+ * A resizable array of pointers or fixed-size values.
+ *
+ * By default, an array holds pointers. Arrays created with @ref mdl_array_newwithelemsize
+ * or @ref mdl_array_initwithelemsize store their elements inline instead, which avoids a
+ * separate allocation and a pointer dereference per element. These are accessed with the
+ * `*copy` functions and @ref mdl_array_getptrat.
  *
  * - Reads and writes are O(1).
- * - Pushes and pops from the end are O(1).
- * - Pushes and pops from the front are O(n).
+ * - Pushes and pops from either end are amortized O(1).
  * - Forward and backward iteration is supported.
  *
  * @file array.h
@@ -24,12 +28,29 @@
 #include <stdbool.h>
 #include <stddef.h>
 
+/**
+ * The number of elements in a block of an array, unless specified otherwise.
+ *
+ * @see mdl_array_initwithblocksize
+ */
 #define MDL_DEFAULT_ARRAY_BLOCK_SIZE 16
 
-typedef struct MDLArrayBlock_
-{
-    void *values[MDL_DEFAULT_ARRAY_BLOCK_SIZE];
-} MDLArrayBlock;
+/**
+ * The default utilization below which an array gives back unused memory, as a
+ * percentage.
+ *
+ * @see mdl_array_setshrinkthreshold
+ */
+#define MDL_DEFAULT_ARRAY_SHRINK_THRESHOLD 25
+
+/**
+ * A block of @ref MDLArray.block_size contiguous elements, each @ref MDLArray.elem_size
+ * bytes long.
+ */
+typedef char *MDLArrayBlock;
+
+struct MDLArraySlab_;
+typedef struct MDLArraySlab_ MDLArraySlab;
 
 typedef struct MDLArray_
 {
@@ -44,9 +65,85 @@ typedef struct MDLArray_
      * The current length of the array.
      */
     size_t length;
+
+    /**
+     * The size of a single element, in bytes. For arrays of pointers this is
+     * `sizeof(void *)`.
+     */
+    size_t elem_size;
+
+    /**
+     * True if elements are stored inline rather than as pointers. Functions that take or
+     * return pointer values fail with @ref MDL_ERROR_NOT_SUPPORTED on these arrays, and
+     * callbacks receive pointers to the elements.
+     */
+    bool inline_values;
+
+    /**
+     * The number of elements in a single block. This is always a power of 2.
+     */
+    size_t block_size;
+
+    /**
+     * The base-2 logarithm of @ref block_size, so that converting an index into a block
+     * number is a shift rather than a division.
+     */
+    unsigned block_shift;
+
+    /**
+     * The index in the block table of the first allocated block. Entries before this
+     * one are unused so that blocks can be added to the front of the array without
+     * moving the rest of the table.
+     */
+    size_t first_block;
+
+    /**
+     * The position of the first element, counting from the beginning of the first
+     * allocated block. This is at least @ref block_size if there are unused blocks at the
+     * front of the array, e.g. after popping from the front.
+     */
+    size_t head_offset;
+
+    /**
+     * The number of blocks currently allocated. This may be more than are needed to hold
+     * @ref length elements.
+     */
     size_t n_allocated_blocks;
 
-    MDLArrayBlock **blocks;
+    /**
+     * The number of entries the block table has room for. This is always at least
+     * @ref n_allocated_blocks, and grows geometrically so that appending many elements
+     * only resizes the table O(log n) times.
+     */
+    size_t table_capacity;
+
+    /**
+     * The block table. Only the @ref n_allocated_blocks entries starting from
+     * @ref first_block are valid.
+     */
+    MDLArrayBlock *blocks;
+
+    /**
+     * A linked list of the allocations the blocks were carved out of. Blocks are never
+     * freed individually; the slabs are freed all at once when the array is cleared or
+     * compacted.
+     */
+    MDLArraySlab *slabs;
+
+    /**
+     * The percentage of allocated element slots that must be in use. If removing elements
+     * makes the utilization drop below this, the array is compacted. 0 means never.
+     *
+     * @see mdl_array_setshrinkthreshold
+     */
+    unsigned shrink_threshold;
+
+    /**
+     * The length below which the array will be compacted. This is derived from
+     * @ref shrink_threshold and the number of allocated blocks, and cached so that
+     * removing an element only needs one comparison to check it.
+     */
+    size_t shrink_length;
 
     /**
      * True if this struct was allocated with @ref mdl_malloc and needs to be freed upon
@@ -61,9 +158,27 @@ typedef struct MDLArray_
 typedef struct MDLArrayIterator_
 {
     const MDLArray *array;
+
+    /**
+     * The index in the array's block table of the block containing the current element.
+     */
     size_t block_index;
+
+    /**
+     * The offset of the current element within its block.
+     */
     size_t block_element_index;
+
+    /**
+     * The index of the current element in the array.
+     */
     size_t absolute_index;
+
+    /**
+     * The number of elements left to visit, including the current one.
+     */
+    size_t n_remaining;
+
     bool reverse;
 
     /**
@@ -97,6 +212,26 @@ MDL_ANNOTN__NONNULL_ARGS(1)
 MDL_ANNOTN__NODISCARD
 MDLArray *mdl_array_new(MDLState *mds, mdl_destructor_fptr elem_destructor);
 
+/**
+ * Like @ref mdl_array_new but allows specifying the number of elements in a block.
+ *
+ * @param mds The MetalData state.
+ * @param elem_destructor See @ref mdl_array_new.
+ * @param block_size
+ *      The number of elements in a block. This must be a nonzero power of 2. Larger
+ *      blocks mean fewer allocations for big arrays at the cost of more wasted space in
+ *      small ones.
+ * @return A pointer to the newly-allocated array, or NULL if an error occurred. If
+ *         @a block_size is invalid, this returns NULL.
+ *
+ * @see mdl_array_initwithblocksize
+ */
+MDL_API
+MDL_ANNOTN__NONNULL_ARGS(1)
+MDL_ANNOTN__NODISCARD
+MDLArray *mdl_array_newwithblocksize(MDLState *mds, mdl_destructor_fptr elem_destructor,
+                                     size_t block_size);
+
 /**
  * Like @ref mdl_array_new but the destructor is a no-op.
  */
@@ -122,6 +257,59 @@ MDL_API
 MDL_ANNOTN__NONNULL_ARGS(1, 2)
 int mdl_array_init(MDLState *mds, MDLArray *array, mdl_destructor_fptr elem_destructor);
 
+/**
+ * Like @ref mdl_array_init but allows specifying the number of elements in a block.
+ *
+ * @param mds The MetalData state.
+ * @param array The array to initialize.
+ * @param elem_destructor See @ref mdl_array_init.
+ * @param block_size
+ *      The number of elements in a block. This must be a nonzero power of 2.
+ * @return 0 on success, an error code otherwise. If @a block_size isn't a power of 2,
+ *         this returns @ref MDL_ERROR_INVALID_ARGUMENT.
+ *
+ * @see mdl_array_newwithblocksize
+ */
+MDL_API
+MDL_ANNOTN__NONNULL_ARGS(1, 2)
+int mdl_array_initwithblocksize(MDLState *mds, MDLArray *array,
+                                mdl_destructor_fptr elem_destructor, size_t block_size);
+
+/**
+ * Allocate and initialize a new empty array that stores its elements inline.
+ *
+ * @param mds The MetalData state.
+ * @param elem_size The size of a single element, in bytes. This must be nonzero.
+ * @param elem_destructor
+ *      A destructor function to call on elements when deleted. It receives a pointer to
+ *      the element, not its value. If no destructor is needed, pass NULL.
+ * @return A pointer to the newly-allocated array, or NULL if an error occurred.
+ *
+ * @see mdl_array_initwithelemsize
+ */
+MDL_API
+MDL_ANNOTN__NONNULL_ARGS(1)
+MDL_ANNOTN__NODISCARD
+MDLArray *mdl_array_newwithelemsize(MDLState *mds, size_t elem_size,
+                                    mdl_destructor_fptr elem_destructor);
+
+/**
+ * Like @ref mdl_array_init but stores elements of @a elem_size bytes inline.
+ *
+ * @param mds The MetalData state.
+ * @param array The array to initialize.
+ * @param elem_size The size of a single element, in bytes.
+ * @param elem_destructor See @ref mdl_array_newwithelemsize.
+ * @return 0 on success, an error code otherwise. If @a elem_size is 0, this returns
+ *         @ref MDL_ERROR_INVALID_ARGUMENT.
+ *
+ * @see mdl_array_newwithelemsize
+ */
+MDL_API
+MDL_ANNOTN__NONNULL_ARGS(1, 2)
+int mdl_array_initwithelemsize(MDLState *mds, MDLArray *array, size_t elem_size,
+                               mdl_destructor_fptr elem_destructor);
+
 /**
  * Destroy an array.
  *
@@ -142,6 +330,16 @@ MDL_API
 MDL_ANNOTN__NONNULL
 size_t mdl_array_length(const MDLArray *array);
 
+/**
+ * Return the size of a single element of the array, in bytes.
+ *
+ * @param array The array to examine.
+ * @return The element size. For arrays of pointers, this is `sizeof(void *)`.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+size_t mdl_array_getelementsize(const MDLArray *array);
+
 /**
  * Get the first element in the array.
  *
@@ -177,6 +375,20 @@ MDL_API
 MDL_ANNOTN__NONNULL_ARGS(1)
 int mdl_array_push(MDLArray *array, void *item);
 
+/**
+ * Append a copy of the element at @a src to the end of the array.
+ *
+ * This works for any array. For arrays of pointers, @a src points to the pointer to
+ * append.
+ *
+ * @param array The array to operate on.
+ * @param[in] src A pointer to @ref MDLArray.elem_size bytes to copy into the array.
+ * @return 0 on success, an error code otherwise.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+int mdl_array_pushcopy(MDLArray *array, const void *src);
+
 /**
  * Append multiple items to the end of the array.
  *
@@ -205,23 +417,40 @@ MDL_API
 MDL_ANNOTN__NONNULL_ARGS(1)
 int mdl_array_pop(MDLArray *array, void **item);
 
+/**
+ * Remove an element from the end of the array, copying it out first.
+ *
+ * @param array The array to operate on.
+ * @param[out] buf
+ *      A buffer of at least @ref MDLArray.elem_size bytes receiving the element. Callers
+ *      may pass NULL if the value doesn't need to be saved.
+ * @return 0 on success, an error code otherwise. If the array is empty, this will be
+ * @ref MDL_ERROR_EMPTY.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL_ARGS(1)
+int mdl_array_popcopy(MDLArray *array, void *buf);
+
 /**
  * Remove @a count items from the end of the array.
  *
- * If @a count is greater than the number of elements left in the list,
+ * If @a count is greater than the number of elements left in the list, nothing is
+ * removed and this fails.
  *
  * @param array The array to operate on.
+ * @param[out] items
+ *      A pointer to an array of pointers receiving the values just popped, in the same
+ *      order they were in the array. That is, the former last element of the array is
+ *      stored in `items[count - 1]`. Callers may pass NULL if the removed values don't
+ *      need to be saved. If it's non-NULL, @a items must have space for at least
+ *      @a count elements.
  * @param count
  *      The number of values to pop off the end.
- * @param[out] items
- *      A pointer to an array of pointers receiving the values just popped. Callers may
- *      pass NULL if the removed values don't need to be saved. If it's non-NULL, @a items
- *      must have space for at least @a count elements.
- * @return 0 on success, an error code otherwise.
+ * @return 0 on success, an error code otherwise. If @a count is greater than the length
+ * of the array, this will be @ref MDL_ERROR_OUT_OF_RANGE.
  */
 MDL_API
 MDL_ANNOTN__NONNULL_ARGS(1)
-MDL_ANNOTN__ACCESS_SIZED(write_only, 2, 3)
 int mdl_array_bulkpop(MDLArray *array, void **items, size_t count);
 
 /**
@@ -235,6 +464,17 @@ MDL_API
 MDL_ANNOTN__NONNULL_ARGS(1)
 int mdl_array_pushfront(MDLArray *array, void *item);
 
+/**
+ * Like @ref mdl_array_pushcopy but inserts the element at the beginning of the array.
+ *
+ * @param array The array to operate on.
+ * @param[in] src A pointer to @ref MDLArray.elem_size bytes to copy into the array.
+ * @return 0 on success, an error code otherwise.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+int mdl_array_pushfrontcopy(MDLArray *array, const void *src);
+
 /**
  * Remove a value from the beginning of the array.
  *
@@ -249,18 +489,126 @@ MDL_API
 MDL_ANNOTN__NONNULL_ARGS(1)
 int mdl_array_popfront(MDLArray *array, void **item);
 
+/**
+ * Like @ref mdl_array_popcopy but removes the element at the beginning of the array.
+ *
+ * @param array The array to operate on.
+ * @param[out] buf
+ *      A buffer of at least @ref MDLArray.elem_size bytes receiving the element, or NULL.
+ * @return 0 on success, an error code otherwise. If the array is empty, this will be
+ * @ref MDL_ERROR_EMPTY.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL_ARGS(1)
+int mdl_array_popfrontcopy(MDLArray *array, void *buf);
+
 MDL_API
 MDL_ANNOTN__NONNULL
 int mdl_array_getat(const MDLArray *array, int index, void **value);
 
+/**
+ * Copy the element at the given index out of the array.
+ *
+ * @param array The array to operate on.
+ * @param index
+ *      The index of the element to copy. Negative values count from the end of the
+ *      array, e.g. -1 is the last element.
+ * @param[out] buf
+ *      A buffer of at least @ref MDLArray.elem_size bytes receiving the element.
+ * @return 0 on success, an error code otherwise. If @a index doesn't refer to an existing
+ * element, this will be @ref MDL_ERROR_OUT_OF_RANGE.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+int mdl_array_getcopy(const MDLArray *array, int index, void *buf);
+
+/**
+ * Get a pointer to the storage of the element at the given index.
+ *
+ * The pointer is only valid until the array is modified other than by changing the value
+ * of an existing element.
+ *
+ * @param array The array to operate on.
+ * @param index
+ *      The index of the element. Negative values count from the end of the array.
+ * @return A pointer to the element, or NULL if @a index doesn't refer to an existing
+ * element.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+void *mdl_array_getptrat(const MDLArray *array, int index);
+
 MDL_API
 MDL_ANNOTN__NONNULL_ARGS(1)
 int mdl_array_setat(MDLArray *array, int index, void *new_value);
 
+/**
+ * Overwrite the element at the given index with a copy of the one at @a src.
+ *
+ * @param array The array to operate on.
+ * @param index
+ *      The index of the element to overwrite. Negative values count from the end of the
+ *      array.
+ * @param[in] src A pointer to @ref MDLArray.elem_size bytes to copy into the array.
+ * @return 0 on success, an error code otherwise. If @a index doesn't refer to an existing
+ * element, this will be @ref MDL_ERROR_OUT_OF_RANGE.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+int mdl_array_setcopy(MDLArray *array, int index, const void *src);
+
+/**
+ * Insert a value into the array immediately after the element at the given index.
+ *
+ * Only the elements on the shorter side of the insertion point are moved, so inserting
+ * near either end is fast.
+ *
+ * @param array The array to operate on.
+ * @param index
+ *      The index of the element to insert after. Negative values count from the end of
+ *      the array, e.g. -1 is the last element.
+ * @param new_value The value to insert.
+ * @return 0 on success, an error code otherwise. If @a index doesn't refer to an existing
+ * element, this will be @ref MDL_ERROR_OUT_OF_RANGE.
+ */
 MDL_API
 MDL_ANNOTN__NONNULL_ARGS(1)
 int mdl_array_insertafter(MDLArray *array, int index, void *new_value);
 
+/**
+ * Copy the elements in the range [@a start, @a end) out of the array.
+ *
+ * This is much faster than calling @ref mdl_array_getat for each element in the range.
+ *
+ * @param array The array to operate on.
+ * @param start The index of the first element to copy.
+ * @param end The index one past the last element to copy.
+ * @param[out] items
+ *      A pointer to an array of pointers receiving the values. It must have space for at
+ *      least `end - start` elements.
+ * @return 0 on success, an error code otherwise. If @a end is past the end of the array
+ * or less than @a start, this will be @ref MDL_ERROR_OUT_OF_RANGE.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+int mdl_array_copyrange(const MDLArray *array, size_t start, size_t end, void **items);
+
+/**
+ * Remove the value at the given index from the array.
+ *
+ * Like with @ref mdl_array_insertafter, only the elements on the shorter side of the
+ * removed element are moved. The element's destructor is not called.
+ *
+ * @param array The array to operate on.
+ * @param index
+ *      The index of the element to remove. Negative values count from the end of the
+ *      array, e.g. -1 is the last element.
+ * @param[out] value
+ *      A pointer to a pointer receiving the value just removed. Callers may pass NULL if
+ *      the value doesn't need to be saved.
+ * @return 0 on success, an error code otherwise. If @a index doesn't refer to an existing
+ * element, this will be @ref MDL_ERROR_OUT_OF_RANGE.
+ */
 MDL_API
 MDL_ANNOTN__NONNULL_ARGS(1)
 int mdl_array_removeat(MDLArray *array, int index, void **value);
@@ -268,6 +616,8 @@ int mdl_array_removeat(MDLArray *array, int index, void **value);
 /**
  * Remove all items in the array.
  *
+ * This also frees all the memory used to store the elements.
+ *
  * @param array The array to operate on.
  * @return 0 on success, an error code otherwise.
  */
@@ -278,6 +628,11 @@ int mdl_array_clear(MDLArray *array);
 /**
  * Search the array for the first element matching @a value.
  *
+ * @a cmp is called with each element as its left argument, @a value as its right
+ * argument, and a size of 0. If @a cmp is @ref mdl_default_ptr_value_comparator, the
+ * pointers are compared directly without calling it. For arrays storing values inline,
+ * the left argument is a pointer to the element and the size is @ref MDLArray.elem_size.
+ *
  * @param array The array to operate on.
  * @param[in] value The value to search for.
  * @param cmp The comparator function to use to compare two values.
@@ -300,22 +655,140 @@ int mdl_array_find(const MDLArray *array, const void *value, mdl_comparator_fptr
  * match was found.
  */
 MDL_API
-MDL_ANNOTN__NONNULL_ARGS(1)
+MDL_ANNOTN__NONNULL_ARGS(1, 3)
 int mdl_array_rfind(const MDLArray *array, const void *value, mdl_comparator_fptr cmp);
 
+/**
+ * Remove the first element matching @a value from the array.
+ *
+ * The element's destructor is called, if the array has one. See @ref mdl_array_find for
+ * how @a cmp is used.
+ *
+ * @param array The array to operate on.
+ * @param[in] value The value to search for.
+ * @param cmp The comparator function to use to compare two values.
+ * @return 1 if an element was removed, 0 if no match was found.
+ */
 MDL_API
-MDL_ANNOTN__NONNULL_ARGS(1)
+MDL_ANNOTN__NONNULL_ARGS(1, 3)
 int mdl_array_removevalue(MDLArray *array, const void *value, mdl_comparator_fptr cmp);
 
+/**
+ * Sort the array in place.
+ *
+ * This uses introsort, so it's O(n log n) in the worst case and doesn't allocate any
+ * memory. It's not stable, i.e. elements that compare equal may be reordered.
+ *
+ * @param array The array to operate on.
+ * @param cmp
+ *      The comparator function to use to compare two elements. It's called with the two
+ *      element values and a size of 0, or for arrays storing values inline, pointers to
+ *      the two elements and @ref MDLArray.elem_size.
+ * @return 0 on success, an error code otherwise.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+int mdl_array_sort(MDLArray *array, mdl_comparator_fptr cmp);
+
+/**
+ * Find the index of the first element in a sorted array that doesn't compare less than
+ * @a value.
+ *
+ * The array must be sorted with respect to @a cmp, e.g. by @ref mdl_array_sort with the
+ * same comparator. The result is undefined otherwise.
+ *
+ * @param array The array to operate on.
+ * @param[in] value The value to search for.
+ * @param cmp
+ *      The comparator function to use to compare two values. It's called with an element
+ *      as its left argument, @a value as its right argument, and a size of 0. See
+ *      @ref mdl_array_sort for arrays storing values inline.
+ * @return The index of the first element greater than or equal to @a value. If there is
+ * no such element, this is the length of the array.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL_ARGS(1, 3)
+size_t mdl_array_lowerbound(const MDLArray *array, const void *value,
+                            mdl_comparator_fptr cmp);
+
+/**
+ * Search a sorted array for an element matching @a value using binary search.
+ *
+ * The array must be sorted; see @ref mdl_array_lowerbound for details.
+ *
+ * @param array The array to operate on.
+ * @param[in] value The value to search for.
+ * @param cmp The comparator function to use to compare two values.
+ * @return The absolute index of the first matching element, or a negative number if no
+ * match was found, just like @ref mdl_array_find.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL_ARGS(1, 3)
+int mdl_array_bsearch(const MDLArray *array, const void *value, mdl_comparator_fptr cmp);
+
+/**
+ * Ensure the array can hold at least @a capacity elements without allocating more memory.
+ *
+ * All blocks needed to reach @a capacity are carved out of a single allocation, so this
+ * is much cheaper than growing the array one push at a time.
+ *
+ * @param array The array to operate on.
+ * @param capacity The total number of elements the array must be able to hold.
+ * @return 0 on success, an error code otherwise.
+ */
 MDL_API
 MDL_ANNOTN__NONNULL
 int mdl_array_ensurecapacity(MDLArray *array, size_t capacity);
 
+/**
+ * Release as much unused memory as possible.
+ *
+ * All elements are moved into a single allocation exactly big enough to hold them, and
+ * the block table is shrunk to match.
+ *
+ * @param array The array to operate on.
+ * @return 0 on success, an error code otherwise. If this fails, the array is unmodified.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+int mdl_array_shrinktofit(MDLArray *array);
+
+/**
+ * Control when removing elements from the array gives back memory.
+ *
+ * Emptied blocks aren't freed right away, so that an array going back and forth across
+ * a block boundary doesn't allocate and free memory every time. Instead, once the number
+ * of elements drops below @a percent of the allocated capacity, the array is compacted
+ * so that it's about half full. The default is @ref MDL_DEFAULT_ARRAY_SHRINK_THRESHOLD.
+ *
+ * @param array The array to operate on.
+ * @param percent
+ *      The utilization below which memory is reclaimed. Pass 0 to never reclaim memory
+ *      automatically; @ref mdl_array_shrinktofit still works.
+ * @return 0 on success, an error code otherwise. If @a percent is 50 or higher, this
+ * will be @ref MDL_ERROR_INVALID_ARGUMENT.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+int mdl_array_setshrinkthreshold(MDLArray *array, unsigned percent);
+
 MDL_API
 MDL_ANNOTN__NODISCARD
 MDL_ANNOTN__NONNULL
 MDLArrayIterator *mdl_array_getiterator(const MDLArray *array, bool reverse);
 
+/**
+ * Initialize an iterator over an array.
+ *
+ * Modifying the array in any way other than changing the value of an existing element
+ * invalidates all of its iterators.
+ *
+ * @param array The array to iterate over.
+ * @param iter The iterator to initialize.
+ * @param reverse
+ *      If true, iterate from the last element to the first. Otherwise, iterate from the
+ *      first element to the last.
+ */
 MDL_API
 MDL_ANNOTN__NONNULL
 void mdl_arrayiter_init(const MDLArray *array, MDLArrayIterator *iter, bool reverse);
@@ -323,10 +796,13 @@ void mdl_arrayiter_init(const MDLArray *array, MDLArrayIterator *iter, bool reve
 /**
  * Get the value of the element the iterator is pointing to.
  *
- * @warning If the array is empty, the return value is @e undefined.
+ * This only works for arrays of pointers. Use @ref mdl_arrayiter_getptr for arrays
+ * storing values inline.
  *
  * @param iter
- * @return The value of the element the iterator is pointing to.
+ * @return The value of the element the iterator is pointing to, or NULL if the array is
+ *         empty. Since elements can be NULL too, use @ref mdl_array_length to tell these
+ *         apart.
  *
  * @see mdl_arrayiter_hasnext
  */
@@ -334,6 +810,16 @@ MDL_API
 MDL_ANNOTN__NONNULL
 void *mdl_arrayiter_get(const MDLArrayIterator *iter);
 
+/**
+ * Get a pointer to the storage of the element the iterator is pointing to.
+ *
+ * @param iter
+ * @return A pointer to the current element, or NULL if the array is empty.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+void *mdl_arrayiter_getptr(const MDLArrayIterator *iter);
+
 /**
  * Advance the iterator to the next element in the input.
  *
@@ -344,6 +830,43 @@ MDL_API
 MDL_ANNOTN__NONNULL
 int mdl_arrayiter_next(MDLArrayIterator *iter);
 
+/**
+ * Get all elements from the current one to the end of its block, and advance the iterator
+ * past them.
+ *
+ * This lets callers process many contiguous elements at a time without calling
+ * @ref mdl_arrayiter_get and @ref mdl_arrayiter_next for every one of them. A typical
+ * loop looks like this:
+ *
+ * ```c
+ * const void *span;
+ * size_t span_length;
+ *
+ * while ((span_length = mdl_arrayiter_nextspan(&iter, &span)) > 0)
+ * {
+ *     void *const *values = span;
+ *     for (size_t i = 0; i < span_length; i++)
+ *         do_something(values[i]);
+ * }
+ * ```
+ *
+ * For arrays storing values inline, the span points to the elements themselves.
+ *
+ * Elements in a span are always in the same order they're in the array. For reverse
+ * iterators, this means the span ends at the current element and begins at the
+ * beginning of its block, so callers should go through it from back to front.
+ *
+ * @param iter The iterator to operate on.
+ * @param[out] span
+ *      Receives a pointer to the first element of the span. This is only valid until the
+ *      array is modified.
+ * @return The number of elements in the span. This is 0 once all elements have been
+ * visited, in which case @a span is not modified.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+size_t mdl_arrayiter_nextspan(MDLArrayIterator *iter, const void **span);
+
 MDL_API
 MDL_ANNOTN__NONNULL
 bool mdl_arrayiter_hasnext(const MDLArrayIterator *iter);
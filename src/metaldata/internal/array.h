@@ -16,6 +16,21 @@
 
 #include "../array.h"
 #include "annotations.h"
+#include <stddef.h>
+
+/**
+ * A single allocation that one or more of an @ref MDLArray's blocks are carved out of.
+ *
+ * The blocks immediately follow this header in memory.
+ */
+struct MDLArraySlab_
+{
+    /** The next slab owned by the same array, or NULL if this is the last one. */
+    MDLArraySlab *next;
+
+    /** The total size of this slab in bytes, including this header. */
+    size_t size;
+};
 
 MDL_ANNOTN__NODISCARD
 MDL_ANNOTN__NONNULL
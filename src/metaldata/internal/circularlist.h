@@ -0,0 +1,55 @@
+// SPDX-License-Identifier: MPL-2.0+
+// Copyright (C) 2020-2025  Diego Argueta
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+/**
+ * Relinking helpers shared by the circular doubly-linked lists.
+ *
+ * These are macros rather than functions so that they work with any struct that has
+ * `prev` and `next` pointers to its own type, e.g. @ref MDLMemBlkListNode and
+ * @ref MDLIntrusiveLink. The node arguments are evaluated more than once, so they should
+ * be plain variables.
+ *
+ * @file circularlist.h
+ */
+
+#ifndef INCLUDE_METALDATA_INTERNAL_CIRCULARLIST_H_
+#define INCLUDE_METALDATA_INTERNAL_CIRCULARLIST_H_
+
+/**
+ * Link @a node into a circle right after @a prev_node.
+ *
+ * @a prev_node is evaluated exactly once, before any links are changed, so it can be an
+ * expression like `head->prev` that the relinking itself modifies.
+ *
+ * @param node The node to link in. Its current links are overwritten.
+ * @param prev_node A node already in the circle.
+ */
+#define MDL_CIRCULARLIST_LINKAFTER(node, prev_node)                                      \
+    do                                                                                   \
+    {                                                                                    \
+        (node)->prev = (prev_node);                                                      \
+        (node)->next = (node)->prev->next;                                               \
+        (node)->prev->next = (node);                                                     \
+        (node)->next->prev = (node);                                                     \
+    } while (0)
+
+/**
+ * Remove @a node from its circle by linking its neighbors to each other.
+ *
+ * @a node's own links are left untouched. Unlinking the only node in a circle does
+ * nothing.
+ *
+ * @param node The node to unlink.
+ */
+#define MDL_CIRCULARLIST_UNLINK(node)                                                    \
+    do                                                                                   \
+    {                                                                                    \
+        (node)->prev->next = (node)->next;                                               \
+        (node)->next->prev = (node)->prev;                                               \
+    } while (0)
+
+#endif /* INCLUDE_METALDATA_INTERNAL_CIRCULARLIST_H_ */
@@ -22,18 +22,21 @@
 #    if defined(__has_builtin)
 #        define MDL_LIBC_HAVE_BUILTIN_MEMCMP __has_builtin(__builtin_memcmp)
 #        define MDL_LIBC_HAVE_BUILTIN_MEMCPY __has_builtin(__builtin_memcpy)
+#        define MDL_LIBC_HAVE_BUILTIN_MEMMOVE __has_builtin(__builtin_memmove)
 #        define MDL_LIBC_HAVE_BUILTIN_MEMSET __has_builtin(__builtin_memset)
 #        define MDL_LIBC_HAVE_BUILTIN_STRCMP __has_builtin(__builtin_strcmp)
 #        define MDL_LIBC_HAVE_BUILTIN_ABORT __has_builtin(__builtin_trap)
 #    elif defined(__GNUC__)
 #        define MDL_LIBC_HAVE_BUILTIN_MEMCMP MINIMUM_GNU_VERSION(4, 0, 0)
 #        define MDL_LIBC_HAVE_BUILTIN_MEMCPY MINIMUM_GNU_VERSION(4, 0, 0)
+#        define MDL_LIBC_HAVE_BUILTIN_MEMMOVE MINIMUM_GNU_VERSION(4, 0, 0)
 #        define MDL_LIBC_HAVE_BUILTIN_MEMSET MINIMUM_GNU_VERSION(4, 0, 0)
 #        define MDL_LIBC_HAVE_BUILTIN_STRCMP MINIMUM_GNU_VERSION(4, 0, 0)
 #        define MDL_LIBC_HAVE_BUILTIN_ABORT MINIMUM_GNU_VERSION(4, 2, 0)
 #    else
 #        define MDL_LIBC_HAVE_BUILTIN_MEMCPY 0
 #        define MDL_LIBC_HAVE_BUILTIN_MEMCPY 0
+#        define MDL_LIBC_HAVE_BUILTIN_MEMMOVE 0
 #        define MDL_LIBC_HAVE_BUILTIN_MEMSET 0
 #        define MDL_LIBC_HAVE_BUILTIN_STRCMP 0
 #        define MDL_LIBC_HAVE_BUILTIN_ABORT 0
@@ -42,6 +45,7 @@
 #    define MDL_LIBC_NEED_CUSTOM_ASSERT 1
 #    define MDL_LIBC_NEED_CUSTOM_MEMCMP (!MDL_LIBC_HAVE_BUILTIN_MEMCMP)
 #    define MDL_LIBC_NEED_CUSTOM_MEMCPY (!MDL_LIBC_HAVE_BUILTIN_MEMCPY)
+#    define MDL_LIBC_NEED_CUSTOM_MEMMOVE (!MDL_LIBC_HAVE_BUILTIN_MEMMOVE)
 #    define MDL_LIBC_NEED_CUSTOM_MEMSET (!MDL_LIBC_HAVE_BUILTIN_MEMSET)
 #    define MDL_LIBC_NEED_CUSTOM_STRCMP (!MDL_LIBC_HAVE_BUILTIN_STRCMP)
 #else
@@ -51,14 +55,17 @@
 #    define mdl_assert(mds, expr) assert(expr)
 #    define mdl_memcmp memcmp
 #    define mdl_memcpy memcpy
+#    define mdl_memmove memmove
 #    define mdl_memset memset
 #    define mdl_strcmp strcmp
 #    define MDL_LIBC_NEED_CUSTOM_MEMCMP 0
 #    define MDL_LIBC_NEED_CUSTOM_MEMCPY 0
+#    define MDL_LIBC_NEED_CUSTOM_MEMMOVE 0
 #    define MDL_LIBC_NEED_CUSTOM_MEMSET 0
 #    define MDL_LIBC_NEED_CUSTOM_STRCMP 0
 #    define MDL_LIBC_NEED_CUSTOM_ASSERT 0
 #    define MDL_LIBC_HAVE_BUILTIN_MEMCPY 0
+#    define MDL_LIBC_HAVE_BUILTIN_MEMMOVE 0
 #    define MDL_LIBC_HAVE_BUILTIN_MEMSET 0
 #    define MDL_LIBC_HAVE_BUILTIN_STRCMP 0
 #    define MDL_LIBC_HAVE_BUILTIN_ABORT 0
@@ -95,6 +102,26 @@ void *mdl_memcpy(void *restrict dest, const void *restrict src, size_t size);
 #    define mdl_memcpy __builtin_memcpy
 #endif
 
+#if MDL_LIBC_NEED_CUSTOM_MEMMOVE
+/**
+ * A naive implementation of the C standard library's `memmove()`.
+ *
+ * Unlike @ref mdl_memcpy, @a dest and @a src may overlap.
+ *
+ * @param dest The target buffer to copy data into.
+ * @param src The source buffer to copy data from.
+ * @param size The number of bytes to copy.
+ *
+ * @return Always returns @a dest.
+ */
+MDL_INTERNAL
+MDL_ANNOTN__NONNULL
+MDL_ANNOTN__RETURNS_NONNULL
+void *mdl_memmove(void *dest, const void *src, size_t size);
+#elif MDL_LIBC_HAVE_BUILTIN_MEMMOVE
+#    define mdl_memmove __builtin_memmove
+#endif
+
 #if MDL_LIBC_NEED_CUSTOM_MEMSET
 /**
  * A naive implementation of the C standard library's `memset()`.
@@ -155,9 +182,10 @@ int mdl_strcmp(const char *restrict left, const char *restrict right);
 #            pragma GCC poison assert strcmp
 #        endif /* MDL_COMPILED_AS_UNHOSTED */
 #        undef memcpy
+#        undef memmove
 #        undef memset
 #    else
-#        pragma GCC poison memcpy memset strcmp
+#        pragma GCC poison memcpy memmove memset strcmp
 #        undef assert
 #    endif
 #endif
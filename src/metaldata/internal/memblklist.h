@@ -16,6 +16,22 @@
 
 #include "../memblklist.h"
 #include "annotations.h"
+#include <stddef.h>
+
+/**
+ * A single allocation that one or more of an @ref MDLMemBlkList's nodes are carved out
+ * of.
+ *
+ * The nodes follow this header in memory, padded so that every node is suitably aligned.
+ */
+struct MDLMemBlkListSlab_
+{
+    /** The next slab owned by the same list, or NULL if this is the last one. */
+    MDLMemBlkListSlab *next;
+
+    /** The total size of this slab in bytes, including this header. */
+    size_t size;
+};
 
 MDL_ANNOTN__NONNULL
 MDLMemBlkListNode *mdl_memblklist_findnode(const MDLMemBlkList *list, const void *value,
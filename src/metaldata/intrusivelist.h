@@ -0,0 +1,286 @@
+// SPDX-License-Identifier: MPL-2.0+
+// Copyright (C) 2020-2025  Diego Argueta
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+/**
+ * A doubly-linked circular list of objects that embed their own links.
+ *
+ * Unlike @ref MDLMemBlkList, this never allocates or copies anything. Users put an
+ * @ref MDLIntrusiveLink in their own structs and the list threads those together, so
+ * adding an existing object to a list can't fail. An object can be on several lists at
+ * once by embedding one link per list.
+ *
+ * ```c
+ * typedef struct
+ * {
+ *     int fd;
+ *     MDLIntrusiveLink ready_link;
+ *     MDLIntrusiveLink timeout_link;
+ * } Connection;
+ *
+ * mdl_intrusivelist_push(&ready_queue, &conn->ready_link);
+ * mdl_intrusivelist_push(&timeout_queue, &conn->timeout_link);
+ *
+ * MDLIntrusiveLink *link = mdl_intrusivelist_popfront(&ready_queue);
+ * Connection *next_ready = MDL_INTRUSIVELIST_ENTRY(link, Connection, ready_link);
+ * ```
+ *
+ * - Pushes and pops from both ends are O(1).
+ * - Inserting and removing an object anywhere in the list is O(1), given its link.
+ * - Accessing the first and last objects is O(1).
+ *
+ * The list doesn't own the objects on it. Objects must be removed from a list (or the
+ * list cleared) before they're freed.
+ *
+ * @warning All structures should be treated as opaque; they are defined here only so that
+ *          they can be statically allocated when desired.
+ *
+ * @file intrusivelist.h
+ */
+#ifndef INCLUDE_METALDATA_INTRUSIVELIST_H_
+#define INCLUDE_METALDATA_INTRUSIVELIST_H_
+
+#include "configuration.h"
+#include "internal/annotations.h"
+#include "metaldata.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+struct MDLIntrusiveLink_;
+typedef struct MDLIntrusiveLink_ MDLIntrusiveLink;
+
+struct MDLIntrusiveList_;
+typedef struct MDLIntrusiveList_ MDLIntrusiveList;
+
+/**
+ * Get a pointer to the struct containing a link.
+ *
+ * @param link A pointer to an @ref MDLIntrusiveLink embedded in a struct of type @a type.
+ * @param type The type of the struct the link is embedded in.
+ * @param member The name of the link's field in @a type.
+ */
+#define MDL_INTRUSIVELIST_ENTRY(link, type, member)                                      \
+    ((type *)(void *)((char *)(link) - offsetof(type, member)))
+
+/**
+ * The links to embed in objects to put them on an @ref MDLIntrusiveList.
+ */
+struct MDLIntrusiveLink_
+{
+    /**
+     * A pointer to the previous link in the list. The first link in a list points to the
+     * last one. NULL if and only if the link isn't on a list.
+     */
+    MDLIntrusiveLink *prev;
+
+    /**
+     * A pointer to the next link in the list. The last link in a list points to the first
+     * one. NULL if and only if the link isn't on a list.
+     */
+    MDLIntrusiveLink *next;
+};
+
+/**
+ * A list of objects with embedded links.
+ *
+ * @warning The struct is declared in the header only to allow users to allocate it on the
+ *          stack. Do not modify it directly.
+ */
+struct MDLIntrusiveList_
+{
+    /** A pointer to the first link in the list, or NULL if and only if it's empty. */
+    MDLIntrusiveLink *head;
+
+    /** The number of links in the list. */
+    size_t length;
+};
+
+/**
+ * Initialize an empty list.
+ *
+ * Since the list never allocates memory, it doesn't need to be destroyed.
+ *
+ * @param list The list to initialize.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+void mdl_intrusivelist_init(MDLIntrusiveList *list);
+
+/**
+ * Mark a link as not being on any list.
+ *
+ * Links must be initialized with this before they're first added to a list. Links
+ * removed from a list are reset automatically.
+ *
+ * @param link The link to initialize.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+void mdl_intrusivelink_init(MDLIntrusiveLink *link);
+
+/**
+ * Determine if a link is currently on a list.
+ *
+ * @param link The link to examine.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+bool mdl_intrusivelink_islinked(const MDLIntrusiveLink *link);
+
+/**
+ * Return the number of links in the list.
+ *
+ * @param list The list to examine.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+size_t mdl_intrusivelist_length(const MDLIntrusiveList *list);
+
+/**
+ * Get the first link in the list.
+ *
+ * @param list The list to operate on.
+ * @return The first link, or NULL if the list is empty.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+MDLIntrusiveLink *mdl_intrusivelist_head(const MDLIntrusiveList *list);
+
+/**
+ * Get the last link in the list.
+ *
+ * @param list The list to operate on.
+ * @return The last link, or NULL if the list is empty.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+MDLIntrusiveLink *mdl_intrusivelist_tail(const MDLIntrusiveList *list);
+
+/**
+ * Get the link after @a link in the list.
+ *
+ * Together with @ref mdl_intrusivelist_head, this is used to iterate over the list:
+ *
+ * ```c
+ * for (MDLIntrusiveLink *link = mdl_intrusivelist_head(&list); link != NULL;
+ *      link = mdl_intrusivelist_next(&list, link))
+ * {
+ *     ...
+ * }
+ * ```
+ *
+ * @param list The list @a link is on.
+ * @param link A link on @a list.
+ * @return The next link, or NULL if @a link is the last one.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+MDLIntrusiveLink *mdl_intrusivelist_next(const MDLIntrusiveList *list,
+                                         const MDLIntrusiveLink *link);
+
+/**
+ * Get the link before @a link in the list.
+ *
+ * @param list The list @a link is on.
+ * @param link A link on @a list.
+ * @return The previous link, or NULL if @a link is the first one.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+MDLIntrusiveLink *mdl_intrusivelist_prev(const MDLIntrusiveList *list,
+                                         const MDLIntrusiveLink *link);
+
+/**
+ * Append a link to the end of the list.
+ *
+ * @param list The list to operate on.
+ * @param link The link to add.
+ * @return 0 on success, @ref MDL_ERROR_ALREADY_EXISTS if @a link is already on a list.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+int mdl_intrusivelist_push(MDLIntrusiveList *list, MDLIntrusiveLink *link);
+
+/**
+ * Prepend a link to the beginning of the list.
+ *
+ * @param list The list to operate on.
+ * @param link The link to add.
+ * @return 0 on success, @ref MDL_ERROR_ALREADY_EXISTS if @a link is already on a list.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+int mdl_intrusivelist_pushfront(MDLIntrusiveList *list, MDLIntrusiveLink *link);
+
+/**
+ * Insert a link immediately after another one.
+ *
+ * @param list The list to operate on.
+ * @param existing A link on @a list.
+ * @param link The link to add.
+ * @return 0 on success, @ref MDL_ERROR_ALREADY_EXISTS if @a link is already on a list.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+int mdl_intrusivelist_insertafter(MDLIntrusiveList *list, MDLIntrusiveLink *existing,
+                                  MDLIntrusiveLink *link);
+
+/**
+ * Insert a link immediately before another one.
+ *
+ * @param list The list to operate on.
+ * @param existing A link on @a list.
+ * @param link The link to add.
+ * @return 0 on success, @ref MDL_ERROR_ALREADY_EXISTS if @a link is already on a list.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+int mdl_intrusivelist_insertbefore(MDLIntrusiveList *list, MDLIntrusiveLink *existing,
+                                   MDLIntrusiveLink *link);
+
+/**
+ * Remove and return the last link in the list.
+ *
+ * @param list The list to operate on.
+ * @return The removed link, or NULL if the list is empty.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+MDLIntrusiveLink *mdl_intrusivelist_pop(MDLIntrusiveList *list);
+
+/**
+ * Remove and return the first link in the list.
+ *
+ * @param list The list to operate on.
+ * @return The removed link, or NULL if the list is empty.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+MDLIntrusiveLink *mdl_intrusivelist_popfront(MDLIntrusiveList *list);
+
+/**
+ * Remove a link from the list in O(1) time.
+ *
+ * @param list The list @a link is on. Passing a different list corrupts both of them.
+ * @param link The link to remove.
+ * @return 0 on success, @ref MDL_ERROR_NOT_FOUND if @a link isn't on a list.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+int mdl_intrusivelist_remove(MDLIntrusiveList *list, MDLIntrusiveLink *link);
+
+/**
+ * Remove all links from the list.
+ *
+ * This is O(n) because every link needs to be marked as not being on a list.
+ *
+ * @param list The list to operate on.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+void mdl_intrusivelist_clear(MDLIntrusiveList *list);
+
+#endif /* INCLUDE_METALDATA_INTRUSIVELIST_H_ */
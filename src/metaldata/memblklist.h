@@ -10,8 +10,13 @@
  *
  * - Pushes and pops from both ends are O(1).
  * - Accessing the first and last elements are also O(1).
- * - All other accesses are O(n).
+ * - Accessing an element by index is O(n), but starts from whichever end of the list or
+ *   the most recently accessed element is closest. Accessing elements in order is O(1)
+ *   per element.
  * - Forward and backward iteration is supported.
+ * - Runs of elements can be moved between lists in O(1) without copying, using
+ *   @ref mdl_memblklist_splice, @ref mdl_memblklist_split, and
+ *   @ref mdl_memblklist_concat.
  *
  * @warning All structures should be treated as opaque; they are defined here only so that
  *          they can be statically allocated when desired.
@@ -36,6 +41,9 @@ typedef struct MDLMemBlkList_ MDLMemBlkList;
 struct MDLMemBlkListIterator_;
 typedef struct MDLMemBlkListIterator_ MDLMemBlkListIterator;
 
+struct MDLMemBlkListSlab_;
+typedef struct MDLMemBlkListSlab_ MDLMemBlkListSlab;
+
 /**
  * A single node in the linked list of memory blocks.
  */
@@ -85,6 +93,46 @@ struct MDLMemBlkList_
      */
     size_t length;
 
+    /**
+     * The node most recently looked up by index by a function that can modify the list,
+     * e.g. @ref mdl_memblklist_getblockatcached, or NULL if there isn't one. Looking up
+     * an index starts from here if it's closer than either end of the list, so accessing
+     * elements in order is O(1) per element rather than O(n).
+     */
+    MDLMemBlkListNode *cursor_node;
+
+    /** The index of @ref cursor_node. Meaningless if @ref cursor_node is NULL. */
+    size_t cursor_index;
+
+    /**
+     * Removed nodes kept around for reuse, linked through their `next` pointers. Only
+     * used if the node cache is enabled.
+     *
+     * @see mdl_memblklist_setnodecache
+     */
+    MDLMemBlkListNode *free_nodes;
+
+    /** The number of nodes in @ref free_nodes. */
+    size_t n_free_nodes;
+
+    /**
+     * The most nodes allocated individually that @ref free_nodes may hold. Nodes removed
+     * beyond this are freed. 0 disables caching of individually-allocated nodes.
+     */
+    size_t max_free_nodes;
+
+    /**
+     * If nonzero, nodes are allocated this many at a time in a single slab rather than
+     * one by one.
+     */
+    size_t nodes_per_slab;
+
+    /**
+     * The slabs nodes were carved out of, if @ref nodes_per_slab is nonzero. They're only
+     * freed when the list is cleared.
+     */
+    MDLMemBlkListSlab *slabs;
+
     /**
      * True if this struct was allocated with @ref mdl_malloc and needs to be freed upon
      * destruction. Having this explicitly specified allows users call
@@ -146,6 +194,33 @@ MDL_API
 MDL_ANNOTN__NONNULL
 void mdl_memblklist_init(MDLState *mds, MDLMemBlkList *list, size_t elem_size);
 
+/**
+ * Configure how the list allocates and recycles its nodes.
+ *
+ * By default, every push allocates a node and every pop frees one. For lists used as
+ * queues or stacks, this means a round trip to the allocator for every operation. With
+ * the node cache enabled, removed nodes are kept on a free list and reused by later
+ * pushes, so a list that stays around the same size stops allocating altogether.
+ *
+ * This can only be changed while the list is empty.
+ *
+ * @param list The list to operate on.
+ * @param max_free_nodes
+ *      The maximum number of removed nodes to keep for reuse. Removing elements past this
+ *      frees their nodes as usual. 0 disables the cache.
+ * @param nodes_per_slab
+ *      If nonzero, nodes are allocated this many at a time from a single block of memory,
+ *      and unused nodes are put on the free list. Nodes carved out of a slab can't be
+ *      freed individually, so they're always kept for reuse regardless of
+ *      @a max_free_nodes, and are only freed when the list is cleared or destroyed.
+ * @return 0 on success, an error code otherwise. If the list isn't empty, this will be
+ * @ref MDL_ERROR_NOT_SUPPORTED.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+int mdl_memblklist_setnodecache(MDLMemBlkList *list, size_t max_free_nodes,
+                                size_t nodes_per_slab);
+
 /**
  * Destroy a list.
  *
@@ -300,9 +375,82 @@ MDL_API
 MDL_ANNOTN__NONNULL
 int mdl_memblklist_popfrontcopy(MDLMemBlkList *list, void *buf);
 
+/**
+ * Append copies of @a count elements to the end of the list.
+ *
+ * This is much faster than calling @ref mdl_memblklist_push for each element. The nodes
+ * are linked in a single pass, and if the list allocates from slabs (see
+ * @ref mdl_memblklist_setnodecache), any nodes not already cached are allocated together
+ * in one slab.
+ *
+ * @param list The list to operate on.
+ * @param[in] items
+ *      An array of @a count elements, each @ref MDLMemBlkList.elem_size bytes long.
+ * @param count The number of elements to add.
+ * @return 0 on success, @ref MDL_ERROR_NOMEM if allocation failed. If the operation
+ *         fails, the list is unmodified.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+int mdl_memblklist_pushmany(MDLMemBlkList *list, const void *items, size_t count);
+
+/**
+ * Like @ref mdl_memblklist_pushmany, but adds the elements to the front of the list.
+ *
+ * The elements keep their order, so `items[0]` becomes the new head of the list.
+ *
+ * @param list The list to operate on.
+ * @param[in] items
+ *      An array of @a count elements, each @ref MDLMemBlkList.elem_size bytes long.
+ * @param count The number of elements to add.
+ * @return 0 on success, @ref MDL_ERROR_NOMEM if allocation failed. If the operation
+ *         fails, the list is unmodified.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+int mdl_memblklist_pushfrontmany(MDLMemBlkList *list, const void *items, size_t count);
+
+/**
+ * Remove @a count elements from the end of the list.
+ *
+ * If @a count is greater than the number of elements in the list, nothing is removed and
+ * this fails.
+ *
+ * @param list The list to operate on.
+ * @param[out] buf
+ *      A buffer receiving the data blocks of the removed elements, in the same order they
+ *      were in the list. That is, the former last element of the list is stored last.
+ *      Callers may pass NULL if the data doesn't need to be saved. Otherwise, it must
+ *      have space for @a count elements.
+ * @param count The number of elements to remove.
+ * @return 0 on success, @ref MDL_ERROR_OUT_OF_RANGE if @a count is greater than the
+ *         length of the list.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL_ARGS(1)
+int mdl_memblklist_popmany(MDLMemBlkList *list, void *buf, size_t count);
+
+/**
+ * Like @ref mdl_memblklist_popmany, but removes elements from the front of the list.
+ *
+ * @param list The list to operate on.
+ * @param[out] buf
+ *      A buffer receiving the data blocks of the removed elements, in the same order they
+ *      were in the list, or NULL. If not NULL, it must have space for @a count elements.
+ * @param count The number of elements to remove.
+ * @return 0 on success, @ref MDL_ERROR_OUT_OF_RANGE if @a count is greater than the
+ *         length of the list.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL_ARGS(1)
+int mdl_memblklist_popfrontmany(MDLMemBlkList *list, void *buf, size_t count);
+
 /**
  * Get a pointer to the data block at the given index of the list.
  *
+ * This doesn't modify @a list, so it's safe to call from multiple threads at once. When
+ * accessing many elements in order, @ref mdl_memblklist_getblockatcached is faster.
+ *
  * @param list The list to operate on.
  * @param index The index of the data to access.
  * @return A pointer to the data block, or NULL if the index is invalid.
@@ -311,6 +459,22 @@ MDL_API
 MDL_ANNOTN__NONNULL
 void *mdl_memblklist_getblockat(const MDLMemBlkList *list, size_t index);
 
+/**
+ * Like @ref mdl_memblklist_getblockat, but remembers where the element is so that
+ * accessing nearby indexes afterward is fast.
+ *
+ * Accessing every element in order this way is O(1) per element rather than O(n).
+ * Because it modifies @a list, this isn't safe to call from multiple threads at once even
+ * though it doesn't change the list's contents.
+ *
+ * @param list The list to operate on.
+ * @param index The index of the data to access.
+ * @return A pointer to the data block, or NULL if the index is invalid.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+void *mdl_memblklist_getblockatcached(MDLMemBlkList *list, size_t index);
+
 /**
  * Copy @a src to the list element at @a index.
  *
@@ -324,14 +488,98 @@ MDL_API
 MDL_ANNOTN__NONNULL
 int mdl_memblklist_set(MDLMemBlkList *list, size_t index, const void *src);
 
+/**
+ * Insert a new element after the element at @a index.
+ *
+ * This is O(n) to find the element. If you're already iterating over the list, use
+ * @ref mdl_memblklist_insertafteriter instead.
+ *
+ * @param list The list to operate on.
+ * @param index The index of the element to insert after.
+ * @param[out] ptr If not null, receives a pointer to the data block of the new element.
+ * @return 0 on success, @ref MDL_ERROR_OUT_OF_RANGE if the index is invalid, or
+ *         @ref MDL_ERROR_NOMEM if allocation failed.
+ */
 MDL_API
 MDL_ANNOTN__NONNULL_ARGS(1)
 int mdl_memblklist_insertafter(MDLMemBlkList *list, size_t index, void **ptr);
 
+/**
+ * Like @ref mdl_memblklist_insertafter, but copies @a buf into the new element.
+ *
+ * @param list The list to operate on.
+ * @param index The index of the element to insert after.
+ * @param[in] buf The data to copy into the new element.
+ * @return Same as @ref mdl_memblklist_insertafter.
+ */
 MDL_API
 MDL_ANNOTN__NONNULL
 int mdl_memblklist_insertaftercopy(MDLMemBlkList *list, size_t index, const void *buf);
 
+/**
+ * Insert a new element immediately before the element an iterator is on, in O(1) time.
+ *
+ * "Before" is in list order, regardless of the direction of @a iter. The iterator stays
+ * on the same element, so a forward iterator won't visit the new element, and a reverse
+ * iterator will visit it next.
+ *
+ * @param list The list to operate on.
+ * @param iter An iterator over @a list, on the element to insert before.
+ * @return A pointer to the data block of the new element, or NULL if allocation failed
+ *         or @a iter isn't on an element of @a list.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+void *mdl_memblklist_insertbeforeiter(MDLMemBlkList *list, MDLMemBlkListIterator *iter);
+
+/**
+ * Insert a new element immediately after the element an iterator is on, in O(1) time.
+ *
+ * "After" is in list order, regardless of the direction of @a iter. The iterator stays
+ * on the same element, so a forward iterator will visit the new element next, and a
+ * reverse iterator won't visit it.
+ *
+ * @param list The list to operate on.
+ * @param iter An iterator over @a list, on the element to insert after.
+ * @return A pointer to the data block of the new element, or NULL if allocation failed
+ *         or @a iter isn't on an element of @a list.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+void *mdl_memblklist_insertafteriter(MDLMemBlkList *list, MDLMemBlkListIterator *iter);
+
+/**
+ * Remove the element an iterator is on, in O(1) time, and move the iterator to the
+ * element it would have visited next.
+ *
+ * This allows filtering a list in a single pass:
+ *
+ * ```c
+ * MDLMemBlkListIterator iter;
+ * int status = (mdl_memblklist_length(list) > 0) ? MDL_OK : MDL_EOF;
+ *
+ * mdl_memblklistiter_init(list, &iter, false);
+ * while (status == MDL_OK)
+ * {
+ *     if (should_remove(mdl_memblklistiter_get(&iter)))
+ *         status = mdl_memblklist_removeatiter(list, &iter);
+ *     else
+ *         status = mdl_memblklistiter_next(&iter);
+ * }
+ * ```
+ *
+ * Other iterators over @a list are invalidated.
+ *
+ * @param list The list to operate on.
+ * @param iter An iterator over @a list, on the element to remove.
+ * @return @ref MDL_OK if the iterator is on the next element, @ref MDL_EOF if the removed
+ *         element was the last one to visit, or @ref MDL_ERROR_INVALID_ARGUMENT if
+ *         @a iter isn't on an element of @a list.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+int mdl_memblklist_removeatiter(MDLMemBlkList *list, MDLMemBlkListIterator *iter);
+
 /**
  * Remove an item from the list.
  *
@@ -365,6 +613,8 @@ int mdl_memblklist_removeatcopy(MDLMemBlkList *list, size_t index, void *buf);
 /**
  * Remove all elements in the list.
  *
+ * This also frees all cached nodes, but the cache settings are kept.
+ *
  * @param list The list to operate on.
  */
 MDL_API
@@ -421,13 +671,17 @@ size_t mdl_memblklist_rfindindex(const MDLMemBlkList *list, const void *value,
 /**
  * Rotate the list forward or backward without copying any data.
  *
- * A positive number rotates the head of of the list forward, toward higher indexes. That
+ * A positive number rotates the elements of the list forward, toward higher indexes. That
  * is to say, rotating by +1 moves `list[x]` to `list[x+1]`. The final element of the list
  * moves to index 0.
  *
  * A negative number rotates the list in the opposite direction. Rotating a list by -1
  * moves `list[x]` to `list[x-1]`, and `list[0]` moves to the end.
  *
+ * @a places is reduced modulo the length of the list first, and the list is rotated in
+ * whichever direction is shorter, so this takes O(min(k, n - k)) time. Rotating by one
+ * place in either direction is O(1).
+ *
  * @param list The list to operate on.
  * @param places The number of places to rotate.
  *
@@ -439,11 +693,157 @@ int mdl_memblklist_rotate(MDLMemBlkList *list, long places);
 
 #define mdl_memblklist_rotateone(list) mdl_memblklist_rotate((list), 1)
 
+/**
+ * Move all elements of @a src to the end of @a dest, leaving @a src empty.
+ *
+ * Nodes are relinked rather than copied, so this is O(1) and pointers to data blocks in
+ * @a src remain valid.
+ *
+ * Both lists must have the same MetalData state and element size. Lists that allocate
+ * nodes from slabs (see @ref mdl_memblklist_setnodecache) own their nodes, and can't give
+ * or receive them.
+ *
+ * @param dest The list to append to.
+ * @param src The list to move the elements out of. Must not be @a dest.
+ * @return 0 on success, @ref MDL_ERROR_INVALID_ARGUMENT if the lists aren't compatible,
+ *         or @ref MDL_ERROR_NOT_SUPPORTED if either list allocates nodes from slabs.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+int mdl_memblklist_concat(MDLMemBlkList *dest, MDLMemBlkList *src);
+
+/**
+ * Cut @a list in two at an iterator.
+ *
+ * The element @a at is on and every element after it (in list order, regardless of the
+ * direction of @a at) are moved to the end of @a dest in O(1) time. Typically, @a dest is
+ * empty.
+ *
+ * All iterators over @a list are invalidated, including @a at.
+ *
+ * @param list The list to split.
+ * @param at An iterator over @a list on the first element to move.
+ * @param dest The list to move the elements to. The same restrictions as
+ *             @ref mdl_memblklist_concat apply.
+ * @return 0 on success, @ref MDL_ERROR_INVALID_ARGUMENT if the lists aren't compatible
+ *         or @a at isn't on an element of @a list, or @ref MDL_ERROR_NOT_SUPPORTED if
+ *         either list allocates nodes from slabs.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+int mdl_memblklist_split(MDLMemBlkList *list, const MDLMemBlkListIterator *at,
+                         MDLMemBlkList *dest);
+
+/**
+ * Move the elements from @a first to @a last, inclusive, from @a src to the end of
+ * @a dest in O(1) time.
+ *
+ * All iterators over @a src are invalidated, including @a first and @a last.
+ *
+ * @param dest The list to move the elements to. The same restrictions as
+ *             @ref mdl_memblklist_concat apply.
+ * @param src The list to move the elements out of.
+ * @param first An iterator over @a src on the first element to move.
+ * @param last An iterator over @a src on the last element to move. This must not come
+ *             before @a first in the list, but may be on the same element.
+ * @return 0 on success, @ref MDL_ERROR_INVALID_ARGUMENT if the lists aren't compatible
+ *         or the iterators don't give a valid range of @a src, or
+ *         @ref MDL_ERROR_NOT_SUPPORTED if either list allocates nodes from slabs.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+int mdl_memblklist_splice(MDLMemBlkList *dest, MDLMemBlkList *src,
+                          const MDLMemBlkListIterator *first,
+                          const MDLMemBlkListIterator *last);
+
+/**
+ * Sort the list in place.
+ *
+ * This is a bottom-up merge sort that relinks nodes rather than copying data, so it's
+ * O(n log n), uses O(1) extra memory, and pointers to data blocks remain valid. It's
+ * stable, i.e. elements that compare equal stay in the same order relative to each
+ * other.
+ *
+ * @param list The list to operate on.
+ * @param cmp
+ *      The comparator function to use to compare two elements. It's called with pointers
+ *      to the two data blocks and @ref MDLMemBlkList.elem_size.
+ * @return 0 on success, an error code otherwise.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+int mdl_memblklist_sort(MDLMemBlkList *list, mdl_comparator_fptr cmp);
+
+/**
+ * Insert a copy of @a value into a sorted list, keeping it sorted.
+ *
+ * The new element goes after any elements that compare equal to it. The search for the
+ * insertion point starts at the end of the list, so this is O(1) when values are
+ * inserted in increasing order, and O(n) in the worst case.
+ *
+ * @param list The list to operate on. It must already be sorted according to @a cmp.
+ * @param[in] value The data to copy into the new element.
+ * @param cmp The comparator function the list is sorted by.
+ * @return A pointer to the data block of the new element, or NULL if allocation failed.
+ *         If the operation fails, the list is unmodified.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+void *mdl_memblklist_insertsorted(MDLMemBlkList *list, const void *value,
+                                  mdl_comparator_fptr cmp);
+
 MDL_API
 MDL_ANNOTN__NONNULL
 int mdl_memblklist_removevalue(MDLMemBlkList *list, const void *value,
                                mdl_comparator_fptr cmp);
 
+/**
+ * Remove every element for which @a predicate returns true, in a single pass.
+ *
+ * Removed nodes are freed or recycled as they're unlinked. Elements that are kept stay in
+ * the same order.
+ *
+ * @param list The list to operate on.
+ * @param predicate
+ *      A function called once per element, in order, with a pointer to the element's data
+ *      block, @ref MDLMemBlkList.elem_size, and @a udata. It must not modify the list.
+ * @param udata Arbitrary data to pass to @a predicate.
+ * @return The number of elements removed.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL_ARGS(1, 2)
+size_t mdl_memblklist_removeif(MDLMemBlkList *list, mdl_predicate_fptr predicate,
+                               void *udata);
+
+/**
+ * Remove every element matching @a value, in a single pass.
+ *
+ * Unlike calling @ref mdl_memblklist_removevalue in a loop, this doesn't restart the
+ * search from the beginning of the list after every removal.
+ *
+ * @param list The list to operate on.
+ * @param value The value to compare the list elements against.
+ * @param cmp A function to use to compare elements against @a value.
+ * @return The number of elements removed.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+size_t mdl_memblklist_removeallvalue(MDLMemBlkList *list, const void *value,
+                                     mdl_comparator_fptr cmp);
+
+/**
+ * Collapse every run of consecutive elements that compare equal into its first element.
+ *
+ * On a sorted list (see @ref mdl_memblklist_sort), this removes all duplicates.
+ *
+ * @param list The list to operate on.
+ * @param cmp A function to use to compare adjacent elements.
+ * @return The number of elements removed.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+size_t mdl_memblklist_removeadjacentdups(MDLMemBlkList *list, mdl_comparator_fptr cmp);
+
 MDL_API
 MDL_ANNOTN__NODISCARD
 MDL_ANNOTN__NONNULL
@@ -463,12 +863,19 @@ void *mdl_memblklistiter_get(MDLMemBlkListIterator *iter);
  * Advance the iterator to the next element in the input.
  *
  * @param iter The iterator to operate on.
- * @return 0 on success, @ref MDL_EOF if the input has been exhausted.
+ * @return 0 on success, @ref MDL_EOF if the iterator is on the last element, in which
+ *         case it isn't moved.
  */
 MDL_API
 MDL_ANNOTN__NONNULL
 int mdl_memblklistiter_next(MDLMemBlkListIterator *iter);
 
+/**
+ * Determine if there are elements after the current one, i.e. if calling
+ * @ref mdl_memblklistiter_next will succeed.
+ *
+ * @param iter The iterator to examine.
+ */
 MDL_API
 MDL_ANNOTN__NONNULL
 int mdl_memblklistiter_hasnext(const MDLMemBlkListIterator *iter);
@@ -17,6 +17,7 @@
 #include "configuration.h"
 #include "internal/annotations.h"
 #include <inttypes.h> // Some versions of MSVC don't have stdint.h but have this.
+#include <stdbool.h>
 #include <stddef.h>
 
 /**
@@ -193,6 +194,19 @@ MDL_ANNOTN__NONNULL_ARGS(1)
 typedef int (*mdl_comparator_fptr)(MDLState *mds, const void *left, const void *right,
                                    size_t size) MDL_REENTRANT_MARKER;
 
+/**
+ * A function deciding if @a item meets some condition, e.g. for filtering a container.
+ *
+ * @param mds The MetalData state.
+ * @param item A pointer to the element to examine.
+ * @param size For containers whose elements have a fixed size, this is that size.
+ * @param udata Arbitrary user data passed through from the function this is given to.
+ * @return True if @a item meets the condition, false otherwise.
+ */
+MDL_ANNOTN__NONNULL_ARGS(1)
+typedef bool (*mdl_predicate_fptr)(MDLState *mds, const void *item, size_t size,
+                                   void *udata) MDL_REENTRANT_MARKER;
+
 /**
  * Free raw memory allocated by @ref mdl_malloc and its related functions.
  *
@@ -24,6 +24,19 @@ typedef struct MDLReader_ MDLReader;
 typedef int (*mdl_reader_getc_fptr)(MDLReader *reader, void *udata) MDL_REENTRANT_MARKER;
 typedef int (*mdl_reader_close_fptr)(MDLReader *reader, void *udata) MDL_REENTRANT_MARKER;
 
+/**
+ * A function that reads a block of bytes from the input.
+ *
+ * @param reader The reader this is being called for.
+ * @param[out] buf A pointer to the memory to write the data into.
+ * @param size The maximum number of bytes to read. This is never 0.
+ * @param udata The @a udata argument the reader was created with.
+ * @return The number of bytes read. This may be less than @a size without the input
+ *         being exhausted, but 0 means there's no more input.
+ */
+typedef size_t (*mdl_reader_read_fptr)(MDLReader *reader, void *buf, size_t size,
+                                       void *udata) MDL_REENTRANT_MARKER;
+
 /**
  * A byte-oriented reader that abstracts away details of the source.
  *
@@ -40,12 +53,35 @@ struct MDLReader_
      * When the input has been exhausted, the function returns a negative value.
      */
     mdl_reader_getc_fptr getc_ptr;
+
+    /**
+     * Optional. A pointer to a function that reads a block of bytes from the input. If
+     * given, @ref mdl_reader_read uses this instead of calling @ref getc_ptr once per
+     * byte.
+     */
+    mdl_reader_read_fptr read_ptr;
     mdl_reader_close_fptr close_ptr;
     void *udata;
     const char *input_buffer;
     size_t input_size;
     size_t buffer_position;
     int unget_character;
+
+    /**
+     * The read-ahead buffer set with @ref mdl_reader_setbuffer, or NULL if the reader is
+     * unbuffered.
+     */
+    char *readahead;
+    size_t readahead_size;
+
+    /** The index of the next unread byte in @ref readahead. */
+    size_t readahead_start;
+
+    /** One past the index of the last valid byte in @ref readahead. */
+    size_t readahead_end;
+
+    /** Indicates if @ref readahead was allocated by @ref mdl_reader_setbuffer. */
+    bool owns_readahead;
     bool was_allocated;
 };
 
@@ -74,8 +110,37 @@ MDL_ANNOTN__NODISCARD
 MDLReader *mdl_reader_new(MDLState *mds, mdl_reader_getc_fptr getc_ptr,
                           mdl_reader_close_fptr close_ptr, void *udata);
 
+/**
+ * Allocate and initialize a @ref MDLReader that reads its input in blocks.
+ *
+ * This is faster than @ref mdl_reader_new for sources that can produce more than one
+ * byte at a time, since @ref mdl_reader_read doesn't need to make one call per byte.
+ *
+ * @param mds  The MetalData state.
+ * @param read_ptr
+ *      A pointer to a function that reads a block of bytes from the input. It's also used
+ *      to read single characters, one byte at a time.
+ * @param close_ptr
+ *      Optional. A function that closes the input stream when called.
+ * @param udata
+ *      Optional. An additional argument to pass to @a read_ptr and @a close_ptr when
+ *      they're called. MetalData does not inspect the value.
+ *
+ * @return A new MDLReader ready for use. It must be deallocated using
+ *         @ref mdl_reader_close.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL_ARGS(1, 2)
+MDL_ANNOTN__NODISCARD
+MDLReader *mdl_reader_newblockreader(MDLState *mds, mdl_reader_read_fptr read_ptr,
+                                     mdl_reader_close_fptr close_ptr, void *udata);
+
 /**
  * Allocate and initialize a @ref MDLReader that reads from a fixed-size memory buffer.
+ *
+ * The reader doesn't copy @a buffer, so it must remain valid until the reader is closed.
+ * Block reads from it are a single memcpy, and @ref mdl_reader_borrow can be used to
+ * avoid copying at all.
  */
 MDL_API
 MDL_ANNOTN__NONNULL
@@ -92,6 +157,17 @@ MDL_ANNOTN__NONNULL_ARGS(1, 2)
 void mdl_reader_init(MDLState *mds, MDLReader *reader, mdl_reader_getc_fptr getc_ptr,
                      mdl_reader_close_fptr close_ptr, void *udata);
 
+/**
+ * Initialize an allocated @ref MDLReader that reads its input in blocks.
+ *
+ * Arguments have the same meanings as @ref mdl_reader_newblockreader.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL_ARGS(1, 2, 3)
+void mdl_reader_initblockreader(MDLState *mds, MDLReader *reader,
+                                mdl_reader_read_fptr read_ptr,
+                                mdl_reader_close_fptr close_ptr, void *udata);
+
 /**
  * Initialize an allocated @ref MDLReader to read from a fixed-size memory buffer.
  *
@@ -103,6 +179,39 @@ MDL_ANNOTN__NONNULL
 void mdl_reader_initfrombuffer(MDLState *mds, MDLReader *reader, const void *buffer,
                                size_t size);
 
+/**
+ * Make the reader read ahead from its source into a buffer.
+ *
+ * Unbuffered readers call their source for every byte read with @ref mdl_reader_getc,
+ * and @ref mdl_reader_peekc is a getc followed by an ungetc. A buffered reader serves
+ * those from the buffer instead. For readers created with
+ * @ref mdl_reader_newblockreader, the buffer is refilled with as large a block as fits.
+ * Reads at least as large as the buffer bypass it.
+ *
+ * Buffering also allows more than one character to be pushed back with
+ * @ref mdl_reader_ungetc, and looking ahead several bytes with
+ * @ref mdl_reader_lookahead.
+ *
+ * This must be called at most once per reader, and is best done before reading anything.
+ *
+ * @param reader The input stream.
+ * @param buffer
+ *      Optional. The memory to use for the buffer. It must remain valid until the reader
+ *      is closed. If NULL, a buffer of @a size bytes is allocated, and freed when the
+ *      reader is closed.
+ * @param size The size of the buffer, in bytes.
+ *
+ * @return 0 on success, or an error code:
+ *      - @ref MDL_ERROR_INVALID_ARGUMENT: @a size is 0.
+ *      - @ref MDL_ERROR_NOT_SUPPORTED: @a reader reads from a memory buffer, which
+ *        doesn't need buffering.
+ *      - @ref MDL_ERROR_ALREADY_EXISTS: The reader already has a buffer.
+ *      - @ref MDL_ERROR_NOMEM: The buffer couldn't be allocated.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL_ARGS(1)
+int mdl_reader_setbuffer(MDLReader *reader, void *buffer, size_t size);
+
 /**
  * Get the value of @a udata passed when the reader was created.
  */
@@ -140,6 +249,22 @@ MDL_API
 MDL_ANNOTN__NONNULL
 int mdl_reader_peekc(MDLReader *reader);
 
+/**
+ * Push a character back onto the input stream, to be returned by the next read.
+ *
+ * Only one character can be pushed back at a time, except:
+ *
+ * - Readers created with @ref mdl_reader_newfrombuffer can put back any number of bytes
+ *   so long as they're the ones that were just read from the buffer, in reverse order.
+ * - Readers with a buffer set by @ref mdl_reader_setbuffer can put back as many
+ *   characters as fit in the buffer alongside the data not read yet.
+ *
+ * @param reader The input stream.
+ * @param chr The character to push back.
+ * @return 0 on success, @ref MDL_ERROR_ALREADY_EXISTS if a character has already been
+ *         pushed back and not read yet, or @ref MDL_ERROR_FULL if the reader's
+ *         read-ahead buffer is full.
+ */
 MDL_API
 MDL_ANNOTN__NONNULL
 int mdl_reader_ungetc(MDLReader *reader, int chr);
@@ -151,7 +276,8 @@ int mdl_reader_ungetc(MDLReader *reader, int chr);
  * @param[out] buf  A pointer to the memory to write the data into.
  * @param size      The maximum number of bytes to read.
  *
- * @return The number of bytes read.
+ * @return The number of bytes read. This is only less than @a size if the input has
+ *         been exhausted.
  *
  * @note If @a reader reads from a buffer and @a buf overlaps with it, the behavior is
  * undefined.
@@ -161,4 +287,60 @@ MDL_ANNOTN__NONNULL
 MDL_ANNOTN__ACCESS_SIZED(write_only, 2, 3)
 size_t mdl_reader_read(MDLReader *reader, void *buf, size_t size);
 
+/**
+ * Consume up to @a size bytes from a buffer-backed reader without copying them.
+ *
+ * This is only supported for readers created with @ref mdl_reader_newfrombuffer or
+ * @ref mdl_reader_initfrombuffer. Since the data isn't copied, it's only valid for as
+ * long as the buffer the reader was created with.
+ *
+ * ```c
+ * const void *header;
+ * size_t header_size;
+ *
+ * mdl_reader_borrow(reader, sizeof(MessageHeader), &header, &header_size);
+ * if (header_size < sizeof(MessageHeader))
+ *     return MDL_ERROR_INVALID_ARGUMENT;
+ * ```
+ *
+ * @param reader The input stream.
+ * @param size The maximum number of bytes to consume.
+ * @param[out] ptr A pointer to the first byte consumed.
+ * @param[out] length
+ *      The number of bytes consumed. This is less than @a size only if the input has been
+ *      exhausted, and will be 0 at the end of the input.
+ *
+ * @return 0 on success. If @a reader doesn't read from a buffer, or a character that
+ *         didn't come from the buffer has been pushed back with @ref mdl_reader_ungetc,
+ *         this returns @ref MDL_ERROR_NOT_SUPPORTED and doesn't modify @a ptr or
+ *         @a length.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+int mdl_reader_borrow(MDLReader *reader, size_t size, const void **ptr, size_t *length);
+
+/**
+ * Look at up to the next @a size bytes of input without consuming them.
+ *
+ * This is supported for readers created with @ref mdl_reader_newfrombuffer, and readers
+ * with a buffer set by @ref mdl_reader_setbuffer. The data pointed to is only valid until
+ * the next operation on @a reader.
+ *
+ * @param reader The input stream.
+ * @param size The number of bytes to look at.
+ * @param[out] ptr A pointer to the next unread byte.
+ * @param[out] length
+ *      The number of bytes available at @a ptr. This is less than @a size only if the
+ *      input has been exhausted.
+ *
+ * @return 0 on success, or an error code:
+ *      - @ref MDL_ERROR_NOT_SUPPORTED: @a reader isn't buffered, or (for buffer-backed
+ *        readers) a character that didn't come from the buffer has been pushed back.
+ *      - @ref MDL_ERROR_OUT_OF_RANGE: @a size is larger than the reader's buffer.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+int mdl_reader_lookahead(MDLReader *reader, size_t size, const void **ptr,
+                         size_t *length);
+
 #endif /* INCLUDE_METALDATA_READER_H_ */
@@ -0,0 +1,544 @@
+// SPDX-License-Identifier: MPL-2.0+
+// Copyright (C) 2020-2025  Diego Argueta
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+/**
+ * An unrolled doubly-linked list of fixed-size memory blocks.
+ *
+ * This behaves like @ref MDLMemBlkList, but each node ("chunk") stores several elements
+ * next to each other instead of just one. This cuts the per-element memory overhead from
+ * two pointers down to a fraction of one, and keeps neighboring elements in the same
+ * cache lines.
+ *
+ * - Pushes and pops from both ends are O(1). Pushing to or popping from the front moves
+ *   at most one chunk's worth of elements.
+ * - Accessing the first and last elements is O(1).
+ * - Accessing, inserting, or removing an element by index is O(n / K), where K is the
+ *   number of elements per chunk.
+ * - Forward and backward iteration is supported, including iterating over a chunk's
+ *   elements all at once.
+ *
+ * The main difference from @ref MDLMemBlkList is that elements move around in memory when
+ * the list is modified: inserting or removing an element shifts the elements after it in
+ * its chunk, and chunks are split when they fill up and merged when they become less than
+ * half full. Thus, pointers to elements returned by any function are only valid until
+ * the list is next modified.
+ *
+ * @warning All structures should be treated as opaque; they are defined here only so that
+ *          they can be statically allocated when desired.
+ *
+ * @file unrolledlist.h
+ */
+#ifndef INCLUDE_METALDATA_UNROLLEDLIST_H_
+#define INCLUDE_METALDATA_UNROLLEDLIST_H_
+
+#include "configuration.h"
+#include "internal/annotations.h"
+#include "metaldata.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * The number of elements in a chunk if not specified by the user.
+ */
+#define MDL_DEFAULT_UNROLLEDLIST_CHUNK_CAPACITY 16
+
+struct MDLUnrolledListChunk_;
+typedef struct MDLUnrolledListChunk_ MDLUnrolledListChunk;
+
+struct MDLUnrolledList_;
+typedef struct MDLUnrolledList_ MDLUnrolledList;
+
+struct MDLUnrolledListIterator_;
+typedef struct MDLUnrolledListIterator_ MDLUnrolledListIterator;
+
+/**
+ * A single node in an unrolled list, holding up to the list's chunk capacity of elements.
+ */
+struct MDLUnrolledListChunk_
+{
+    /** The previous chunk in the list, or NULL if this is the first one. */
+    MDLUnrolledListChunk *prev;
+
+    /** The next chunk in the list, or NULL if this is the last one. */
+    MDLUnrolledListChunk *next;
+
+    /**
+     * The number of elements in this chunk. They're always packed at the beginning of
+     * @ref data. A chunk in a list is never empty.
+     */
+    size_t length;
+
+    /** The elements' data blocks, one after the other. */
+    char data[] MDL_ANNOTN__NONSTRING;
+};
+
+/**
+ * An unrolled list of blocks of memory.
+ *
+ * @warning The struct is declared in the header only to allow users to allocate it on the
+ *          stack. Do not modify it directly.
+ */
+struct MDLUnrolledList_
+{
+    /** The MetalData state. */
+    MDLState *mds;
+
+    /** A pointer to the first chunk in the list, or NULL if and only if it's empty. */
+    MDLUnrolledListChunk *head;
+
+    /** A pointer to the last chunk in the list, or NULL if and only if it's empty. */
+    MDLUnrolledListChunk *tail;
+
+    /** The size of a list element's memory block, in bytes. */
+    size_t elem_size;
+
+    /** The maximum number of elements a chunk can hold. Always at least 2. */
+    size_t chunk_capacity;
+
+    /** The number of elements in the list. */
+    size_t length;
+
+    /** The number of chunks in the list. */
+    size_t n_chunks;
+
+    /**
+     * True if this struct was allocated with @ref mdl_malloc and needs to be freed upon
+     * destruction. Having this explicitly specified allows users call
+     * @ref mdl_unrolledlist_destroy on a list, regardless of whether it was statically
+     * allocated or not.
+     */
+    bool was_allocated;
+};
+
+struct MDLUnrolledListIterator_
+{
+    const MDLUnrolledList *list;
+
+    /** The chunk containing the current element. */
+    MDLUnrolledListChunk *chunk;
+
+    /** The index of the current element in @ref chunk. */
+    size_t chunk_element_index;
+
+    /** The number of elements left to visit, including the current one. */
+    size_t n_remaining;
+
+    bool reverse;
+
+    /**
+     * True if this struct was allocated with @ref mdl_malloc and needs to be freed upon
+     * destruction. Having this explicitly specified allows users call
+     * @ref mdl_unrolledlistiter_destroy on an iterator, regardless of whether it was
+     * statically allocated or not.
+     */
+    bool was_allocated;
+};
+
+/**
+ * Allocate and initialize a new empty list with the default chunk capacity.
+ *
+ * @param mds The MetalData state.
+ * @param elem_size The size of a single element in the list.
+ * @return The new list, or NULL if allocation failed.
+ *
+ * @see mdl_unrolledlist_init
+ * @see mdl_unrolledlist_newwithchunkcapacity
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+MDL_ANNOTN__NODISCARD
+MDLUnrolledList *mdl_unrolledlist_new(MDLState *mds, size_t elem_size);
+
+/**
+ * Like @ref mdl_unrolledlist_new, but with a custom number of elements per chunk.
+ *
+ * @param mds The MetalData state.
+ * @param elem_size The size of a single element in the list.
+ * @param chunk_capacity The number of elements a chunk can hold. Must be at least 2.
+ * @return The new list, or NULL if allocation failed or the arguments are invalid.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+MDL_ANNOTN__NODISCARD
+MDLUnrolledList *mdl_unrolledlist_newwithchunkcapacity(MDLState *mds, size_t elem_size,
+                                                       size_t chunk_capacity);
+
+/**
+ * Initialize an allocated list with the default chunk capacity.
+ *
+ * Users that wish to statically allocate a list (e.g. to avoid an additional allocation)
+ * will use this to initialize it. They will still need to destroy the list using
+ * @ref mdl_unrolledlist_destroy.
+ *
+ * @param mds The MetalData state.
+ * @param list The list to initialize.
+ * @param elem_size The size of a single element in the list.
+ * @return 0 on success, an error code otherwise.
+ *
+ * @see mdl_unrolledlist_new
+ * @see mdl_unrolledlist_destroy
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+int mdl_unrolledlist_init(MDLState *mds, MDLUnrolledList *list, size_t elem_size);
+
+/**
+ * Like @ref mdl_unrolledlist_init, but with a custom number of elements per chunk.
+ *
+ * Larger chunks use less memory per element and make iteration and lookups by index
+ * faster, but make inserting and removing elements in the middle of the list slower.
+ *
+ * @param mds The MetalData state.
+ * @param list The list to initialize.
+ * @param elem_size The size of a single element in the list.
+ * @param chunk_capacity The number of elements a chunk can hold. Must be at least 2.
+ * @return 0 on success, @ref MDL_ERROR_INVALID_ARGUMENT if @a chunk_capacity is less than
+ *         2 or a chunk would be too big to allocate.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+int mdl_unrolledlist_initwithchunkcapacity(MDLState *mds, MDLUnrolledList *list,
+                                           size_t elem_size, size_t chunk_capacity);
+
+/**
+ * Destroy a list.
+ *
+ * @param list
+ * @return 0 on success, an error code otherwise.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+int mdl_unrolledlist_destroy(MDLUnrolledList *list);
+
+/**
+ * Return the number of elements in the list.
+ *
+ * @param list The list to examine.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+size_t mdl_unrolledlist_length(const MDLUnrolledList *list);
+
+/**
+ * Get the size of an element data block, in bytes.
+ *
+ * @param list The list to operate on.
+ *
+ * @return The size of a data block, in bytes.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+size_t mdl_unrolledlist_getelementsize(const MDLUnrolledList *list);
+
+/**
+ * Get the first data block in the list.
+ *
+ * @param list The list to operate on.
+ *
+ * @return NULL if the list is empty, otherwise a pointer to the value of the first
+ *         element in the list.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+void *mdl_unrolledlist_head(const MDLUnrolledList *list);
+
+/**
+ * Get the last data block in the list.
+ *
+ * @param list The list to operate on.
+ *
+ * @return NULL if the list is empty, otherwise a pointer to the value of the last
+ *         element in the list.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+void *mdl_unrolledlist_tail(const MDLUnrolledList *list);
+
+/**
+ * Append a new data block to the end of the list.
+ *
+ * @param list The list to operate on.
+ *
+ * @return A pointer to the block of memory in the new element, or NULL if allocation
+ *         failed. If the operation fails, the list is unmodified.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+void *mdl_unrolledlist_push(MDLUnrolledList *list);
+
+/**
+ * Remove a memory block from the end of the list.
+ *
+ * @param list The list to operate on.
+ *
+ * @return @ref MDL_OK on success, @ref MDL_ERROR_EMPTY if the list is empty.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+int mdl_unrolledlist_pop(MDLUnrolledList *list);
+
+/**
+ * Like @ref mdl_unrolledlist_pop, but copies the data block to @a buf before removing
+ * the element.
+ *
+ * @param list The list to operate on.
+ * @param[out] buf The buffer to copy the data block to.
+ *
+ * @return @ref MDL_OK on success, @ref MDL_ERROR_EMPTY if the list is empty.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+int mdl_unrolledlist_popcopy(MDLUnrolledList *list, void *buf);
+
+/**
+ * Prepend a new data block to the beginning of the list.
+ *
+ * @param list The list to operate on.
+ *
+ * @return A pointer to the block of memory in the new element, or NULL if allocation
+ *         failed. If the operation fails, the list is unmodified.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+void *mdl_unrolledlist_pushfront(MDLUnrolledList *list);
+
+/**
+ * Remove the element at the front of the list.
+ *
+ * @param list The list to operate on.
+ *
+ * @return @ref MDL_OK on success, @ref MDL_ERROR_EMPTY if the list is empty.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+int mdl_unrolledlist_popfront(MDLUnrolledList *list);
+
+/**
+ * Like @ref mdl_unrolledlist_popfront, but copies the data block to @a buf before
+ * removing the element.
+ *
+ * @param list The list to operate on.
+ * @param[out] buf The buffer to copy the data block to.
+ *
+ * @return @ref MDL_OK on success, @ref MDL_ERROR_EMPTY if the list is empty. If an error
+ *         occurs, @a buf is left unmodified.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+int mdl_unrolledlist_popfrontcopy(MDLUnrolledList *list, void *buf);
+
+/**
+ * Get a pointer to the data block at the given index of the list.
+ *
+ * @param list The list to operate on.
+ * @param index The index of the data to access.
+ * @return A pointer to the data block, or NULL if the index is invalid.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+void *mdl_unrolledlist_getblockat(const MDLUnrolledList *list, size_t index);
+
+/**
+ * Copy @a src to the list element at @a index.
+ *
+ * @param list    The list to operate on.
+ * @param index   The index of the element to modify.
+ * @param[in] src A pointer to the data to copy.
+ *
+ * @return 0 on success, @ref MDL_ERROR_OUT_OF_RANGE if the index is invalid.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+int mdl_unrolledlist_set(MDLUnrolledList *list, size_t index, const void *src);
+
+/**
+ * Insert a new element after the element at @a index.
+ *
+ * If the chunk holding that element is full, it's split in two first.
+ *
+ * @param list The list to operate on.
+ * @param index The index of the element to insert after.
+ * @param[out] ptr
+ *      If not null, receives a pointer to the data block of the new element. This is only
+ *      valid until the list is next modified.
+ * @return 0 on success, @ref MDL_ERROR_OUT_OF_RANGE if the index is invalid, or
+ *         @ref MDL_ERROR_NOMEM if a chunk couldn't be allocated.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL_ARGS(1)
+int mdl_unrolledlist_insertafter(MDLUnrolledList *list, size_t index, void **ptr);
+
+/**
+ * Like @ref mdl_unrolledlist_insertafter, but copies @a buf into the new element.
+ *
+ * @param list The list to operate on.
+ * @param index The index of the element to insert after.
+ * @param[in] buf The data to copy into the new element.
+ * @return Same as @ref mdl_unrolledlist_insertafter.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+int mdl_unrolledlist_insertaftercopy(MDLUnrolledList *list, size_t index,
+                                     const void *buf);
+
+/**
+ * Remove an item from the list.
+ *
+ * If this leaves its chunk less than half full, it's merged with or takes elements from
+ * an adjacent chunk.
+ *
+ * @param list  The list to operate on.
+ * @param index The index of the element to remove.
+ *
+ * @return 0 on success, @ref MDL_ERROR_OUT_OF_RANGE if the index is invalid.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+int mdl_unrolledlist_removeat(MDLUnrolledList *list, size_t index);
+
+/**
+ * Copy the memory block at the given index, then remove it.
+ *
+ * @param list          The list to operate on.
+ * @param index         The index of the element to remove.
+ * @param[out] buf      The buffer that the memory block will be copied to.
+ *
+ * @return 0 on success, @ref MDL_ERROR_OUT_OF_RANGE if the index is invalid. If an error
+ *         occurs, @a buf is unmodified.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+int mdl_unrolledlist_removeatcopy(MDLUnrolledList *list, size_t index, void *buf);
+
+/**
+ * Remove all elements in the list.
+ *
+ * @param list The list to operate on.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+void mdl_unrolledlist_clear(MDLUnrolledList *list);
+
+/**
+ * Search the list for the first data matching @a value.
+ *
+ * @param list The list to search through.
+ * @param value The value to compare the list elements against.
+ * @param cmp A function to use to compare elements against @a value.
+ * @param[out] ptr Receives a pointer to the data block of the first match, if found.
+ *
+ * @return @ref MDL_OK if a match was found, @ref MDL_ERROR_NOT_FOUND otherwise.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+int mdl_unrolledlist_find(const MDLUnrolledList *list, const void *value,
+                          mdl_comparator_fptr cmp, const void **ptr);
+
+/**
+ * Like @ref mdl_unrolledlist_find, but returns the index of the first matching element.
+ *
+ * @param list The list to search through.
+ * @param value The value to compare the list elements against.
+ * @param cmp A function to use to compare elements against @a value.
+ * @return
+ *      The index of the first element matching @a value, or @ref MDL_INVALID_INDEX if no
+ *      match was found.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+size_t mdl_unrolledlist_findindex(const MDLUnrolledList *list, const void *value,
+                                  mdl_comparator_fptr cmp);
+
+/**
+ * Like @ref mdl_unrolledlist_findindex, but searches the list back to front.
+ *
+ * @param list The list to search through.
+ * @param value The value to compare the list elements against.
+ * @param cmp A function to use to compare elements against @a value.
+ * @return
+ *      The index of the last element matching @a value, or @ref MDL_INVALID_INDEX if no
+ *      match was found.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+size_t mdl_unrolledlist_rfindindex(const MDLUnrolledList *list, const void *value,
+                                   mdl_comparator_fptr cmp);
+
+/**
+ * Remove the first element matching @a value.
+ *
+ * @param list The list to operate on.
+ * @param value The value to compare the list elements against.
+ * @param cmp A function to use to compare elements against @a value.
+ * @return 1 if an element was removed, 0 otherwise.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+int mdl_unrolledlist_removevalue(MDLUnrolledList *list, const void *value,
+                                 mdl_comparator_fptr cmp);
+
+MDL_API
+MDL_ANNOTN__NODISCARD
+MDL_ANNOTN__NONNULL
+MDLUnrolledListIterator *mdl_unrolledlist_getiterator(const MDLUnrolledList *list,
+                                                      bool reverse);
+
+MDL_API
+MDL_ANNOTN__NONNULL
+void mdl_unrolledlistiter_init(const MDLUnrolledList *list,
+                               MDLUnrolledListIterator *iter, bool reverse);
+
+/**
+ * Get a pointer to the data block of the current element.
+ *
+ * The return value is undefined if the list is empty.
+ *
+ * @param iter The iterator to operate on.
+ * @return A pointer to the current element's data block.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+void *mdl_unrolledlistiter_get(const MDLUnrolledListIterator *iter);
+
+/**
+ * Advance the iterator to the next element in the input.
+ *
+ * @param iter The iterator to operate on.
+ * @return 0 on success, @ref MDL_EOF if the input has been exhausted.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+int mdl_unrolledlistiter_next(MDLUnrolledListIterator *iter);
+
+/**
+ * Get all elements from the current one to the end of its chunk, and advance the
+ * iterator past them.
+ *
+ * This works just like @ref mdl_arrayiter_nextspan. Elements in a span are always in the
+ * same order they're in the list, so for reverse iterators the span ends at the current
+ * element, and callers should go through it from back to front.
+ *
+ * @param iter The iterator to operate on.
+ * @param[out] span
+ *      Receives a pointer to the data block of the first element of the span. This is
+ *      only valid until the list is modified.
+ * @return The number of elements in the span. This is 0 once all elements have been
+ * visited, in which case @a span is not modified.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+size_t mdl_unrolledlistiter_nextspan(MDLUnrolledListIterator *iter, const void **span);
+
+MDL_API
+MDL_ANNOTN__NONNULL
+bool mdl_unrolledlistiter_hasnext(const MDLUnrolledListIterator *iter);
+
+MDL_API
+MDL_ANNOTN__NONNULL
+void mdl_unrolledlistiter_destroy(MDLUnrolledListIterator *iter);
+
+#endif /* INCLUDE_METALDATA_UNROLLEDLIST_H_ */
@@ -6,9 +6,10 @@
 // file, You can obtain one at https://mozilla.org/MPL/2.0/.
 
 /**
- * An unbuffered output stream abstraction.
+ * An output stream abstraction.
  *
  * The @ref MDLWriter only supports writing individual characters and blocks of memory.
+ * Output is unbuffered unless a staging buffer is set with @ref mdl_writer_setbuffer.
  * Since it's an output-only stream, there is no notion of offset and thus no seek/tell
  * capability. This does, however, provide a way to build these abstractions on top of it.
  *
@@ -34,6 +35,19 @@ typedef struct MDLWriter_ MDLWriter;
  */
 typedef int (*mdl_writer_putc_fptr)(MDLWriter *writer, int chr) MDL_REENTRANT_MARKER;
 
+/**
+ * A pointer to a function that writes a block of bytes to the writer's output.
+ *
+ * @param writer The @ref MDLWriter this function is modifying.
+ * @param data A pointer to the bytes to write.
+ * @param size The number of bytes to write. This is never 0.
+ * @return The number of bytes written. This may be less than @a size if only part of the
+ *         data could be written right away, but 0 means the output can't accept any
+ *         more data.
+ */
+typedef size_t (*mdl_writer_write_fptr)(MDLWriter *writer, const void *data,
+                                        size_t size) MDL_REENTRANT_MARKER;
+
 /**
  * A pointer to a function that closes an open writer.
  *
@@ -51,6 +65,12 @@ struct MDLWriter_
 {
     MDLState *mds;
     mdl_writer_putc_fptr putc_ptr;
+
+    /**
+     * Optional. A pointer to a function that writes a block of bytes. If given,
+     * @ref mdl_writer_write uses this instead of calling @ref putc_ptr once per byte.
+     */
+    mdl_writer_write_fptr write_ptr;
     mdl_writer_close_fptr close_ptr;
     void *udata;
     char *output_buffer;
@@ -68,6 +88,19 @@ struct MDLWriter_
      * If @ref output_buffer is null, this field has no meaning and should not be used.
      */
     size_t buffer_position;
+
+    /**
+     * The staging buffer set with @ref mdl_writer_setbuffer, or NULL if the writer is
+     * unbuffered.
+     */
+    char *staging_buffer;
+    size_t staging_size;
+
+    /** The number of bytes in @ref staging_buffer waiting to be flushed. */
+    size_t staging_length;
+
+    /** Indicates if @ref staging_buffer was allocated by @ref mdl_writer_setbuffer. */
+    bool owns_staging_buffer;
     bool was_allocated;
 };
 
@@ -77,6 +110,24 @@ MDL_ANNOTN__NODISCARD
 MDLWriter *mdl_writer_new(MDLState *mds, mdl_writer_putc_fptr putc_ptr,
                           mdl_writer_close_fptr close_ptr, void *udata);
 
+/**
+ * Allocate a new @ref MDLWriter that writes its output in blocks.
+ *
+ * @param mds The MetalData state.
+ * @param write_ptr
+ *      A pointer to a function that writes a block of bytes to the output. It's also used
+ *      to write single characters, one byte at a time.
+ * @param close_ptr Optional. A function that closes the output stream when called.
+ * @param udata Optional. Arbitrary data retrievable with @ref mdl_writer_getudata.
+ *
+ * @return A new initialized writer.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL_ARGS(1, 2)
+MDL_ANNOTN__NODISCARD
+MDLWriter *mdl_writer_newblockwriter(MDLState *mds, mdl_writer_write_fptr write_ptr,
+                                     mdl_writer_close_fptr close_ptr, void *udata);
+
 /**
  * Allocate a new @ref MDLWriter that writes into a fixed-size buffer.
  *
@@ -96,12 +147,51 @@ MDL_ANNOTN__NONNULL_ARGS(1, 2)
 void mdl_writer_init(MDLState *mds, MDLWriter *writer, mdl_writer_putc_fptr putc_ptr,
                      mdl_writer_close_fptr close_ptr, void *udata);
 
+/**
+ * Initialize an allocated @ref MDLWriter that writes its output in blocks.
+ *
+ * Arguments have the same meanings as @ref mdl_writer_newblockwriter.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL_ARGS(1, 2, 3)
+void mdl_writer_initblockwriter(MDLState *mds, MDLWriter *writer,
+                                mdl_writer_write_fptr write_ptr,
+                                mdl_writer_close_fptr close_ptr, void *udata);
+
 MDL_API
 MDL_ANNOTN__NONNULL
 MDL_ANNOTN__ACCESS_SIZED(write_only, 3, 4)
 void mdl_writer_initwithbuffer(MDLState *mds, MDLWriter *writer, void *buffer,
                                size_t size);
 
+/**
+ * Make the writer collect output in a staging buffer and pass it on in large chunks.
+ *
+ * Without a buffer, every @ref mdl_writer_putc call goes to the output right away. A
+ * buffered writer holds output until the buffer fills up, @ref mdl_writer_flush is
+ * called, or the writer is closed. Writes at least as large as the buffer go straight
+ * to the output after what's already buffered.
+ *
+ * This must be called at most once per writer, and is best done before writing anything.
+ *
+ * @param writer The output stream.
+ * @param buffer
+ *      Optional. The memory to use for the buffer. It must remain valid until the writer
+ *      is closed. If NULL, a buffer of @a size bytes is allocated, and freed when the
+ *      writer is closed.
+ * @param size The size of the buffer, in bytes.
+ *
+ * @return 0 on success, or an error code:
+ *      - @ref MDL_ERROR_INVALID_ARGUMENT: @a size is 0.
+ *      - @ref MDL_ERROR_NOT_SUPPORTED: @a writer writes to a memory buffer, which
+ *        doesn't need buffering.
+ *      - @ref MDL_ERROR_ALREADY_EXISTS: The writer already has a buffer.
+ *      - @ref MDL_ERROR_NOMEM: The buffer couldn't be allocated.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL_ARGS(1)
+int mdl_writer_setbuffer(MDLWriter *writer, void *buffer, size_t size);
+
 MDL_API
 MDL_ANNOTN__NONNULL
 void *mdl_writer_getudata(const MDLWriter *writer);
@@ -122,6 +212,28 @@ MDL_API
 MDL_ANNOTN__NONNULL_ARGS(1)
 void *mdl_writer_getbuffer(const MDLWriter *writer, size_t *p_length);
 
+/**
+ * Write out everything held in the writer's staging buffer.
+ *
+ * This does nothing for writers without a staging buffer.
+ *
+ * @param writer The output stream.
+ * @return 0 on success, @ref MDL_ERROR_FULL if the output didn't accept all the data.
+ *         Whatever wasn't written stays in the buffer.
+ */
+MDL_API
+MDL_ANNOTN__NONNULL
+int mdl_writer_flush(MDLWriter *writer);
+
+/**
+ * Flush and close the writer, and free its resources.
+ *
+ * Do not use @a writer after this function has been called, even if it fails.
+ *
+ * @param writer The output stream.
+ * @return 0 on success, or the error from @ref mdl_writer_flush. Buffered output that
+ *         couldn't be flushed is lost.
+ */
 MDL_API
 MDL_ANNOTN__NONNULL
 int mdl_writer_close(MDLWriter *writer);
@@ -130,6 +242,19 @@ MDL_API
 MDL_ANNOTN__NONNULL
 int mdl_writer_putc(MDLWriter *writer, int chr);
 
+/**
+ * Write a block of memory to the output.
+ *
+ * Writers with a block-write function (including ones writing to a memory buffer) do
+ * this in as few calls as the output allows, instead of one per byte.
+ *
+ * @param writer The output stream.
+ * @param data A pointer to the bytes to write.
+ * @param size The number of bytes to write.
+ *
+ * @return The number of bytes written. If this is less than @a size, the output couldn't
+ *         accept any more data, e.g. because a memory buffer is full.
+ */
 MDL_API
 MDL_ANNOTN__NONNULL
 MDL_ANNOTN__ACCESS_SIZED(read_only, 2, 3)
@@ -7,9 +7,15 @@
 
 #include "metaldata/reader.h"
 #include "metaldata/errors.h"
+#include "metaldata/internal/cstdlib.h"
 #include "metaldata/metaldata.h"
 
 static int buffer_getc(MDLReader *reader, void *udata);
+static size_t buffer_read(MDLReader *reader, void *buf, size_t size, void *udata);
+static int block_getc(MDLReader *reader, void *udata);
+static size_t read_from_source(MDLReader *reader, char *output, size_t size);
+static size_t fill_readahead(MDLReader *reader, size_t n_wanted);
+static size_t take_readahead(MDLReader *reader, char *output, size_t size);
 
 MDLReader *mdl_reader_new(MDLState *mds, mdl_reader_getc_fptr getc_ptr,
                           mdl_reader_close_fptr close_ptr, void *udata)
@@ -23,6 +29,18 @@ MDLReader *mdl_reader_new(MDLState *mds, mdl_reader_getc_fptr getc_ptr,
     return reader;
 }
 
+MDLReader *mdl_reader_newblockreader(MDLState *mds, mdl_reader_read_fptr read_ptr,
+                                     mdl_reader_close_fptr close_ptr, void *udata)
+{
+    MDLReader *reader = mdl_malloc(mds, sizeof(*reader));
+    if (!reader)
+        return NULL;
+
+    mdl_reader_initblockreader(mds, reader, read_ptr, close_ptr, udata);
+    reader->was_allocated = true;
+    return reader;
+}
+
 MDLReader *mdl_reader_newfrombuffer(MDLState *mds, const void *buffer, size_t size)
 {
     MDLReader *reader = mdl_malloc(mds, sizeof(*reader));
@@ -39,23 +57,70 @@ void mdl_reader_init(MDLState *mds, MDLReader *reader, mdl_reader_getc_fptr getc
 {
     reader->mds = mds;
     reader->getc_ptr = getc_ptr;
+    reader->read_ptr = NULL;
     reader->close_ptr = close_ptr;
     reader->udata = udata;
     reader->input_buffer = NULL;
     reader->input_size = 0;
     reader->buffer_position = 0;
     reader->unget_character = MDL_EOF;
+    reader->readahead = NULL;
+    reader->readahead_size = 0;
+    reader->readahead_start = 0;
+    reader->readahead_end = 0;
+    reader->owns_readahead = false;
     reader->was_allocated = false;
 }
 
+void mdl_reader_initblockreader(MDLState *mds, MDLReader *reader,
+                                mdl_reader_read_fptr read_ptr,
+                                mdl_reader_close_fptr close_ptr, void *udata)
+{
+    mdl_reader_init(mds, reader, block_getc, close_ptr, udata);
+    reader->read_ptr = read_ptr;
+}
+
 void mdl_reader_initfrombuffer(MDLState *mds, MDLReader *reader, const void *buffer,
                                size_t size)
 {
     mdl_reader_init(mds, reader, buffer_getc, NULL, NULL);
+    reader->read_ptr = buffer_read;
     reader->input_buffer = buffer;
     reader->input_size = size;
 }
 
+int mdl_reader_setbuffer(MDLReader *reader, void *buffer, size_t size)
+{
+    if (size == 0)
+        return MDL_ERROR_INVALID_ARGUMENT;
+    if (reader->getc_ptr == buffer_getc)
+        return MDL_ERROR_NOT_SUPPORTED;
+    if (reader->readahead != NULL)
+        return MDL_ERROR_ALREADY_EXISTS;
+
+    if (buffer == NULL)
+    {
+        buffer = mdl_malloc(reader->mds, size);
+        if (buffer == NULL)
+            return MDL_ERROR_NOMEM;
+        reader->owns_readahead = true;
+    }
+
+    reader->readahead = buffer;
+    reader->readahead_size = size;
+    reader->readahead_start = 0;
+    reader->readahead_end = 0;
+
+    // From now on pushed-back characters live in the buffer.
+    if (reader->unget_character != MDL_EOF)
+    {
+        reader->readahead[0] = (char)reader->unget_character;
+        reader->readahead_end = 1;
+        reader->unget_character = MDL_EOF;
+    }
+    return MDL_OK;
+}
+
 void *mdl_reader_getudata(const MDLReader *reader)
 {
     return reader->udata;
@@ -65,12 +130,27 @@ void mdl_reader_close(MDLReader *reader)
 {
     if (reader->close_ptr)
         reader->close_ptr(reader, reader->udata);
+    if (reader->owns_readahead)
+        mdl_free(reader->mds, reader->readahead, reader->readahead_size);
     if (reader->was_allocated)
         mdl_free(reader->mds, reader, sizeof(*reader));
 }
 
 int mdl_reader_getc(MDLReader *reader)
 {
+    if (reader->readahead != NULL)
+    {
+        if (fill_readahead(reader, 1) == 0)
+            return MDL_EOF;
+        return (int)(unsigned char)reader->readahead[reader->readahead_start++];
+    }
+
+    if (reader->unget_character != MDL_EOF)
+    {
+        int return_value = reader->unget_character;
+        reader->unget_character = MDL_EOF;
+        return return_value;
+    }
     return reader->getc_ptr(reader, reader->udata);
 }
 
@@ -83,39 +163,236 @@ int mdl_reader_peekc(MDLReader *reader)
 
 int mdl_reader_ungetc(MDLReader *reader, int chr)
 {
+    if (reader->readahead != NULL)
+    {
+        // Putting back EOF (e.g. from peekc() at the end of the input) does nothing, same
+        // as for unbuffered readers.
+        if (chr < 0)
+            return MDL_OK;
+
+        if (reader->readahead_start == 0)
+        {
+            if (reader->readahead_end == reader->readahead_size)
+                return MDL_ERROR_FULL;
+            mdl_memmove(reader->readahead + 1, reader->readahead, reader->readahead_end);
+            reader->readahead_start = 1;
+            reader->readahead_end++;
+        }
+        reader->readahead[--reader->readahead_start] = (char)chr;
+        return MDL_OK;
+    }
+
     if (reader->unget_character != MDL_EOF)
         return MDL_ERROR_ALREADY_EXISTS;
 
+    // If we're putting back the byte we just read from a buffer, back up instead of
+    // storing it. This keeps the buffer usable by mdl_reader_borrow().
+    if (reader->getc_ptr == buffer_getc && chr >= 0 && reader->buffer_position > 0 &&
+        (unsigned char)reader->input_buffer[reader->buffer_position - 1] == chr)
+    {
+        reader->buffer_position--;
+        return MDL_OK;
+    }
+
     reader->unget_character = chr;
     return MDL_OK;
 }
 
 size_t mdl_reader_read(MDLReader *reader, void *buf, size_t size)
 {
-    char *current_byte = (char *)buf;
+    char *output = (char *)buf;
+    size_t n_read = 0;
 
-    for (size_t i = 0; i < size; i++, current_byte++)
+    if (size == 0)
+        return 0;
+
+    if (reader->readahead != NULL)
     {
-        int value = mdl_reader_getc(reader);
-        if (value == MDL_EOF)
-            return i;
+        n_read = take_readahead(reader, output, size);
 
-        *current_byte = (char)value;
+        // Reads at least as big as the buffer go straight to the source, since going
+        // through the buffer would only add a copy.
+        if (size - n_read < reader->readahead_size)
+        {
+            fill_readahead(reader, size - n_read);
+            return n_read + take_readahead(reader, output + n_read, size - n_read);
+        }
     }
-    return size;
+    else if (reader->unget_character != MDL_EOF)
+    {
+        output[0] = (char)reader->unget_character;
+        reader->unget_character = MDL_EOF;
+        n_read = 1;
+    }
+
+    return n_read + read_from_source(reader, output + n_read, size - n_read);
 }
 
-static int buffer_getc(MDLReader *reader, void *udata)
+int mdl_reader_borrow(MDLReader *reader, size_t size, const void **ptr, size_t *length)
 {
-    (void)udata;
+    if (reader->getc_ptr != buffer_getc || reader->unget_character != MDL_EOF)
+        return MDL_ERROR_NOT_SUPPORTED;
 
-    if (reader->unget_character != MDL_EOF)
+    size_t n_remaining = reader->input_size - reader->buffer_position;
+    if (size > n_remaining)
+        size = n_remaining;
+
+    *ptr = reader->input_buffer + reader->buffer_position;
+    *length = size;
+    reader->buffer_position += size;
+    return MDL_OK;
+}
+
+int mdl_reader_lookahead(MDLReader *reader, size_t size, const void **ptr,
+                         size_t *length)
+{
+    if (reader->getc_ptr == buffer_getc && reader->unget_character == MDL_EOF)
     {
-        int return_value = reader->unget_character;
-        reader->unget_character = MDL_EOF;
-        return return_value;
+        size_t n_remaining = reader->input_size - reader->buffer_position;
+        *ptr = reader->input_buffer + reader->buffer_position;
+        *length = (size < n_remaining) ? size : n_remaining;
+        return MDL_OK;
     }
+
+    if (reader->readahead == NULL)
+        return MDL_ERROR_NOT_SUPPORTED;
+    if (size > reader->readahead_size)
+        return MDL_ERROR_OUT_OF_RANGE;
+
+    size_t n_buffered = fill_readahead(reader, size);
+    *ptr = reader->readahead + reader->readahead_start;
+    *length = (size < n_buffered) ? size : n_buffered;
+    return MDL_OK;
+}
+
+static int buffer_getc(MDLReader *reader, void *udata)
+{
+    (void)udata;
+
     if (reader->buffer_position >= reader->input_size)
         return MDL_EOF;
-    return (int)reader->input_buffer[reader->buffer_position++];
+    return (int)(unsigned char)reader->input_buffer[reader->buffer_position++];
+}
+
+static int block_getc(MDLReader *reader, void *udata)
+{
+    unsigned char value;
+
+    if (reader->read_ptr(reader, &value, 1, udata) == 0)
+        return MDL_EOF;
+    return (int)value;
+}
+
+static size_t buffer_read(MDLReader *reader, void *buf, size_t size, void *udata)
+{
+    (void)udata;
+
+    size_t n_remaining = reader->input_size - reader->buffer_position;
+    if (size > n_remaining)
+        size = n_remaining;
+
+    mdl_memcpy(buf, reader->input_buffer + reader->buffer_position, size);
+    reader->buffer_position += size;
+    return size;
+}
+
+/**
+ * Read up to @a size bytes from the reader's source, bypassing any buffering.
+ *
+ * @return The number of bytes read. This is less than @a size only at the end of input.
+ */
+static size_t read_from_source(MDLReader *reader, char *output, size_t size)
+{
+    size_t n_read = 0;
+
+    // Sources that can only give us one byte at a time.
+    if (reader->read_ptr == NULL)
+    {
+        for (; n_read < size; n_read++)
+        {
+            int value = reader->getc_ptr(reader, reader->udata);
+            if (value < 0)
+                break;
+            output[n_read] = (char)value;
+        }
+        return n_read;
+    }
+
+    // Block reads may be short without the input being exhausted, so keep going until
+    // we either have everything or the source tells us there's nothing left.
+    while (n_read < size)
+    {
+        size_t n_chunk =
+            reader->read_ptr(reader, output + n_read, size - n_read, reader->udata);
+        if (n_chunk == 0)
+            break;
+        n_read += n_chunk;
+    }
+    return n_read;
+}
+
+/**
+ * Make sure at least @a n_wanted bytes are in the read-ahead buffer, if the input has
+ * that many left.
+ *
+ * Block sources are asked to fill all the free space in the buffer, so this usually
+ * reads much more than @a n_wanted. Sources that only have getc are read one byte at a
+ * time and only as far as needed, so that we never wait on input nobody asked for.
+ *
+ * @param reader The reader to operate on. It must have a read-ahead buffer.
+ * @param n_wanted The number of bytes needed. Must be at most the buffer's size.
+ * @return The number of unread bytes in the buffer.
+ */
+static size_t fill_readahead(MDLReader *reader, size_t n_wanted)
+{
+    size_t n_buffered = reader->readahead_end - reader->readahead_start;
+    if (n_buffered >= n_wanted)
+        return n_buffered;
+
+    // Move what's left to the front of the buffer to make as much room as we can.
+    mdl_memmove(reader->readahead, reader->readahead + reader->readahead_start,
+                n_buffered);
+    reader->readahead_start = 0;
+    reader->readahead_end = n_buffered;
+
+    while (reader->readahead_end < n_wanted)
+    {
+        char *free_space = reader->readahead + reader->readahead_end;
+
+        if (reader->read_ptr != NULL)
+        {
+            size_t n_chunk =
+                reader->read_ptr(reader, free_space,
+                                 reader->readahead_size - reader->readahead_end,
+                                 reader->udata);
+            if (n_chunk == 0)
+                break;
+            reader->readahead_end += n_chunk;
+        }
+        else
+        {
+            int value = reader->getc_ptr(reader, reader->udata);
+            if (value < 0)
+                break;
+            *free_space = (char)value;
+            reader->readahead_end++;
+        }
+    }
+    return reader->readahead_end;
+}
+
+/**
+ * Copy up to @a size unread bytes out of the read-ahead buffer and consume them.
+ *
+ * @return The number of bytes copied.
+ */
+static size_t take_readahead(MDLReader *reader, char *output, size_t size)
+{
+    size_t n_buffered = reader->readahead_end - reader->readahead_start;
+    if (size > n_buffered)
+        size = n_buffered;
+
+    mdl_memcpy(output, reader->readahead + reader->readahead_start, size);
+    reader->readahead_start += size;
+    return size;
 }
@@ -0,0 +1,752 @@
+// SPDX-License-Identifier: MPL-2.0+
+// Copyright (C) 2020-2025  Diego Argueta
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "metaldata/unrolledlist.h"
+#include "metaldata/errors.h"
+#include "metaldata/internal/cstdlib.h"
+#include "metaldata/metaldata.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+MDL_ANNOTN__NONNULL
+MDL_ANNOTN__REPRODUCIBLE
+static size_t get_chunk_size(const MDLUnrolledList *list);
+
+MDL_ANNOTN__NONNULL
+MDL_ANNOTN__RETURNS_NONNULL
+static void *get_slot(const MDLUnrolledList *list, const MDLUnrolledListChunk *chunk,
+                      size_t chunk_element_index);
+
+MDL_ANNOTN__NONNULL
+MDL_ANNOTN__RETURNS_NONNULL
+static MDLUnrolledListChunk *find_chunk(const MDLUnrolledList *list, size_t index,
+                                        size_t *chunk_element_index);
+
+MDL_ANNOTN__NONNULL_ARGS(1)
+static MDLUnrolledListChunk *insert_new_chunk(MDLUnrolledList *list,
+                                              MDLUnrolledListChunk *prev);
+
+MDL_ANNOTN__NONNULL
+static void free_chunk(MDLUnrolledList *list, MDLUnrolledListChunk *chunk);
+
+MDL_ANNOTN__NONNULL
+static void *insert_element(MDLUnrolledList *list, size_t index);
+
+MDL_ANNOTN__NONNULL
+static void remove_element(MDLUnrolledList *list, MDLUnrolledListChunk *chunk,
+                           size_t chunk_element_index);
+
+MDL_ANNOTN__NONNULL
+static void rebalance_chunk(MDLUnrolledList *list, MDLUnrolledListChunk *chunk);
+
+MDL_ANNOTN__NONNULL
+static size_t find_element(const MDLUnrolledList *list, const void *value,
+                           mdl_comparator_fptr cmp, bool reverse,
+                           MDLUnrolledListChunk **chunk, size_t *chunk_element_index);
+
+int mdl_unrolledlist_init(MDLState *mds, MDLUnrolledList *list, size_t elem_size)
+{
+    return mdl_unrolledlist_initwithchunkcapacity(
+        mds, list, elem_size, MDL_DEFAULT_UNROLLEDLIST_CHUNK_CAPACITY);
+}
+
+int mdl_unrolledlist_initwithchunkcapacity(MDLState *mds, MDLUnrolledList *list,
+                                           size_t elem_size, size_t chunk_capacity)
+{
+    // A chunk needs room for at least two elements so that splitting a full one always
+    // leaves room in both halves.
+    if (chunk_capacity < 2)
+        return MDL_ERROR_INVALID_ARGUMENT;
+
+    if ((elem_size != 0) &&
+        (chunk_capacity > (SIZE_MAX - sizeof(MDLUnrolledListChunk)) / elem_size))
+        return MDL_ERROR_INVALID_ARGUMENT;
+
+    list->was_allocated = false;
+    list->mds = mds;
+    list->head = NULL;
+    list->tail = NULL;
+    list->elem_size = elem_size;
+    list->chunk_capacity = chunk_capacity;
+    list->length = 0;
+    list->n_chunks = 0;
+    return MDL_OK;
+}
+
+MDLUnrolledList *mdl_unrolledlist_new(MDLState *mds, size_t elem_size)
+{
+    return mdl_unrolledlist_newwithchunkcapacity(mds, elem_size,
+                                                 MDL_DEFAULT_UNROLLEDLIST_CHUNK_CAPACITY);
+}
+
+MDLUnrolledList *mdl_unrolledlist_newwithchunkcapacity(MDLState *mds, size_t elem_size,
+                                                       size_t chunk_capacity)
+{
+    MDLUnrolledList *list = mdl_malloc(mds, sizeof(*list));
+    if (list == NULL)
+        return NULL;
+
+    if (mdl_unrolledlist_initwithchunkcapacity(mds, list, elem_size, chunk_capacity) !=
+        MDL_OK)
+    {
+        mdl_free(mds, list, sizeof(*list));
+        return NULL;
+    }
+
+    list->was_allocated = true;
+    return list;
+}
+
+int mdl_unrolledlist_destroy(MDLUnrolledList *list)
+{
+    mdl_unrolledlist_clear(list);
+    if (list->was_allocated)
+        mdl_free(list->mds, list, sizeof(*list));
+    return MDL_OK;
+}
+
+size_t mdl_unrolledlist_length(const MDLUnrolledList *list)
+{
+    return list->length;
+}
+
+size_t mdl_unrolledlist_getelementsize(const MDLUnrolledList *list)
+{
+    return list->elem_size;
+}
+
+void *mdl_unrolledlist_head(const MDLUnrolledList *list)
+{
+    if (list->head == NULL)
+        return NULL;
+    return list->head->data;
+}
+
+void *mdl_unrolledlist_tail(const MDLUnrolledList *list)
+{
+    if (list->tail == NULL)
+        return NULL;
+    return get_slot(list, list->tail, list->tail->length - 1);
+}
+
+void *mdl_unrolledlist_push(MDLUnrolledList *list)
+{
+    MDLUnrolledListChunk *chunk = list->tail;
+    if ((chunk == NULL) || (chunk->length == list->chunk_capacity))
+    {
+        chunk = insert_new_chunk(list, list->tail);
+        if (chunk == NULL)
+            return NULL;
+    }
+
+    list->length++;
+    return get_slot(list, chunk, chunk->length++);
+}
+
+int mdl_unrolledlist_pop(MDLUnrolledList *list)
+{
+    MDLUnrolledListChunk *chunk = list->tail;
+    if (chunk == NULL)
+        return MDL_ERROR_EMPTY;
+
+    // Removing the last element never moves anything, so we don't bother rebalancing. The
+    // chunk is freed once it's empty.
+    chunk->length--;
+    list->length--;
+    if (chunk->length == 0)
+        free_chunk(list, chunk);
+    return MDL_OK;
+}
+
+int mdl_unrolledlist_popcopy(MDLUnrolledList *list, void *buf)
+{
+    void *tail = mdl_unrolledlist_tail(list);
+    if (tail == NULL)
+        return MDL_ERROR_EMPTY;
+
+    mdl_memcpy(buf, tail, list->elem_size);
+    return mdl_unrolledlist_pop(list);
+}
+
+void *mdl_unrolledlist_pushfront(MDLUnrolledList *list)
+{
+    MDLUnrolledListChunk *chunk = list->head;
+    if ((chunk == NULL) || (chunk->length == list->chunk_capacity))
+    {
+        chunk = insert_new_chunk(list, NULL);
+        if (chunk == NULL)
+            return NULL;
+    }
+    else
+    {
+        mdl_memmove(get_slot(list, chunk, 1), chunk->data,
+                    chunk->length * list->elem_size);
+    }
+
+    chunk->length++;
+    list->length++;
+    return chunk->data;
+}
+
+int mdl_unrolledlist_popfront(MDLUnrolledList *list)
+{
+    MDLUnrolledListChunk *chunk = list->head;
+    if (chunk == NULL)
+        return MDL_ERROR_EMPTY;
+
+    chunk->length--;
+    list->length--;
+    if (chunk->length == 0)
+        free_chunk(list, chunk);
+    else
+    {
+        mdl_memmove(chunk->data, get_slot(list, chunk, 1),
+                    chunk->length * list->elem_size);
+    }
+    return MDL_OK;
+}
+
+int mdl_unrolledlist_popfrontcopy(MDLUnrolledList *list, void *buf)
+{
+    if (list->head == NULL)
+        return MDL_ERROR_EMPTY;
+
+    mdl_memcpy(buf, list->head->data, list->elem_size);
+    return mdl_unrolledlist_popfront(list);
+}
+
+void *mdl_unrolledlist_getblockat(const MDLUnrolledList *list, size_t index)
+{
+    if (index >= list->length)
+        return NULL;
+
+    size_t chunk_element_index;
+    const MDLUnrolledListChunk *chunk = find_chunk(list, index, &chunk_element_index);
+    return get_slot(list, chunk, chunk_element_index);
+}
+
+int mdl_unrolledlist_set(MDLUnrolledList *list, size_t index, const void *src)
+{
+    void *block = mdl_unrolledlist_getblockat(list, index);
+    if (block == NULL)
+        return MDL_ERROR_OUT_OF_RANGE;
+
+    mdl_memcpy(block, src, list->elem_size);
+    return MDL_OK;
+}
+
+int mdl_unrolledlist_insertafter(MDLUnrolledList *list, size_t index, void **ptr)
+{
+    if (index >= list->length)
+        return MDL_ERROR_OUT_OF_RANGE;
+
+    void *block = insert_element(list, index + 1);
+    if (block == NULL)
+        return MDL_ERROR_NOMEM;
+
+    if (ptr != NULL)
+        *ptr = block;
+    return MDL_OK;
+}
+
+int mdl_unrolledlist_insertaftercopy(MDLUnrolledList *list, size_t index,
+                                     const void *buf)
+{
+    void *block;
+    int result = mdl_unrolledlist_insertafter(list, index, &block);
+    if (result != MDL_OK)
+        return result;
+
+    mdl_memcpy(block, buf, list->elem_size);
+    return MDL_OK;
+}
+
+int mdl_unrolledlist_removeat(MDLUnrolledList *list, size_t index)
+{
+    if (index >= list->length)
+        return MDL_ERROR_OUT_OF_RANGE;
+
+    size_t chunk_element_index;
+    MDLUnrolledListChunk *chunk = find_chunk(list, index, &chunk_element_index);
+    remove_element(list, chunk, chunk_element_index);
+    return MDL_OK;
+}
+
+int mdl_unrolledlist_removeatcopy(MDLUnrolledList *list, size_t index, void *buf)
+{
+    if (index >= list->length)
+        return MDL_ERROR_OUT_OF_RANGE;
+
+    size_t chunk_element_index;
+    MDLUnrolledListChunk *chunk = find_chunk(list, index, &chunk_element_index);
+    mdl_memcpy(buf, get_slot(list, chunk, chunk_element_index), list->elem_size);
+    remove_element(list, chunk, chunk_element_index);
+    return MDL_OK;
+}
+
+void mdl_unrolledlist_clear(MDLUnrolledList *list)
+{
+    size_t chunk_size = get_chunk_size(list);
+    MDLUnrolledListChunk *chunk = list->head;
+
+    while (chunk != NULL)
+    {
+        MDLUnrolledListChunk *next = chunk->next;
+        mdl_free(list->mds, chunk, chunk_size);
+        chunk = next;
+    }
+
+    list->head = NULL;
+    list->tail = NULL;
+    list->length = 0;
+    list->n_chunks = 0;
+}
+
+int mdl_unrolledlist_find(const MDLUnrolledList *list, const void *value,
+                          mdl_comparator_fptr cmp, const void **ptr)
+{
+    MDLUnrolledListChunk *chunk;
+    size_t chunk_element_index;
+
+    if (find_element(list, value, cmp, false, &chunk, &chunk_element_index) ==
+        MDL_INVALID_INDEX)
+        return MDL_ERROR_NOT_FOUND;
+
+    *ptr = get_slot(list, chunk, chunk_element_index);
+    return MDL_OK;
+}
+
+size_t mdl_unrolledlist_findindex(const MDLUnrolledList *list, const void *value,
+                                  mdl_comparator_fptr cmp)
+{
+    MDLUnrolledListChunk *chunk;
+    size_t chunk_element_index;
+    return find_element(list, value, cmp, false, &chunk, &chunk_element_index);
+}
+
+size_t mdl_unrolledlist_rfindindex(const MDLUnrolledList *list, const void *value,
+                                   mdl_comparator_fptr cmp)
+{
+    MDLUnrolledListChunk *chunk;
+    size_t chunk_element_index;
+    return find_element(list, value, cmp, true, &chunk, &chunk_element_index);
+}
+
+int mdl_unrolledlist_removevalue(MDLUnrolledList *list, const void *value,
+                                 mdl_comparator_fptr cmp)
+{
+    MDLUnrolledListChunk *chunk;
+    size_t chunk_element_index;
+
+    if (find_element(list, value, cmp, false, &chunk, &chunk_element_index) ==
+        MDL_INVALID_INDEX)
+        return 0;
+
+    remove_element(list, chunk, chunk_element_index);
+    return 1;
+}
+
+MDLUnrolledListIterator *mdl_unrolledlist_getiterator(const MDLUnrolledList *list,
+                                                      bool reverse)
+{
+    MDLUnrolledListIterator *iter = mdl_malloc(list->mds, sizeof(*iter));
+    if (iter == NULL)
+        return NULL;
+
+    mdl_unrolledlistiter_init(list, iter, reverse);
+    iter->was_allocated = true;
+    return iter;
+}
+
+void mdl_unrolledlistiter_init(const MDLUnrolledList *list,
+                               MDLUnrolledListIterator *iter, bool reverse)
+{
+    iter->list = list;
+    iter->reverse = reverse;
+    iter->was_allocated = false;
+    iter->n_remaining = list->length;
+
+    if (!reverse)
+    {
+        iter->chunk = list->head;
+        iter->chunk_element_index = 0;
+    }
+    else
+    {
+        iter->chunk = list->tail;
+        iter->chunk_element_index = (list->tail == NULL) ? 0 : list->tail->length - 1;
+    }
+}
+
+void *mdl_unrolledlistiter_get(const MDLUnrolledListIterator *iter)
+{
+    // As with the array iterator, calling this on an empty list is undefined so we don't
+    // check for it.
+    return get_slot(iter->list, iter->chunk, iter->chunk_element_index);
+}
+
+int mdl_unrolledlistiter_next(MDLUnrolledListIterator *iter)
+{
+    if (iter->n_remaining <= 1)
+        return MDL_EOF;
+
+    iter->n_remaining--;
+    if (!iter->reverse)
+    {
+        iter->chunk_element_index++;
+        if (iter->chunk_element_index == iter->chunk->length)
+        {
+            iter->chunk = iter->chunk->next;
+            iter->chunk_element_index = 0;
+        }
+    }
+    else
+    {
+        if (iter->chunk_element_index == 0)
+        {
+            iter->chunk = iter->chunk->prev;
+            iter->chunk_element_index = iter->chunk->length;
+        }
+        iter->chunk_element_index--;
+    }
+    return MDL_OK;
+}
+
+size_t mdl_unrolledlistiter_nextspan(MDLUnrolledListIterator *iter, const void **span)
+{
+    if (iter->n_remaining == 0)
+        return 0;
+
+    size_t first_element_index;
+    size_t span_length;
+
+    if (!iter->reverse)
+    {
+        span_length = iter->chunk->length - iter->chunk_element_index;
+        first_element_index = iter->chunk_element_index;
+    }
+    else
+    {
+        span_length = iter->chunk_element_index + 1;
+        first_element_index = 0;
+    }
+
+    *span = get_slot(iter->list, iter->chunk, first_element_index);
+    iter->n_remaining -= span_length;
+
+    // If that was the last span, leave the iterator on the last element like we do when
+    // calling next(). Otherwise, move to the adjacent chunk.
+    if (iter->n_remaining == 0)
+    {
+        if (!iter->reverse)
+            iter->chunk_element_index = iter->chunk->length - 1;
+        else
+            iter->chunk_element_index = 0;
+    }
+    else if (!iter->reverse)
+    {
+        iter->chunk = iter->chunk->next;
+        iter->chunk_element_index = 0;
+    }
+    else
+    {
+        iter->chunk = iter->chunk->prev;
+        iter->chunk_element_index = iter->chunk->length - 1;
+    }
+    return span_length;
+}
+
+bool mdl_unrolledlistiter_hasnext(const MDLUnrolledListIterator *iter)
+{
+    return iter->n_remaining > 1;
+}
+
+void mdl_unrolledlistiter_destroy(MDLUnrolledListIterator *iter)
+{
+    if (iter->was_allocated)
+        mdl_free(iter->list->mds, iter, sizeof(*iter));
+}
+
+/******** Helper functions ********/
+
+static size_t get_chunk_size(const MDLUnrolledList *list)
+{
+    return sizeof(MDLUnrolledListChunk) + (list->chunk_capacity * list->elem_size);
+}
+
+static void *get_slot(const MDLUnrolledList *list, const MDLUnrolledListChunk *chunk,
+                      size_t chunk_element_index)
+{
+    return (char *)chunk->data + (chunk_element_index * list->elem_size);
+}
+
+/**
+ * Find the chunk containing the element at @a index, starting from whichever end of the
+ * list is closer.
+ *
+ * @param list The list to search. @a index must be valid.
+ * @param index The index of the element to find.
+ * @param[out] chunk_element_index Receives the index of the element within the chunk.
+ * @return The chunk containing the element.
+ */
+static MDLUnrolledListChunk *find_chunk(const MDLUnrolledList *list, size_t index,
+                                        size_t *chunk_element_index)
+{
+    MDLUnrolledListChunk *chunk;
+
+    if (index < list->length / 2)
+    {
+        chunk = list->head;
+        while (index >= chunk->length)
+        {
+            index -= chunk->length;
+            chunk = chunk->next;
+        }
+        *chunk_element_index = index;
+    }
+    else
+    {
+        // Count backwards from the end of the list. The element is `from_end` elements
+        // before the end of the chunk we stop on, and this is always at least 1.
+        size_t from_end = list->length - index;
+        chunk = list->tail;
+        while (from_end > chunk->length)
+        {
+            from_end -= chunk->length;
+            chunk = chunk->prev;
+        }
+        *chunk_element_index = chunk->length - from_end;
+    }
+    return chunk;
+}
+
+/**
+ * Allocate an empty chunk and link it into the list after @a prev.
+ *
+ * @param list The list to operate on.
+ * @param prev The chunk to insert the new one after, or NULL to put it at the beginning.
+ * @return The new chunk, or NULL if allocation failed.
+ */
+static MDLUnrolledListChunk *insert_new_chunk(MDLUnrolledList *list,
+                                              MDLUnrolledListChunk *prev)
+{
+    MDLUnrolledListChunk *chunk = mdl_malloc(list->mds, get_chunk_size(list));
+    if (chunk == NULL)
+        return NULL;
+
+    chunk->length = 0;
+    chunk->prev = prev;
+    if (prev == NULL)
+    {
+        chunk->next = list->head;
+        list->head = chunk;
+    }
+    else
+    {
+        chunk->next = prev->next;
+        prev->next = chunk;
+    }
+
+    if (chunk->next == NULL)
+        list->tail = chunk;
+    else
+        chunk->next->prev = chunk;
+
+    list->n_chunks++;
+    return chunk;
+}
+
+static void free_chunk(MDLUnrolledList *list, MDLUnrolledListChunk *chunk)
+{
+    if (chunk->prev == NULL)
+        list->head = chunk->next;
+    else
+        chunk->prev->next = chunk->next;
+
+    if (chunk->next == NULL)
+        list->tail = chunk->prev;
+    else
+        chunk->next->prev = chunk->prev;
+
+    list->n_chunks--;
+    mdl_free(list->mds, chunk, get_chunk_size(list));
+}
+
+/**
+ * Make room for a new element at @a index, splitting a full chunk if needed.
+ *
+ * @param list The list to operate on.
+ * @param index The index the new element will have. Must be in `[0, length]`.
+ * @return A pointer to the new element's data block, or NULL if a chunk couldn't be
+ *         allocated. If this fails, the list is unmodified.
+ */
+static void *insert_element(MDLUnrolledList *list, size_t index)
+{
+    if (index == list->length)
+        return mdl_unrolledlist_push(list);
+
+    size_t chunk_element_index;
+    MDLUnrolledListChunk *chunk = find_chunk(list, index, &chunk_element_index);
+
+    if (chunk->length == list->chunk_capacity)
+    {
+        // Move the upper half of the chunk into a new one right after it, then insert the
+        // element into whichever half it belongs in. Both halves have room now.
+        MDLUnrolledListChunk *new_chunk = insert_new_chunk(list, chunk);
+        if (new_chunk == NULL)
+            return NULL;
+
+        size_t n_to_move = chunk->length / 2;
+        size_t n_to_keep = chunk->length - n_to_move;
+
+        mdl_memcpy(new_chunk->data, get_slot(list, chunk, n_to_keep),
+                   n_to_move * list->elem_size);
+        new_chunk->length = n_to_move;
+        chunk->length = n_to_keep;
+
+        if (chunk_element_index > n_to_keep)
+        {
+            chunk = new_chunk;
+            chunk_element_index -= n_to_keep;
+        }
+    }
+
+    void *slot = get_slot(list, chunk, chunk_element_index);
+    mdl_memmove(get_slot(list, chunk, chunk_element_index + 1), slot,
+                (chunk->length - chunk_element_index) * list->elem_size);
+    chunk->length++;
+    list->length++;
+    return slot;
+}
+
+static void remove_element(MDLUnrolledList *list, MDLUnrolledListChunk *chunk,
+                           size_t chunk_element_index)
+{
+    mdl_memmove(get_slot(list, chunk, chunk_element_index),
+                get_slot(list, chunk, chunk_element_index + 1),
+                (chunk->length - chunk_element_index - 1) * list->elem_size);
+    chunk->length--;
+    list->length--;
+
+    if (chunk->length == 0)
+        free_chunk(list, chunk);
+    else
+        rebalance_chunk(list, chunk);
+}
+
+/**
+ * If @a chunk is less than half full, merge it with an adjacent chunk or move elements
+ * over from one.
+ *
+ * Without this, removing elements from the middle of the list could leave it with one
+ * element per chunk, which is worse than a plain linked list.
+ */
+static void rebalance_chunk(MDLUnrolledList *list, MDLUnrolledListChunk *chunk)
+{
+    if (chunk->length >= list->chunk_capacity / 2)
+        return;
+
+    MDLUnrolledListChunk *first;
+    MDLUnrolledListChunk *second;
+
+    if (chunk->next != NULL)
+    {
+        first = chunk;
+        second = chunk->next;
+    }
+    else if (chunk->prev != NULL)
+    {
+        first = chunk->prev;
+        second = chunk;
+    }
+    else
+        return;
+
+    if (first->length + second->length <= list->chunk_capacity)
+    {
+        // Both fit in one chunk.
+        mdl_memcpy(get_slot(list, first, first->length), second->data,
+                   second->length * list->elem_size);
+        first->length += second->length;
+        free_chunk(list, second);
+    }
+    else if (first == chunk)
+    {
+        // The next chunk is more than half full. Take elements from its front so that
+        // both end up at least half full.
+        size_t n_to_move = (second->length - first->length) / 2;
+        mdl_memcpy(get_slot(list, first, first->length), second->data,
+                   n_to_move * list->elem_size);
+        mdl_memmove(second->data, get_slot(list, second, n_to_move),
+                    (second->length - n_to_move) * list->elem_size);
+        first->length += n_to_move;
+        second->length -= n_to_move;
+    }
+    else
+    {
+        // Same as above, but take elements from the back of the previous chunk.
+        size_t n_to_move = (first->length - second->length) / 2;
+        mdl_memmove(get_slot(list, second, n_to_move), second->data,
+                    second->length * list->elem_size);
+        mdl_memcpy(second->data, get_slot(list, first, first->length - n_to_move),
+                   n_to_move * list->elem_size);
+        first->length -= n_to_move;
+        second->length += n_to_move;
+    }
+}
+
+/**
+ * Find the first (or last, if @a reverse is true) element matching @a value.
+ *
+ * @return The index of the matching element, or @ref MDL_INVALID_INDEX if there isn't
+ *         one. If an element was found, @a chunk and @a chunk_element_index are set to
+ *         its location.
+ */
+static size_t find_element(const MDLUnrolledList *list, const void *value,
+                           mdl_comparator_fptr cmp, bool reverse,
+                           MDLUnrolledListChunk **chunk, size_t *chunk_element_index)
+{
+    if (!reverse)
+    {
+        size_t index = 0;
+        for (MDLUnrolledListChunk *current = list->head; current != NULL;
+             current = current->next)
+        {
+            for (size_t i = 0; i < current->length; i++, index++)
+            {
+                if (cmp(list->mds, get_slot(list, current, i), value, list->elem_size) ==
+                    0)
+                {
+                    *chunk = current;
+                    *chunk_element_index = i;
+                    return index;
+                }
+            }
+        }
+    }
+    else
+    {
+        size_t index = list->length;
+        for (MDLUnrolledListChunk *current = list->tail; current != NULL;
+             current = current->prev)
+        {
+            for (size_t i = current->length; i > 0; i--)
+            {
+                index--;
+                if (cmp(list->mds, get_slot(list, current, i - 1), value,
+                        list->elem_size) == 0)
+                {
+                    *chunk = current;
+                    *chunk_element_index = i - 1;
+                    return index;
+                }
+            }
+        }
+    }
+    return MDL_INVALID_INDEX;
+}
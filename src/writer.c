@@ -7,6 +7,7 @@
 
 #include "metaldata/writer.h"
 #include "metaldata/errors.h"
+#include "metaldata/internal/cstdlib.h"
 #include "metaldata/metaldata.h"
 
 /**
@@ -16,6 +17,32 @@
  */
 static int memory_putc(MDLWriter *writer, int chr);
 
+/**
+ * A default write function that copies a block of bytes to memory.
+ *
+ * @return The number of bytes copied, which is less than @a size if the buffer is full.
+ */
+static size_t memory_write(MDLWriter *writer, const void *data, size_t size);
+
+/**
+ * The putc function for writers created with a block-write function.
+ */
+static int block_putc(MDLWriter *writer, int chr);
+
+/**
+ * Write a block of bytes to the writer's output, bypassing any staging buffer.
+ *
+ * @return The number of bytes written.
+ */
+static size_t write_to_output(MDLWriter *writer, const char *data, size_t size);
+
+/**
+ * Copy as much of @a data as fits into the writer's staging buffer.
+ *
+ * @return The number of bytes copied.
+ */
+static size_t stage(MDLWriter *writer, const char *data, size_t size);
+
 MDLWriter *mdl_writer_new(MDLState *mds, mdl_writer_putc_fptr putc_ptr,
                           mdl_writer_close_fptr close_ptr, void *udata)
 {
@@ -24,6 +51,19 @@ MDLWriter *mdl_writer_new(MDLState *mds, mdl_writer_putc_fptr putc_ptr,
         return NULL;
 
     mdl_writer_init(mds, writer, putc_ptr, close_ptr, udata);
+    writer->was_allocated = true;
+    return writer;
+}
+
+MDLWriter *mdl_writer_newblockwriter(MDLState *mds, mdl_writer_write_fptr write_ptr,
+                                     mdl_writer_close_fptr close_ptr, void *udata)
+{
+    MDLWriter *writer = mdl_malloc(mds, sizeof(*writer));
+    if (writer == NULL)
+        return NULL;
+
+    mdl_writer_initblockwriter(mds, writer, write_ptr, close_ptr, udata);
+    writer->was_allocated = true;
     return writer;
 }
 
@@ -34,6 +74,7 @@ MDLWriter *mdl_writer_newwithbuffer(MDLState *mds, void *buffer, size_t size)
         return NULL;
 
     mdl_writer_initwithbuffer(mds, writer, buffer, size);
+    writer->was_allocated = true;
     return writer;
 }
 
@@ -45,22 +86,59 @@ void mdl_writer_init(MDLState *mds, MDLWriter *writer, mdl_writer_putc_fptr putc
 
     writer->mds = mds;
     writer->putc_ptr = putc_ptr;
+    writer->write_ptr = NULL;
     writer->close_ptr = close_ptr;
     writer->udata = udata;
     writer->output_buffer = NULL;
     writer->buffer_size = 0;
     writer->buffer_position = 0;
+    writer->staging_buffer = NULL;
+    writer->staging_size = 0;
+    writer->staging_length = 0;
+    writer->owns_staging_buffer = false;
     writer->was_allocated = false;
 }
 
+void mdl_writer_initblockwriter(MDLState *mds, MDLWriter *writer,
+                                mdl_writer_write_fptr write_ptr,
+                                mdl_writer_close_fptr close_ptr, void *udata)
+{
+    mdl_writer_init(mds, writer, block_putc, close_ptr, udata);
+    writer->write_ptr = write_ptr;
+}
+
 void mdl_writer_initwithbuffer(MDLState *mds, MDLWriter *writer, void *buffer,
                                size_t size)
 {
     mdl_writer_init(mds, writer, memory_putc, NULL, NULL);
+    writer->write_ptr = memory_write;
     writer->output_buffer = buffer;
     writer->buffer_size = size;
 }
 
+int mdl_writer_setbuffer(MDLWriter *writer, void *buffer, size_t size)
+{
+    if (size == 0)
+        return MDL_ERROR_INVALID_ARGUMENT;
+    if (writer->output_buffer != NULL)
+        return MDL_ERROR_NOT_SUPPORTED;
+    if (writer->staging_buffer != NULL)
+        return MDL_ERROR_ALREADY_EXISTS;
+
+    if (buffer == NULL)
+    {
+        buffer = mdl_malloc(writer->mds, size);
+        if (buffer == NULL)
+            return MDL_ERROR_NOMEM;
+        writer->owns_staging_buffer = true;
+    }
+
+    writer->staging_buffer = buffer;
+    writer->staging_size = size;
+    writer->staging_length = 0;
+    return MDL_OK;
+}
+
 void *mdl_writer_getudata(const MDLWriter *writer)
 {
     return writer->udata;
@@ -76,33 +154,71 @@ void *mdl_writer_getbuffer(const MDLWriter *writer, size_t *p_length)
     return writer->output_buffer;
 }
 
+int mdl_writer_flush(MDLWriter *writer)
+{
+    if (writer->staging_length == 0)
+        return MDL_OK;
+
+    size_t n_flushed =
+        write_to_output(writer, writer->staging_buffer, writer->staging_length);
+
+    // Keep whatever the output didn't take so we can try again later.
+    writer->staging_length -= n_flushed;
+    mdl_memmove(writer->staging_buffer, writer->staging_buffer + n_flushed,
+                writer->staging_length);
+    return (writer->staging_length == 0) ? MDL_OK : MDL_ERROR_FULL;
+}
+
 int mdl_writer_close(MDLWriter *writer)
 {
+    int result = mdl_writer_flush(writer);
+
     if (writer->close_ptr)
         writer->close_ptr(writer);
 
+    if (writer->owns_staging_buffer)
+        mdl_free(writer->mds, writer->staging_buffer, writer->staging_size);
     if (writer->was_allocated)
         mdl_free(writer->mds, writer, sizeof(*writer));
-    return 0;
+    return result;
 }
 
 int mdl_writer_putc(MDLWriter *writer, int chr)
 {
+    if (writer->staging_buffer != NULL)
+    {
+        if (writer->staging_length == writer->staging_size)
+        {
+            int result = mdl_writer_flush(writer);
+            if (result != MDL_OK)
+                return result;
+        }
+        writer->staging_buffer[writer->staging_length++] = (char)chr;
+        return MDL_OK;
+    }
     return writer->putc_ptr(writer, chr);
 }
 
 size_t mdl_writer_write(MDLWriter *writer, const void *data, size_t size)
 {
-    const char *current_byte = data;
+    const char *input = data;
+    size_t n_written = 0;
 
-    for (size_t n_written = 0; n_written < size; n_written++)
+    if (writer->staging_buffer != NULL)
     {
-        int result = writer->putc_ptr(writer, *current_byte);
-        if (result != MDL_OK)
+        n_written = stage(writer, input, size);
+        if (n_written == size)
+            return size;
+
+        // The staging buffer is full. Empty it, then either stage the rest or, if it
+        // wouldn't fit anyway, send it straight to the output.
+        if (mdl_writer_flush(writer) != MDL_OK)
             return n_written;
-        ++current_byte;
+        if (size - n_written < writer->staging_size)
+            return n_written + stage(writer, input + n_written, size - n_written);
     }
-    return size;
+
+    return n_written + write_to_output(writer, input + n_written, size - n_written);
 }
 
 static int memory_putc(MDLWriter *writer, int chr)
@@ -114,7 +230,65 @@ static int memory_putc(MDLWriter *writer, int chr)
     return 0;
 }
 
+static size_t memory_write(MDLWriter *writer, const void *data, size_t size)
+{
+    size_t n_remaining = writer->buffer_size - writer->buffer_position;
+    if (size > n_remaining)
+        size = n_remaining;
+
+    mdl_memcpy(writer->output_buffer + writer->buffer_position, data, size);
+    writer->buffer_position += size;
+    return size;
+}
+
+static int block_putc(MDLWriter *writer, int chr)
+{
+    char value = (char)chr;
+
+    if (writer->write_ptr(writer, &value, 1) == 0)
+        return MDL_ERROR_FULL;
+    return MDL_OK;
+}
+
 void mdl_writer_noopclose(MDLWriter *writer)
 {
     (void)writer;
 }
+
+static size_t write_to_output(MDLWriter *writer, const char *data, size_t size)
+{
+    size_t n_written = 0;
+
+    if (writer->write_ptr != NULL)
+    {
+        // Block writes may be short without the output being full, so keep going until
+        // it either takes everything or won't take anything.
+        while (n_written < size)
+        {
+            size_t n_chunk =
+                writer->write_ptr(writer, data + n_written, size - n_written);
+            if (n_chunk == 0)
+                break;
+            n_written += n_chunk;
+        }
+        return n_written;
+    }
+
+    for (; n_written < size; n_written++)
+    {
+        if (writer->putc_ptr(writer, data[n_written]) != MDL_OK)
+            break;
+    }
+    return n_written;
+}
+
+static size_t stage(MDLWriter *writer, const char *data, size_t size)
+{
+    size_t n_free = writer->staging_size - writer->staging_length;
+    if (size > n_free)
+        size = n_free;
+
+    mdl_memcpy(writer->staging_buffer + writer->staging_length, data, size);
+    writer->staging_length += size;
+    return size;
+}
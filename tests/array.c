@@ -7,9 +7,13 @@
 
 #include "metaldata/array.h"
 #include "metaldata/errors.h"
+#include "metaldata/internal/array.h"
 #include "munit/munit.h"
+#include <stdint.h>
+#include <string.h>
 
 static void helper_test_adding_blocks(MDLArray *array, ptrdiff_t n_to_add);
+static size_t helper_count_slabs(const MDLArray *array);
 
 MunitResult test_array__length_zero(const MunitParameter params[], void *udata)
 {
@@ -165,6 +169,1022 @@ MunitResult test_array__add_more_than_one_block(const MunitParameter params[],
     return MUNIT_OK;
 }
 
+// Arrays with a non-default block size should behave exactly like normal ones.
+MunitResult test_array__custom_block_size(const MunitParameter params[], void *udata)
+{
+    (void)params;
+
+    MDLState *mds = (MDLState *)udata;
+    MDLArray array;
+
+    int error = mdl_array_initwithblocksize(mds, &array, NULL, 4);
+    munit_assert_int(error, ==, MDL_OK);
+    munit_assert_size(array.block_size, ==, 4);
+
+    helper_test_adding_blocks(&array, 1000);
+    munit_assert_size(array.n_allocated_blocks, >=, 250);
+    munit_assert_size(array.table_capacity, >=, array.n_allocated_blocks);
+
+    void *value;
+    error = mdl_array_tail(&array, &value);
+    munit_assert_int(error, ==, MDL_OK);
+    munit_assert_ptr_equal(value, (void *)999);
+
+    int destroy_result = mdl_array_destroy(&array);
+    munit_assert_int(destroy_result, ==, MDL_OK);
+    return MUNIT_OK;
+}
+
+// Block sizes that aren't powers of 2 must be rejected.
+MunitResult test_array__invalid_block_size_fails(const MunitParameter params[],
+                                                 void *udata)
+{
+    (void)params;
+
+    MDLState *mds = (MDLState *)udata;
+    MDLArray array;
+
+    munit_assert_int(mdl_array_initwithblocksize(mds, &array, NULL, 0), ==,
+                     MDL_ERROR_INVALID_ARGUMENT);
+    munit_assert_int(mdl_array_initwithblocksize(mds, &array, NULL, 12), ==,
+                     MDL_ERROR_INVALID_ARGUMENT);
+    munit_assert_null(mdl_array_newwithblocksize(mds, NULL, 3));
+    return MUNIT_OK;
+}
+
+// Reserving capacity up front should allocate all the blocks at once, and pushing up to
+// that capacity afterward shouldn't allocate anything.
+MunitResult test_array__ensurecapacity_single_slab(const MunitParameter params[],
+                                                   void *udata)
+{
+    (void)params;
+
+    MDLState *mds = (MDLState *)udata;
+    MDLArray array;
+
+    int error = mdl_array_initwithblocksize(mds, &array, NULL, 4);
+    munit_assert_int(error, ==, MDL_OK);
+
+    error = mdl_array_ensurecapacity(&array, 1001);
+    munit_assert_int(error, ==, MDL_OK);
+    munit_assert_size(array.n_allocated_blocks, ==, 251);
+    munit_assert_size(helper_count_slabs(&array), ==, 1);
+
+    helper_test_adding_blocks(&array, 1001);
+    munit_assert_size(array.n_allocated_blocks, ==, 251);
+    munit_assert_size(helper_count_slabs(&array), ==, 1);
+
+    // Clearing the array gives back all of the memory.
+    error = mdl_array_clear(&array);
+    munit_assert_int(error, ==, MDL_OK);
+    munit_assert_size(array.n_allocated_blocks, ==, 0);
+    munit_assert_null(array.slabs);
+
+    int destroy_result = mdl_array_destroy(&array);
+    munit_assert_int(destroy_result, ==, MDL_OK);
+    return MUNIT_OK;
+}
+
+// Pushing elements one at a time should only need a logarithmic number of slabs.
+MunitResult test_array__push_grows_geometrically(const MunitParameter params[],
+                                                 void *udata)
+{
+    (void)params;
+
+    MDLState *mds = (MDLState *)udata;
+    MDLArray array;
+
+    int error = mdl_array_init(mds, &array, NULL);
+    munit_assert_int(error, ==, MDL_OK);
+
+    helper_test_adding_blocks(&array, 100000);
+    munit_assert_size(helper_count_slabs(&array), <, 40);
+
+    int destroy_result = mdl_array_destroy(&array);
+    munit_assert_int(destroy_result, ==, MDL_OK);
+    return MUNIT_OK;
+}
+
+// Pushing to the front should put the elements in reverse order, and popping from the
+// front should give them back in the order they were pushed.
+MunitResult test_array__pushfront_popfront(const MunitParameter params[], void *udata)
+{
+    (void)params;
+
+    MDLState *mds = (MDLState *)udata;
+    MDLArray array;
+
+    int error = mdl_array_initwithblocksize(mds, &array, NULL, 4);
+    munit_assert_int(error, ==, MDL_OK);
+
+    for (ptrdiff_t i = 0; i < 100; i++)
+    {
+        error = mdl_array_pushfront(&array, (void *)i);
+        munit_assert_int(error, ==, MDL_OK);
+    }
+    munit_assert_size(mdl_array_length(&array), ==, 100);
+
+    for (ptrdiff_t i = 0; i < 100; i++)
+    {
+        void *value;
+        error = mdl_array_getat(&array, (int)i, &value);
+        munit_assert_int(error, ==, MDL_OK);
+        munit_assert_ptr_equal(value, (void *)(99 - i));
+    }
+
+    for (ptrdiff_t i = 99; i >= 0; i--)
+    {
+        void *value;
+        error = mdl_array_popfront(&array, &value);
+        munit_assert_int(error, ==, MDL_OK);
+        munit_assert_ptr_equal(value, (void *)i);
+    }
+    munit_assert_size(mdl_array_length(&array), ==, 0);
+    munit_assert_int(mdl_array_popfront(&array, NULL), ==, MDL_ERROR_EMPTY);
+
+    int destroy_result = mdl_array_destroy(&array);
+    munit_assert_int(destroy_result, ==, MDL_OK);
+    return MUNIT_OK;
+}
+
+// Using the array as a FIFO queue should reuse the blocks freed up at the front instead
+// of allocating new ones forever.
+MunitResult test_array__queue_reuses_blocks(const MunitParameter params[], void *udata)
+{
+    (void)params;
+
+    MDLState *mds = (MDLState *)udata;
+    MDLArray array;
+
+    int error = mdl_array_initwithblocksize(mds, &array, NULL, 4);
+    munit_assert_int(error, ==, MDL_OK);
+
+    for (ptrdiff_t i = 0; i < 10; i++)
+        mdl_array_push(&array, (void *)i);
+
+    size_t n_blocks_before = 0;
+    size_t n_slabs_before = 0;
+
+    for (ptrdiff_t i = 10; i < 10000; i++)
+    {
+        void *value;
+
+        // Give the queue a few rounds to reach its steady-state size first.
+        if (i == 100)
+        {
+            n_blocks_before = array.n_allocated_blocks;
+            n_slabs_before = helper_count_slabs(&array);
+        }
+
+        error = mdl_array_push(&array, (void *)i);
+        munit_assert_int(error, ==, MDL_OK);
+        error = mdl_array_popfront(&array, &value);
+        munit_assert_int(error, ==, MDL_OK);
+        munit_assert_ptr_equal(value, (void *)(i - 10));
+    }
+
+    munit_assert_size(mdl_array_length(&array), ==, 10);
+    munit_assert_size(array.n_allocated_blocks, ==, n_blocks_before);
+    munit_assert_size(helper_count_slabs(&array), ==, n_slabs_before);
+
+    void *value;
+    mdl_array_head(&array, &value);
+    munit_assert_ptr_equal(value, (void *)9990);
+    mdl_array_tail(&array, &value);
+    munit_assert_ptr_equal(value, (void *)9999);
+
+    int destroy_result = mdl_array_destroy(&array);
+    munit_assert_int(destroy_result, ==, MDL_OK);
+    return MUNIT_OK;
+}
+
+// Mixing pushes and pops at both ends should keep the elements in the right order.
+MunitResult test_array__mixed_deque_operations(const MunitParameter params[],
+                                               void *udata)
+{
+    (void)params;
+
+    MDLState *mds = (MDLState *)udata;
+    MDLArray array;
+
+    int error = mdl_array_initwithblocksize(mds, &array, NULL, 2);
+    munit_assert_int(error, ==, MDL_OK);
+
+    // Build [-500, ..., -1, 0, ..., 499] by alternating between the two ends.
+    for (ptrdiff_t i = 0; i < 500; i++)
+    {
+        mdl_array_push(&array, (void *)i);
+        mdl_array_pushfront(&array, (void *)(-i - 1));
+    }
+
+    for (ptrdiff_t i = 0; i < 1000; i++)
+    {
+        void *value;
+        error = mdl_array_getat(&array, (int)i, &value);
+        munit_assert_int(error, ==, MDL_OK);
+        munit_assert_ptr_equal(value, (void *)(i - 500));
+    }
+
+    // Drain it from the back and refill it from the front. This moves the unused blocks
+    // from the back to the front.
+    for (ptrdiff_t i = 0; i < 500; i++)
+        mdl_array_pop(&array, NULL);
+
+    size_t n_blocks_before = array.n_allocated_blocks;
+    for (ptrdiff_t i = 0; i < 500; i++)
+        mdl_array_pushfront(&array, (void *)(-i - 501));
+    munit_assert_size(array.n_allocated_blocks, ==, n_blocks_before);
+
+    for (ptrdiff_t i = 0; i < 1000; i++)
+    {
+        void *value;
+        error = mdl_array_getat(&array, (int)i, &value);
+        munit_assert_int(error, ==, MDL_OK);
+        munit_assert_ptr_equal(value, (void *)(i - 1000));
+    }
+
+    int destroy_result = mdl_array_destroy(&array);
+    munit_assert_int(destroy_result, ==, MDL_OK);
+    return MUNIT_OK;
+}
+
+// Inserting elements anywhere in the array should keep everything else in order, no
+// matter which side of the insertion point gets shifted.
+MunitResult test_array__insertafter(const MunitParameter params[], void *udata)
+{
+    (void)params;
+
+    MDLState *mds = (MDLState *)udata;
+    MDLArray array;
+
+    int error = mdl_array_initwithblocksize(mds, &array, NULL, 4);
+    munit_assert_int(error, ==, MDL_OK);
+    munit_assert_int(mdl_array_insertafter(&array, 0, NULL), ==, MDL_ERROR_OUT_OF_RANGE);
+
+    // Push all the even numbers, then insert the odd numbers between them.
+    for (ptrdiff_t i = 0; i < 200; i += 2)
+        mdl_array_push(&array, (void *)i);
+
+    for (ptrdiff_t i = 1; i < 200; i += 2)
+    {
+        error = mdl_array_insertafter(&array, (int)(i - 1), (void *)i);
+        munit_assert_int(error, ==, MDL_OK);
+    }
+
+    munit_assert_size(mdl_array_length(&array), ==, 200);
+    for (ptrdiff_t i = 0; i < 200; i++)
+    {
+        void *value;
+        mdl_array_getat(&array, (int)i, &value);
+        munit_assert_ptr_equal(value, (void *)i);
+    }
+
+    // Negative indexes count from the end.
+    error = mdl_array_insertafter(&array, -1, (void *)200);
+    munit_assert_int(error, ==, MDL_OK);
+    void *value;
+    mdl_array_tail(&array, &value);
+    munit_assert_ptr_equal(value, (void *)200);
+    munit_assert_int(mdl_array_insertafter(&array, 201, NULL), ==,
+                     MDL_ERROR_OUT_OF_RANGE);
+
+    int destroy_result = mdl_array_destroy(&array);
+    munit_assert_int(destroy_result, ==, MDL_OK);
+    return MUNIT_OK;
+}
+
+// Removing elements anywhere in the array should close the gap and return the right
+// value.
+MunitResult test_array__removeat(const MunitParameter params[], void *udata)
+{
+    (void)params;
+
+    MDLState *mds = (MDLState *)udata;
+    MDLArray array;
+
+    int error = mdl_array_initwithblocksize(mds, &array, NULL, 4);
+    munit_assert_int(error, ==, MDL_OK);
+
+    for (ptrdiff_t i = 0; i < 200; i++)
+        mdl_array_push(&array, (void *)i);
+
+    // Remove all the odd numbers. Element i is at index i / 2 + 1 after the first i / 2
+    // odd numbers are gone.
+    for (ptrdiff_t i = 1; i < 200; i += 2)
+    {
+        void *value;
+        error = mdl_array_removeat(&array, (int)(i / 2 + 1), &value);
+        munit_assert_int(error, ==, MDL_OK);
+        munit_assert_ptr_equal(value, (void *)i);
+    }
+
+    munit_assert_size(mdl_array_length(&array), ==, 100);
+    for (ptrdiff_t i = 0; i < 100; i++)
+    {
+        void *value;
+        mdl_array_getat(&array, (int)i, &value);
+        munit_assert_ptr_equal(value, (void *)(i * 2));
+    }
+
+    error = mdl_array_removeat(&array, -1, NULL);
+    munit_assert_int(error, ==, MDL_OK);
+    error = mdl_array_removeat(&array, 0, NULL);
+    munit_assert_int(error, ==, MDL_OK);
+    munit_assert_int(mdl_array_removeat(&array, 98, NULL), ==, MDL_ERROR_OUT_OF_RANGE);
+
+    void *value;
+    mdl_array_head(&array, &value);
+    munit_assert_ptr_equal(value, (void *)2);
+    mdl_array_tail(&array, &value);
+    munit_assert_ptr_equal(value, (void *)196);
+
+    int destroy_result = mdl_array_destroy(&array);
+    munit_assert_int(destroy_result, ==, MDL_OK);
+    return MUNIT_OK;
+}
+
+// Popping several elements at once should return them in array order.
+MunitResult test_array__bulkpop(const MunitParameter params[], void *udata)
+{
+    (void)params;
+
+    MDLState *mds = (MDLState *)udata;
+    MDLArray array;
+
+    int error = mdl_array_initwithblocksize(mds, &array, NULL, 4);
+    munit_assert_int(error, ==, MDL_OK);
+
+    // Push to the front too so that the head isn't aligned to a block boundary.
+    for (ptrdiff_t i = 0; i < 50; i++)
+        mdl_array_push(&array, (void *)i);
+    mdl_array_pushfront(&array, (void *)-1);
+
+    void *items[60];
+    munit_assert_int(mdl_array_bulkpop(&array, items, 52), ==, MDL_ERROR_OUT_OF_RANGE);
+    munit_assert_size(mdl_array_length(&array), ==, 51);
+
+    error = mdl_array_bulkpop(&array, items, 30);
+    munit_assert_int(error, ==, MDL_OK);
+    munit_assert_size(mdl_array_length(&array), ==, 21);
+    for (ptrdiff_t i = 0; i < 30; i++)
+        munit_assert_ptr_equal(items[i], (void *)(i + 20));
+
+    error = mdl_array_bulkpop(&array, NULL, 21);
+    munit_assert_int(error, ==, MDL_OK);
+    munit_assert_size(mdl_array_length(&array), ==, 0);
+
+    int destroy_result = mdl_array_destroy(&array);
+    munit_assert_int(destroy_result, ==, MDL_OK);
+    return MUNIT_OK;
+}
+
+// Copying a range out of the array shouldn't modify it.
+MunitResult test_array__copyrange(const MunitParameter params[], void *udata)
+{
+    (void)params;
+
+    MDLState *mds = (MDLState *)udata;
+    MDLArray array;
+
+    int error = mdl_array_initwithblocksize(mds, &array, NULL, 4);
+    munit_assert_int(error, ==, MDL_OK);
+
+    for (ptrdiff_t i = 0; i < 50; i++)
+        mdl_array_push(&array, (void *)i);
+
+    void *items[50];
+    error = mdl_array_copyrange(&array, 3, 42, items);
+    munit_assert_int(error, ==, MDL_OK);
+    for (ptrdiff_t i = 0; i < 39; i++)
+        munit_assert_ptr_equal(items[i], (void *)(i + 3));
+
+    munit_assert_int(mdl_array_copyrange(&array, 10, 10, items), ==, MDL_OK);
+    munit_assert_int(mdl_array_copyrange(&array, 10, 51, items), ==,
+                     MDL_ERROR_OUT_OF_RANGE);
+    munit_assert_int(mdl_array_copyrange(&array, 11, 10, items), ==,
+                     MDL_ERROR_OUT_OF_RANGE);
+    munit_assert_size(mdl_array_length(&array), ==, 50);
+
+    int destroy_result = mdl_array_destroy(&array);
+    munit_assert_int(destroy_result, ==, MDL_OK);
+    return MUNIT_OK;
+}
+
+// Searching with the default pointer comparator should find the first or last match.
+MunitResult test_array__find_pointer(const MunitParameter params[], void *udata)
+{
+    (void)params;
+
+    MDLState *mds = (MDLState *)udata;
+    MDLArray array;
+    mdl_comparator_fptr cmp = mdl_default_ptr_value_comparator;
+
+    int error = mdl_array_initwithblocksize(mds, &array, NULL, 4);
+    munit_assert_int(error, ==, MDL_OK);
+    munit_assert_int(mdl_array_find(&array, NULL, cmp), <, 0);
+
+    // Push to the front too so that the head isn't aligned to a block boundary.
+    for (ptrdiff_t i = 0; i < 50; i++)
+        mdl_array_push(&array, (void *)(i % 20));
+    mdl_array_pushfront(&array, (void *)100);
+
+    munit_assert_int(mdl_array_find(&array, (void *)100, cmp), ==, 0);
+    munit_assert_int(mdl_array_find(&array, (void *)7, cmp), ==, 8);
+    munit_assert_int(mdl_array_rfind(&array, (void *)7, cmp), ==, 48);
+    munit_assert_int(mdl_array_rfind(&array, (void *)100, cmp), ==, 0);
+    munit_assert_int(mdl_array_find(&array, (void *)20, cmp), <, 0);
+    munit_assert_int(mdl_array_rfind(&array, (void *)20, cmp), <, 0);
+
+    int destroy_result = mdl_array_destroy(&array);
+    munit_assert_int(destroy_result, ==, MDL_OK);
+    return MUNIT_OK;
+}
+
+// Searching with any other comparator should compare the values, not the pointers.
+MunitResult test_array__find_with_comparator(const MunitParameter params[], void *udata)
+{
+    (void)params;
+
+    MDLState *mds = (MDLState *)udata;
+    MDLArray array;
+    char search_key[] = "qwerty";
+
+    int error = mdl_array_initwithblocksize(mds, &array, NULL, 2);
+    munit_assert_int(error, ==, MDL_OK);
+
+    mdl_array_push(&array, "abc");
+    mdl_array_push(&array, "qwerty");
+    mdl_array_push(&array, "def");
+    mdl_array_push(&array, "qwerty");
+    mdl_array_push(&array, "ghi");
+
+    mdl_comparator_fptr cmp = mdl_default_string_comparator;
+    munit_assert_int(mdl_array_find(&array, search_key, cmp), ==, 1);
+    munit_assert_int(mdl_array_rfind(&array, search_key, cmp), ==, 3);
+    munit_assert_int(mdl_array_find(&array, search_key, mdl_default_ptr_value_comparator),
+                     <, 0);
+
+    int destroy_result = mdl_array_destroy(&array);
+    munit_assert_int(destroy_result, ==, MDL_OK);
+    return MUNIT_OK;
+}
+
+static size_t n_destructor_calls;
+
+static void counting_destructor(MDLState *mds, void *item)
+{
+    (void)mds, (void)item;
+    n_destructor_calls++;
+}
+
+// Removing a value should only remove the first match and call its destructor.
+MunitResult test_array__removevalue(const MunitParameter params[], void *udata)
+{
+    (void)params;
+
+    MDLState *mds = (MDLState *)udata;
+    MDLArray array;
+    mdl_comparator_fptr cmp = mdl_default_ptr_value_comparator;
+
+    int error = mdl_array_initwithblocksize(mds, &array, counting_destructor, 4);
+    munit_assert_int(error, ==, MDL_OK);
+
+    for (ptrdiff_t i = 0; i < 30; i++)
+        mdl_array_push(&array, (void *)(i % 10));
+
+    n_destructor_calls = 0;
+    munit_assert_int(mdl_array_removevalue(&array, (void *)5, cmp), ==, 1);
+    munit_assert_size(n_destructor_calls, ==, 1);
+    munit_assert_size(mdl_array_length(&array), ==, 29);
+    munit_assert_int(mdl_array_find(&array, (void *)5, cmp), ==, 14);
+    munit_assert_int(mdl_array_removevalue(&array, (void *)10, cmp), ==, 0);
+    munit_assert_size(n_destructor_calls, ==, 1);
+
+    int destroy_result = mdl_array_destroy(&array);
+    munit_assert_int(destroy_result, ==, MDL_OK);
+    munit_assert_size(n_destructor_calls, ==, 30);
+    return MUNIT_OK;
+}
+
+static void helper_assert_sorted(const MDLArray *array)
+{
+    for (size_t i = 1; i < mdl_array_length(array); i++)
+    {
+        void *previous;
+        void *current;
+
+        mdl_array_getat(array, (int)i - 1, &previous);
+        mdl_array_getat(array, (int)i, &current);
+        munit_assert_ptr(previous, <=, current);
+    }
+}
+
+// Sorting should work for random data as well as the usual quicksort worst cases.
+MunitResult test_array__sort(const MunitParameter params[], void *udata)
+{
+    (void)params;
+
+    MDLState *mds = (MDLState *)udata;
+    MDLArray array;
+    mdl_comparator_fptr cmp = mdl_default_ptr_value_comparator;
+
+    int error = mdl_array_initwithblocksize(mds, &array, NULL, 8);
+    munit_assert_int(error, ==, MDL_OK);
+
+    // Sorting an empty array is a no-op.
+    munit_assert_int(mdl_array_sort(&array, cmp), ==, MDL_OK);
+
+    for (ptrdiff_t i = 0; i < 5000; i++)
+        mdl_array_pushfront(&array, (void *)(ptrdiff_t)munit_rand_int_range(1, 1000));
+    munit_assert_int(mdl_array_sort(&array, cmp), ==, MDL_OK);
+    munit_assert_size(mdl_array_length(&array), ==, 5000);
+    helper_assert_sorted(&array);
+
+    // Already sorted
+    munit_assert_int(mdl_array_sort(&array, cmp), ==, MDL_OK);
+    helper_assert_sorted(&array);
+
+    // Reverse sorted
+    mdl_array_clear(&array);
+    for (ptrdiff_t i = 0; i < 5000; i++)
+        mdl_array_pushfront(&array, (void *)i);
+    munit_assert_int(mdl_array_sort(&array, cmp), ==, MDL_OK);
+    for (ptrdiff_t i = 0; i < 5000; i++)
+    {
+        void *value;
+        mdl_array_getat(&array, (int)i, &value);
+        munit_assert_ptr_equal(value, (void *)i);
+    }
+
+    // All equal
+    mdl_array_clear(&array);
+    for (ptrdiff_t i = 0; i < 5000; i++)
+        mdl_array_push(&array, (void *)123);
+    munit_assert_int(mdl_array_sort(&array, cmp), ==, MDL_OK);
+    helper_assert_sorted(&array);
+
+    int destroy_result = mdl_array_destroy(&array);
+    munit_assert_int(destroy_result, ==, MDL_OK);
+    return MUNIT_OK;
+}
+
+// Binary search should find the first of several equal elements, and the insertion point
+// for missing ones.
+MunitResult test_array__bsearch(const MunitParameter params[], void *udata)
+{
+    (void)params;
+
+    MDLState *mds = (MDLState *)udata;
+    MDLArray array;
+    mdl_comparator_fptr cmp = mdl_default_ptr_value_comparator;
+
+    int error = mdl_array_initwithblocksize(mds, &array, NULL, 4);
+    munit_assert_int(error, ==, MDL_OK);
+    munit_assert_int(mdl_array_bsearch(&array, (void *)1, cmp), <, 0);
+    munit_assert_size(mdl_array_lowerbound(&array, (void *)1, cmp), ==, 0);
+
+    // [0, 0, 2, 2, 4, 4, ...]
+    for (ptrdiff_t i = 0; i < 100; i++)
+        mdl_array_push(&array, (void *)(i & ~1));
+
+    munit_assert_int(mdl_array_bsearch(&array, (void *)0, cmp), ==, 0);
+    munit_assert_int(mdl_array_bsearch(&array, (void *)50, cmp), ==, 50);
+    munit_assert_int(mdl_array_bsearch(&array, (void *)98, cmp), ==, 98);
+    munit_assert_int(mdl_array_bsearch(&array, (void *)51, cmp), <, 0);
+    munit_assert_int(mdl_array_bsearch(&array, (void *)1000, cmp), <, 0);
+
+    munit_assert_size(mdl_array_lowerbound(&array, (void *)51, cmp), ==, 52);
+    munit_assert_size(mdl_array_lowerbound(&array, (void *)1000, cmp), ==, 100);
+
+    int destroy_result = mdl_array_destroy(&array);
+    munit_assert_int(destroy_result, ==, MDL_OK);
+    return MUNIT_OK;
+}
+
+// Iterating should visit every element exactly once in either direction, including when
+// the head isn't at the beginning of a block.
+MunitResult test_array__iterate(const MunitParameter params[], void *udata)
+{
+    (void)params;
+
+    MDLState *mds = (MDLState *)udata;
+    MDLArray array;
+    MDLArrayIterator iter;
+
+    int error = mdl_array_initwithblocksize(mds, &array, NULL, 4);
+    munit_assert_int(error, ==, MDL_OK);
+
+    mdl_arrayiter_init(&array, &iter, false);
+    munit_assert_false(mdl_arrayiter_hasnext(&iter));
+    munit_assert_null(mdl_arrayiter_get(&iter));
+    munit_assert_null(mdl_arrayiter_getptr(&iter));
+    munit_assert_int(mdl_arrayiter_next(&iter), ==, MDL_EOF);
+
+    for (ptrdiff_t i = 1; i < 30; i++)
+        mdl_array_push(&array, (void *)i);
+    mdl_array_pushfront(&array, (void *)0);
+
+    mdl_arrayiter_init(&array, &iter, false);
+    for (ptrdiff_t i = 0; i < 30; i++)
+    {
+        munit_assert_ptr_equal(mdl_arrayiter_get(&iter), (void *)i);
+        munit_assert(mdl_arrayiter_hasnext(&iter) == (i < 29));
+        munit_assert_int(mdl_arrayiter_next(&iter), ==, (i < 29) ? MDL_OK : MDL_EOF);
+    }
+
+    mdl_arrayiter_init(&array, &iter, true);
+    for (ptrdiff_t i = 29; i >= 0; i--)
+    {
+        munit_assert_ptr_equal(mdl_arrayiter_get(&iter), (void *)i);
+        munit_assert(mdl_arrayiter_hasnext(&iter) == (i > 0));
+        munit_assert_int(mdl_arrayiter_next(&iter), ==, (i > 0) ? MDL_OK : MDL_EOF);
+    }
+
+    int destroy_result = mdl_array_destroy(&array);
+    munit_assert_int(destroy_result, ==, MDL_OK);
+    return MUNIT_OK;
+}
+
+// Spans should cover every element exactly once and never cross a block boundary.
+MunitResult test_array__iterate_spans(const MunitParameter params[], void *udata)
+{
+    (void)params;
+
+    MDLState *mds = (MDLState *)udata;
+    MDLArray array;
+    MDLArrayIterator iter;
+    const void *span;
+    size_t span_length;
+
+    int error = mdl_array_initwithblocksize(mds, &array, NULL, 4);
+    munit_assert_int(error, ==, MDL_OK);
+
+    for (ptrdiff_t i = 1; i < 30; i++)
+        mdl_array_push(&array, (void *)i);
+    mdl_array_pushfront(&array, (void *)0);
+
+    // Mix next() and nextspan() to make sure they agree on where the iterator is.
+    mdl_arrayiter_init(&array, &iter, false);
+    mdl_arrayiter_next(&iter);
+
+    ptrdiff_t expected = 1;
+    while ((span_length = mdl_arrayiter_nextspan(&iter, &span)) > 0)
+    {
+        void *const *values = span;
+
+        munit_assert_size(span_length, <=, 4);
+        for (size_t i = 0; i < span_length; i++, expected++)
+            munit_assert_ptr_equal(values[i], (void *)expected);
+    }
+    munit_assert_int(expected, ==, 30);
+    munit_assert_ptr_equal(mdl_arrayiter_get(&iter), (void *)29);
+    munit_assert_int(mdl_arrayiter_next(&iter), ==, MDL_EOF);
+
+    mdl_arrayiter_init(&array, &iter, true);
+    expected = 29;
+    while ((span_length = mdl_arrayiter_nextspan(&iter, &span)) > 0)
+    {
+        void *const *values = span;
+
+        munit_assert_size(span_length, <=, 4);
+        for (size_t i = span_length; i > 0; i--, expected--)
+            munit_assert_ptr_equal(values[i - 1], (void *)expected);
+    }
+    munit_assert_int(expected, ==, -1);
+    munit_assert_ptr_equal(mdl_arrayiter_get(&iter), (void *)0);
+
+    int destroy_result = mdl_array_destroy(&array);
+    munit_assert_int(destroy_result, ==, MDL_OK);
+    return MUNIT_OK;
+}
+
+// Popping most of the elements should give memory back, but going back and forth across
+// a block boundary shouldn't.
+MunitResult test_array__pop_reclaims_memory(const MunitParameter params[], void *udata)
+{
+    (void)params;
+
+    MDLState *mds = (MDLState *)udata;
+    MDLArray array;
+
+    int error = mdl_array_initwithblocksize(mds, &array, NULL, 4);
+    munit_assert_int(error, ==, MDL_OK);
+
+    helper_test_adding_blocks(&array, 1000);
+    size_t n_blocks_full = array.n_allocated_blocks;
+
+    // Oscillating around a block boundary shouldn't allocate or free anything.
+    for (int i = 0; i < 100; i++)
+    {
+        mdl_array_pop(&array, NULL);
+        mdl_array_pop(&array, NULL);
+        mdl_array_push(&array, (void *)998);
+        mdl_array_push(&array, (void *)999);
+    }
+    munit_assert_size(array.n_allocated_blocks, ==, n_blocks_full);
+
+    // Dropping under 25% utilization should compact the array into a single slab.
+    while (mdl_array_length(&array) > 100)
+        mdl_array_pop(&array, NULL);
+
+    munit_assert_size(array.n_allocated_blocks, <, n_blocks_full);
+    munit_assert_size(helper_count_slabs(&array), ==, 1);
+
+    for (ptrdiff_t i = 0; i < 100; i++)
+    {
+        void *value;
+        mdl_array_getat(&array, (int)i, &value);
+        munit_assert_ptr_equal(value, (void *)i);
+    }
+
+    // We always keep one block around.
+    while (mdl_array_length(&array) > 0)
+        mdl_array_popfront(&array, NULL);
+    munit_assert_size(array.n_allocated_blocks, ==, 1);
+
+    int destroy_result = mdl_array_destroy(&array);
+    munit_assert_int(destroy_result, ==, MDL_OK);
+    return MUNIT_OK;
+}
+
+// With a threshold of 0, memory is only given back when explicitly asked for.
+MunitResult test_array__shrinktofit(const MunitParameter params[], void *udata)
+{
+    (void)params;
+
+    MDLState *mds = (MDLState *)udata;
+    MDLArray array;
+
+    int error = mdl_array_initwithblocksize(mds, &array, NULL, 4);
+    munit_assert_int(error, ==, MDL_OK);
+    munit_assert_int(mdl_array_setshrinkthreshold(&array, 50), ==,
+                     MDL_ERROR_INVALID_ARGUMENT);
+    munit_assert_int(mdl_array_setshrinkthreshold(&array, 0), ==, MDL_OK);
+
+    helper_test_adding_blocks(&array, 1000);
+    size_t n_blocks_full = array.n_allocated_blocks;
+
+    // Remove from both ends so that the remaining elements don't start on a block
+    // boundary.
+    for (int i = 0; i < 10; i++)
+        mdl_array_popfront(&array, NULL);
+    while (mdl_array_length(&array) > 9)
+        mdl_array_pop(&array, NULL);
+    munit_assert_size(array.n_allocated_blocks, ==, n_blocks_full);
+
+    error = mdl_array_shrinktofit(&array);
+    munit_assert_int(error, ==, MDL_OK);
+    munit_assert_size(array.n_allocated_blocks, ==, 3);
+    munit_assert_size(array.table_capacity, ==, 3);
+    munit_assert_size(helper_count_slabs(&array), ==, 1);
+
+    for (ptrdiff_t i = 0; i < 9; i++)
+    {
+        void *value;
+        mdl_array_getat(&array, (int)i, &value);
+        munit_assert_ptr_equal(value, (void *)(i + 10));
+    }
+
+    // The array should still work normally afterward.
+    mdl_array_pushfront(&array, (void *)9);
+    mdl_array_push(&array, (void *)19);
+    for (ptrdiff_t i = 0; i < 11; i++)
+    {
+        void *value;
+        mdl_array_getat(&array, (int)i, &value);
+        munit_assert_ptr_equal(value, (void *)(i + 9));
+    }
+
+    // Shrinking an empty array frees everything.
+    mdl_array_bulkpop(&array, NULL, 11);
+    error = mdl_array_shrinktofit(&array);
+    munit_assert_int(error, ==, MDL_OK);
+    munit_assert_size(array.n_allocated_blocks, ==, 0);
+    munit_assert_null(array.slabs);
+    munit_assert_null(array.blocks);
+
+    int destroy_result = mdl_array_destroy(&array);
+    munit_assert_int(destroy_result, ==, MDL_OK);
+    return MUNIT_OK;
+}
+typedef struct
+{
+    uint32_t key;
+    char name[28];
+} TestRecord;
+
+static int compare_record_keys(MDLState *mds, const void *left, const void *right,
+                               size_t size)
+{
+    (void)mds, (void)size;
+
+    const TestRecord *left_record = left;
+    const TestRecord *right_record = right;
+
+    if (left_record->key < right_record->key)
+        return -1;
+    return left_record->key > right_record->key;
+}
+
+static void clear_record_destructor(MDLState *mds, void *item)
+{
+    (void)mds;
+
+    // The destructor gets a pointer into the array, not a copy.
+    TestRecord *record = item;
+    munit_assert_uint32(record->key, <, 1000);
+    n_destructor_calls++;
+}
+
+// Values should be copied in and out of the array in their entirety.
+MunitResult test_array__inline_values(const MunitParameter params[], void *udata)
+{
+    (void)params;
+
+    MDLState *mds = (MDLState *)udata;
+    TestRecord record;
+
+    MDLArray *array = mdl_array_newwithelemsize(mds, sizeof(record), NULL);
+    munit_assert_not_null(array);
+    munit_assert_size(mdl_array_getelementsize(array), ==, sizeof(record));
+
+    for (uint32_t i = 0; i < 100; i++)
+    {
+        memset(&record, (int)i, sizeof(record));
+        record.key = i;
+        munit_assert_int(mdl_array_pushcopy(array, &record), ==, MDL_OK);
+    }
+    munit_assert_size(mdl_array_length(array), ==, 100);
+
+    for (int i = 0; i < 100; i++)
+    {
+        munit_assert_int(mdl_array_getcopy(array, i, &record), ==, MDL_OK);
+        munit_assert_uint32(record.key, ==, (uint32_t)i);
+        munit_assert_char(record.name[27], ==, (char)i);
+
+        const TestRecord *stored = mdl_array_getptrat(array, i);
+        munit_assert_not_null(stored);
+        munit_assert_memory_equal(sizeof(record), stored, &record);
+    }
+    munit_assert_null(mdl_array_getptrat(array, 100));
+
+    record.key = 12345;
+    munit_assert_int(mdl_array_setcopy(array, -1, &record), ==, MDL_OK);
+    munit_assert_int(mdl_array_getcopy(array, 99, &record), ==, MDL_OK);
+    munit_assert_uint32(record.key, ==, 12345);
+    munit_assert_int(mdl_array_getcopy(array, 100, &record), ==, MDL_ERROR_OUT_OF_RANGE);
+
+    // Pushing and popping at both ends.
+    record.key = 500;
+    munit_assert_int(mdl_array_pushfrontcopy(array, &record), ==, MDL_OK);
+    munit_assert_int(mdl_array_popcopy(array, &record), ==, MDL_OK);
+    munit_assert_uint32(record.key, ==, 12345);
+    munit_assert_int(mdl_array_popfrontcopy(array, &record), ==, MDL_OK);
+    munit_assert_uint32(record.key, ==, 500);
+    munit_assert_int(mdl_array_popfrontcopy(array, NULL), ==, MDL_OK);
+    munit_assert_size(mdl_array_length(array), ==, 98);
+    munit_assert_uint32(((TestRecord *)mdl_array_getptrat(array, 0))->key, ==, 1);
+
+    int destroy_result = mdl_array_destroy(array);
+    munit_assert_int(destroy_result, ==, MDL_OK);
+    return MUNIT_OK;
+}
+
+// Sorting and searching pass pointers to the elements to the comparator.
+MunitResult test_array__inline_values_sort(const MunitParameter params[], void *udata)
+{
+    (void)params;
+
+    MDLState *mds = (MDLState *)udata;
+    MDLArray array;
+    TestRecord record;
+
+    int error = mdl_array_initwithelemsize(mds, &array, sizeof(record),
+                                           clear_record_destructor);
+    munit_assert_int(error, ==, MDL_OK);
+
+    memset(&record, 0, sizeof(record));
+    for (int i = 0; i < 1000; i++)
+    {
+        record.key = (uint32_t)munit_rand_int_range(0, 499) * 2;
+        mdl_array_pushcopy(&array, &record);
+    }
+
+    munit_assert_int(mdl_array_sort(&array, compare_record_keys), ==, MDL_OK);
+    for (int i = 1; i < 1000; i++)
+    {
+        const TestRecord *previous = mdl_array_getptrat(&array, i - 1);
+        const TestRecord *current = mdl_array_getptrat(&array, i);
+        munit_assert_uint32(previous->key, <=, current->key);
+    }
+
+    // All keys are even, so an odd one is never found.
+    record.key = 501;
+    munit_assert_int(mdl_array_bsearch(&array, &record, compare_record_keys), <, 0);
+    munit_assert_int(mdl_array_find(&array, &record, compare_record_keys), <, 0);
+
+    record.key = ((const TestRecord *)mdl_array_getptrat(&array, 500))->key;
+    int index = mdl_array_bsearch(&array, &record, compare_record_keys);
+    munit_assert_int(index, >=, 0);
+    munit_assert_int(index, ==, mdl_array_find(&array, &record, compare_record_keys));
+
+    n_destructor_calls = 0;
+    munit_assert_int(mdl_array_removevalue(&array, &record, compare_record_keys), ==, 1);
+    munit_assert_size(n_destructor_calls, ==, 1);
+
+    int destroy_result = mdl_array_destroy(&array);
+    munit_assert_int(destroy_result, ==, MDL_OK);
+    munit_assert_size(n_destructor_calls, ==, 1000);
+    return MUNIT_OK;
+}
+
+// Spans over inline values point at the elements themselves.
+MunitResult test_array__inline_values_iterate(const MunitParameter params[], void *udata)
+{
+    (void)params;
+
+    MDLState *mds = (MDLState *)udata;
+    MDLArray array;
+    MDLArrayIterator iter;
+    const void *span;
+    size_t span_length;
+
+    int error = mdl_array_initwithelemsize(mds, &array, sizeof(uint16_t), NULL);
+    munit_assert_int(error, ==, MDL_OK);
+
+    for (uint16_t i = 0; i < 100; i++)
+        mdl_array_pushcopy(&array, &i);
+
+    mdl_arrayiter_init(&array, &iter, false);
+    munit_assert_uint16(*(uint16_t *)mdl_arrayiter_getptr(&iter), ==, 0);
+
+    uint16_t expected = 0;
+    while ((span_length = mdl_arrayiter_nextspan(&iter, &span)) > 0)
+    {
+        const uint16_t *values = span;
+        for (size_t i = 0; i < span_length; i++, expected++)
+            munit_assert_uint16(values[i], ==, expected);
+    }
+    munit_assert_uint16(expected, ==, 100);
+
+    mdl_arrayiter_init(&array, &iter, true);
+    expected = 99;
+    do
+    {
+        munit_assert_uint16(*(uint16_t *)mdl_arrayiter_getptr(&iter), ==, expected);
+        expected--;
+    } while (mdl_arrayiter_next(&iter) == MDL_OK);
+
+    int destroy_result = mdl_array_destroy(&array);
+    munit_assert_int(destroy_result, ==, MDL_OK);
+    return MUNIT_OK;
+}
+
+// Functions taking or returning pointer values don't make sense for inline values.
+MunitResult test_array__inline_values_reject_pointer_api(const MunitParameter params[],
+                                                         void *udata)
+{
+    (void)params;
+
+    MDLState *mds = (MDLState *)udata;
+    MDLArray array;
+    void *value = NULL;
+    uint64_t element = 1;
+
+    munit_assert_int(mdl_array_initwithelemsize(mds, &array, 0, NULL), ==,
+                     MDL_ERROR_INVALID_ARGUMENT);
+
+    int error = mdl_array_initwithelemsize(mds, &array, sizeof(element), NULL);
+    munit_assert_int(error, ==, MDL_OK);
+    munit_assert_int(mdl_array_pushcopy(&array, &element), ==, MDL_OK);
+
+    munit_assert_int(mdl_array_push(&array, value), ==, MDL_ERROR_NOT_SUPPORTED);
+    munit_assert_int(mdl_array_pushfront(&array, value), ==, MDL_ERROR_NOT_SUPPORTED);
+    munit_assert_int(mdl_array_pop(&array, &value), ==, MDL_ERROR_NOT_SUPPORTED);
+    munit_assert_int(mdl_array_popfront(&array, &value), ==, MDL_ERROR_NOT_SUPPORTED);
+    munit_assert_int(mdl_array_head(&array, &value), ==, MDL_ERROR_NOT_SUPPORTED);
+    munit_assert_int(mdl_array_getat(&array, 0, &value), ==, MDL_ERROR_NOT_SUPPORTED);
+    munit_assert_int(mdl_array_setat(&array, 0, value), ==, MDL_ERROR_NOT_SUPPORTED);
+    munit_assert_int(mdl_array_insertafter(&array, 0, value), ==,
+                     MDL_ERROR_NOT_SUPPORTED);
+    munit_assert_size(mdl_array_length(&array), ==, 1);
+
+    // The copy functions work on arrays of pointers too.
+    MDLArray pointers;
+    mdl_array_init(mds, &pointers, NULL);
+    value = &element;
+    munit_assert_int(mdl_array_pushcopy(&pointers, &value), ==, MDL_OK);
+    value = NULL;
+    munit_assert_int(mdl_array_head(&pointers, &value), ==, MDL_OK);
+    munit_assert_ptr_equal(value, &element);
+
+    mdl_array_destroy(&pointers);
+    int destroy_result = mdl_array_destroy(&array);
+    munit_assert_int(destroy_result, ==, MDL_OK);
+    return MUNIT_OK;
+}
+
+
 void helper_test_adding_blocks(MDLArray *array, ptrdiff_t n_to_add)
 {
     munit_assert_not_null(array);
@@ -181,3 +1201,11 @@ void helper_test_adding_blocks(MDLArray *array, ptrdiff_t n_to_add)
         munit_assert_ptr_equal((void *)(ptrdiff_t)i, value);
     }
 }
+
+size_t helper_count_slabs(const MDLArray *array)
+{
+    size_t n_slabs = 0;
+    for (const MDLArraySlab *slab = array->slabs; slab != NULL; slab = slab->next)
+        n_slabs++;
+    return n_slabs;
+}
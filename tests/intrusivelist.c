@@ -0,0 +1,215 @@
+// SPDX-License-Identifier: MPL-2.0+
+// Copyright (C) 2020-2025  Diego Argueta
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "metaldata/intrusivelist.h"
+#include "metaldata/errors.h"
+#include "metaldata/internal/annotations.h"
+#include "munit/munit.h"
+#include <stddef.h>
+
+typedef struct
+{
+    int id;
+    MDLIntrusiveLink first_link;
+    MDLIntrusiveLink second_link;
+} TestObject;
+
+MDL_ANNOTN__NONNULL
+static void init_objects(TestObject *objects, size_t count);
+
+MDL_ANNOTN__NONNULL
+static void assert_list_ids(const MDLIntrusiveList *list, const int *expected,
+                            size_t length);
+
+MunitResult test_intrusivelist__push_pop(const MunitParameter params[], void *udata)
+{
+    (void)params, (void)udata;
+
+    MDLIntrusiveList list;
+    TestObject objects[5];
+
+    mdl_intrusivelist_init(&list);
+    init_objects(objects, 5);
+
+    munit_assert_null(mdl_intrusivelist_head(&list));
+    munit_assert_null(mdl_intrusivelist_tail(&list));
+    munit_assert_null(mdl_intrusivelist_pop(&list));
+    munit_assert_null(mdl_intrusivelist_popfront(&list));
+
+    munit_assert_int(mdl_intrusivelist_push(&list, &objects[2].first_link), ==, MDL_OK);
+    munit_assert_int(mdl_intrusivelist_push(&list, &objects[3].first_link), ==, MDL_OK);
+    munit_assert_int(mdl_intrusivelist_pushfront(&list, &objects[1].first_link), ==,
+                     MDL_OK);
+    munit_assert_int(mdl_intrusivelist_push(&list, &objects[4].first_link), ==, MDL_OK);
+    munit_assert_int(mdl_intrusivelist_pushfront(&list, &objects[0].first_link), ==,
+                     MDL_OK);
+
+    const int expected[] = {0, 1, 2, 3, 4};
+    assert_list_ids(&list, expected, 5);
+
+    // A link can't be on two lists at once.
+    munit_assert_int(mdl_intrusivelist_push(&list, &objects[2].first_link), ==,
+                     MDL_ERROR_ALREADY_EXISTS);
+
+    MDLIntrusiveLink *link = mdl_intrusivelist_pop(&list);
+    munit_assert_ptr_equal(MDL_INTRUSIVELIST_ENTRY(link, TestObject, first_link),
+                           &objects[4]);
+    munit_assert_false(mdl_intrusivelink_islinked(link));
+
+    link = mdl_intrusivelist_popfront(&list);
+    munit_assert_ptr_equal(MDL_INTRUSIVELIST_ENTRY(link, TestObject, first_link),
+                           &objects[0]);
+    assert_list_ids(&list, expected + 1, 3);
+
+    mdl_intrusivelist_clear(&list);
+    munit_assert_size(mdl_intrusivelist_length(&list), ==, 0);
+    for (size_t i = 0; i < 5; i++)
+        munit_assert_false(mdl_intrusivelink_islinked(&objects[i].first_link));
+    return MUNIT_OK;
+}
+
+MunitResult test_intrusivelist__insert_remove(const MunitParameter params[], void *udata)
+{
+    (void)params, (void)udata;
+
+    MDLIntrusiveList list;
+    TestObject objects[6];
+
+    mdl_intrusivelist_init(&list);
+    init_objects(objects, 6);
+
+    mdl_intrusivelist_push(&list, &objects[1].first_link);
+    mdl_intrusivelist_push(&list, &objects[4].first_link);
+    munit_assert_int(mdl_intrusivelist_insertbefore(&list, &objects[1].first_link,
+                                                    &objects[0].first_link),
+                     ==, MDL_OK);
+    munit_assert_int(mdl_intrusivelist_insertafter(&list, &objects[1].first_link,
+                                                   &objects[2].first_link),
+                     ==, MDL_OK);
+    munit_assert_int(mdl_intrusivelist_insertbefore(&list, &objects[4].first_link,
+                                                    &objects[3].first_link),
+                     ==, MDL_OK);
+    munit_assert_int(mdl_intrusivelist_insertafter(&list, &objects[4].first_link,
+                                                   &objects[5].first_link),
+                     ==, MDL_OK);
+
+    const int expected[] = {0, 1, 2, 3, 4, 5};
+    assert_list_ids(&list, expected, 6);
+
+    // Remove from the middle and both ends.
+    munit_assert_int(mdl_intrusivelist_remove(&list, &objects[3].first_link), ==, MDL_OK);
+    munit_assert_int(mdl_intrusivelist_remove(&list, &objects[0].first_link), ==, MDL_OK);
+    munit_assert_int(mdl_intrusivelist_remove(&list, &objects[5].first_link), ==, MDL_OK);
+    munit_assert_int(mdl_intrusivelist_remove(&list, &objects[5].first_link), ==,
+                     MDL_ERROR_NOT_FOUND);
+
+    const int expected_after_removal[] = {1, 2, 4};
+    assert_list_ids(&list, expected_after_removal, 3);
+
+    mdl_intrusivelist_clear(&list);
+    return MUNIT_OK;
+}
+
+MunitResult test_intrusivelist__multiple_lists(const MunitParameter params[],
+                                               void *udata)
+{
+    (void)params, (void)udata;
+
+    MDLIntrusiveList evens, reversed;
+    TestObject objects[6];
+
+    mdl_intrusivelist_init(&evens);
+    mdl_intrusivelist_init(&reversed);
+    init_objects(objects, 6);
+
+    // Every object goes on one list through its second link, and the even ones also go
+    // on another list through their first.
+    for (size_t i = 0; i < 6; i++)
+    {
+        munit_assert_int(mdl_intrusivelist_pushfront(&reversed, &objects[i].second_link),
+                         ==, MDL_OK);
+        if (i % 2 == 0)
+        {
+            munit_assert_int(mdl_intrusivelist_push(&evens, &objects[i].first_link), ==,
+                             MDL_OK);
+        }
+    }
+
+    const int expected_reversed[] = {5, 4, 3, 2, 1, 0};
+    size_t i = 0;
+    for (MDLIntrusiveLink *link = mdl_intrusivelist_head(&reversed); link != NULL;
+         link = mdl_intrusivelist_next(&reversed, link), i++)
+    {
+        TestObject *object = MDL_INTRUSIVELIST_ENTRY(link, TestObject, second_link);
+        munit_assert_int(object->id, ==, expected_reversed[i]);
+    }
+    munit_assert_size(i, ==, 6);
+
+    // Walking backward from the tail through the other list's links.
+    int expected_id = 4;
+    for (MDLIntrusiveLink *link = mdl_intrusivelist_tail(&evens); link != NULL;
+         link = mdl_intrusivelist_prev(&evens, link), expected_id -= 2)
+    {
+        TestObject *object = MDL_INTRUSIVELIST_ENTRY(link, TestObject, first_link);
+        munit_assert_int(object->id, ==, expected_id);
+    }
+    munit_assert_int(expected_id, ==, -2);
+
+    // Removing an object from one list leaves it on the other.
+    munit_assert_int(mdl_intrusivelist_remove(&evens, &objects[2].first_link), ==,
+                     MDL_OK);
+    munit_assert_true(mdl_intrusivelink_islinked(&objects[2].second_link));
+    munit_assert_size(mdl_intrusivelist_length(&evens), ==, 2);
+    munit_assert_size(mdl_intrusivelist_length(&reversed), ==, 6);
+
+    mdl_intrusivelist_clear(&evens);
+    mdl_intrusivelist_clear(&reversed);
+    return MUNIT_OK;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// Helpers
+
+static void init_objects(TestObject *objects, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        objects[i].id = (int)i;
+        mdl_intrusivelink_init(&objects[i].first_link);
+        mdl_intrusivelink_init(&objects[i].second_link);
+    }
+}
+
+/**
+ * Check the IDs of the objects on a list, linked through their `first_link`, in both
+ * directions.
+ */
+static void assert_list_ids(const MDLIntrusiveList *list, const int *expected,
+                            size_t length)
+{
+    munit_assert_size(mdl_intrusivelist_length(list), ==, length);
+
+    MDLIntrusiveLink *link = mdl_intrusivelist_head(list);
+    for (size_t i = 0; i < length; i++)
+    {
+        munit_assert_not_null(link);
+        TestObject *object = MDL_INTRUSIVELIST_ENTRY(link, TestObject, first_link);
+        munit_assert_int(object->id, ==, expected[i]);
+        link = mdl_intrusivelist_next(list, link);
+    }
+    munit_assert_null(link);
+
+    link = mdl_intrusivelist_tail(list);
+    for (size_t i = length; i > 0; i--)
+    {
+        munit_assert_not_null(link);
+        TestObject *object = MDL_INTRUSIVELIST_ENTRY(link, TestObject, first_link);
+        munit_assert_int(object->id, ==, expected[i - 1]);
+        link = mdl_intrusivelist_prev(list, link);
+    }
+    munit_assert_null(link);
+}
@@ -6,9 +6,11 @@
 // file, You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "metaldata/array.h"
+#include "metaldata/intrusivelist.h"
 #include "metaldata/memblklist.h"
 #include "metaldata/metaldata.h"
 #include "metaldata/reader.h"
+#include "metaldata/unrolledlist.h"
 #include "metaldata/writer.h"
 #include "munit/munit.h"
 #include <stddef.h>
@@ -156,6 +158,33 @@ import_test(array, add_less_than_one_block);
 import_test(array, add_exactly_one_block);
 import_test(array, add_one_more_than_one_block);
 import_test(array, add_more_than_one_block);
+import_test(array, custom_block_size);
+import_test(array, invalid_block_size_fails);
+import_test(array, ensurecapacity_single_slab);
+import_test(array, push_grows_geometrically);
+import_test(array, pushfront_popfront);
+import_test(array, queue_reuses_blocks);
+import_test(array, mixed_deque_operations);
+import_test(array, insertafter);
+import_test(array, removeat);
+import_test(array, bulkpop);
+import_test(array, copyrange);
+import_test(array, find_pointer);
+import_test(array, find_with_comparator);
+import_test(array, removevalue);
+import_test(array, sort);
+import_test(array, bsearch);
+import_test(array, iterate);
+import_test(array, iterate_spans);
+import_test(array, pop_reclaims_memory);
+import_test(array, shrinktofit);
+import_test(array, inline_values);
+import_test(array, inline_values_sort);
+import_test(array, inline_values_iterate);
+import_test(array, inline_values_reject_pointer_api);
+import_test(intrusivelist, push_pop);
+import_test(intrusivelist, insert_remove);
+import_test(intrusivelist, multiple_lists);
 import_test(memblklist, length_zero);
 import_test(memblklist, add_one);
 import_test(memblklist, add_many_odd);
@@ -165,6 +194,23 @@ import_test(memblklist, relindex__basic);
 import_test(memblklist, pop__empty);
 import_test(memblklist, popcopy__empty);
 import_test(memblklist, popfront__empty);
+import_test(memblklist, node_cache_reuses_nodes);
+import_test(memblklist, node_cache_slabs);
+import_test(memblklist, remove_updates_list);
+import_test(memblklist, getblockat_cursor);
+import_test(memblklist, rotate);
+import_test(memblklist, concat);
+import_test(memblklist, split);
+import_test(memblklist, splice);
+import_test(memblklist, sort);
+import_test(memblklist, insertsorted);
+import_test(memblklist, insertafter);
+import_test(memblklist, iterator_insert);
+import_test(memblklist, iterator_remove);
+import_test(memblklist, batch_push_pop);
+import_test(memblklist, batch_push_slab);
+import_test(memblklist, removeif);
+import_test(memblklist, removeadjacentdups);
 import_test(reader, buffer_init_static);
 import_test(reader, buffer_init_malloc);
 import_test(reader, buffer_getc);
@@ -172,8 +218,25 @@ import_test(reader, buffer_getc_initially_empty);
 import_test(reader, buffer_unget_at_eof);
 import_test(reader, buffer_unget_at_sof);
 import_test(reader, buffer_unget_empty_buffer);
+import_test(reader, block_read);
+import_test(reader, getc_only_read);
+import_test(reader, buffer_high_bytes);
+import_test(reader, buffer_read);
+import_test(reader, buffer_borrow);
+import_test(reader, buffered_block_reader);
+import_test(reader, buffered_lookahead);
+import_test(unrolledlist, init);
+import_test(unrolledlist, push_pop_both_ends);
+import_test(unrolledlist, insert_splits_chunks);
+import_test(unrolledlist, remove_merges_chunks);
+import_test(unrolledlist, find);
+import_test(unrolledlist, iterate);
 import_test(writer, buffer_init_static);
 import_test(writer, buffer_putc);
+import_test(writer, buffer_write);
+import_test(writer, block_writer);
+import_test(writer, buffered_writer);
+import_test(writer, buffered_close_flushes);
 
 static MunitTest array_tests[] = {
     define_plain_test_case(array, length_zero),
@@ -184,6 +247,36 @@ static MunitTest array_tests[] = {
     define_plain_test_case(array, add_exactly_one_block),
     define_plain_test_case(array, add_one_more_than_one_block),
     define_plain_test_case(array, add_more_than_one_block),
+    define_plain_test_case(array, custom_block_size),
+    define_plain_test_case(array, invalid_block_size_fails),
+    define_plain_test_case(array, ensurecapacity_single_slab),
+    define_plain_test_case(array, push_grows_geometrically),
+    define_plain_test_case(array, pushfront_popfront),
+    define_plain_test_case(array, queue_reuses_blocks),
+    define_plain_test_case(array, mixed_deque_operations),
+    define_plain_test_case(array, insertafter),
+    define_plain_test_case(array, removeat),
+    define_plain_test_case(array, bulkpop),
+    define_plain_test_case(array, copyrange),
+    define_plain_test_case(array, find_pointer),
+    define_plain_test_case(array, find_with_comparator),
+    define_plain_test_case(array, removevalue),
+    define_plain_test_case(array, sort),
+    define_plain_test_case(array, bsearch),
+    define_plain_test_case(array, iterate),
+    define_plain_test_case(array, iterate_spans),
+    define_plain_test_case(array, pop_reclaims_memory),
+    define_plain_test_case(array, shrinktofit),
+    define_plain_test_case(array, inline_values),
+    define_plain_test_case(array, inline_values_sort),
+    define_plain_test_case(array, inline_values_iterate),
+    define_plain_test_case(array, inline_values_reject_pointer_api),
+    SUITE_END_SENTINEL};
+
+static MunitTest intrusivelist_tests[] = {
+    define_plain_test_case(intrusivelist, push_pop),
+    define_plain_test_case(intrusivelist, insert_remove),
+    define_plain_test_case(intrusivelist, multiple_lists),
     SUITE_END_SENTINEL};
 
 static MunitTest memblklist_tests[] = {
@@ -196,6 +289,23 @@ static MunitTest memblklist_tests[] = {
     define_plain_test_case(memblklist, pop__empty),
     define_plain_test_case(memblklist, popcopy__empty),
     define_plain_test_case(memblklist, popfront__empty),
+    define_plain_test_case(memblklist, node_cache_reuses_nodes),
+    define_plain_test_case(memblklist, node_cache_slabs),
+    define_plain_test_case(memblklist, remove_updates_list),
+    define_plain_test_case(memblklist, getblockat_cursor),
+    define_plain_test_case(memblklist, rotate),
+    define_plain_test_case(memblklist, concat),
+    define_plain_test_case(memblklist, split),
+    define_plain_test_case(memblklist, splice),
+    define_plain_test_case(memblklist, sort),
+    define_plain_test_case(memblklist, insertsorted),
+    define_plain_test_case(memblklist, insertafter),
+    define_plain_test_case(memblklist, iterator_insert),
+    define_plain_test_case(memblklist, iterator_remove),
+    define_plain_test_case(memblklist, batch_push_pop),
+    define_plain_test_case(memblklist, batch_push_slab),
+    define_plain_test_case(memblklist, removeif),
+    define_plain_test_case(memblklist, removeadjacentdups),
     SUITE_END_SENTINEL};
 
 static MunitTest reader_tests[] = {
@@ -206,15 +316,38 @@ static MunitTest reader_tests[] = {
     define_plain_test_case(reader, buffer_unget_at_eof),
     define_plain_test_case(reader, buffer_unget_at_sof),
     define_plain_test_case(reader, buffer_unget_empty_buffer),
+    define_plain_test_case(reader, block_read),
+    define_plain_test_case(reader, getc_only_read),
+    define_plain_test_case(reader, buffer_high_bytes),
+    define_plain_test_case(reader, buffer_read),
+    define_plain_test_case(reader, buffer_borrow),
+    define_plain_test_case(reader, buffered_block_reader),
+    define_plain_test_case(reader, buffered_lookahead),
     SUITE_END_SENTINEL};
 
-static MunitTest writer_tests[] = {define_plain_test_case(writer, buffer_init_static),
-                                   define_plain_test_case(writer, buffer_putc),
-                                   SUITE_END_SENTINEL};
+static MunitTest unrolledlist_tests[] = {
+    define_plain_test_case(unrolledlist, init),
+    define_plain_test_case(unrolledlist, push_pop_both_ends),
+    define_plain_test_case(unrolledlist, insert_splits_chunks),
+    define_plain_test_case(unrolledlist, remove_merges_chunks),
+    define_plain_test_case(unrolledlist, find),
+    define_plain_test_case(unrolledlist, iterate),
+    SUITE_END_SENTINEL};
+
+static MunitTest writer_tests[] = {
+    define_plain_test_case(writer, buffer_init_static),
+    define_plain_test_case(writer, buffer_putc),
+    define_plain_test_case(writer, buffer_write),
+    define_plain_test_case(writer, block_writer),
+    define_plain_test_case(writer, buffered_writer),
+    define_plain_test_case(writer, buffered_close_flushes),
+    SUITE_END_SENTINEL};
 
 static MunitSuite all_subsuites[] = {define_test_suite(array),
+                                     define_test_suite(intrusivelist),
                                      define_test_suite(memblklist),
                                      define_test_suite(reader),
+                                     define_test_suite(unrolledlist),
                                      define_test_suite(writer),
                                      {.prefix = NULL}};
 
@@ -229,9 +362,12 @@ int main(int argc, char **argv)
     show_sizeof(MDLArray);
     show_sizeof(MDLArrayBlock);
     show_sizeof(MDLArrayIterator);
+    show_sizeof(MDLIntrusiveList);
     show_sizeof(MDLMemBlkList);
     show_sizeof(MDLMemBlkListIterator);
     show_sizeof(MDLReader);
+    show_sizeof(MDLUnrolledList);
+    show_sizeof(MDLUnrolledListIterator);
     show_sizeof(MDLWriter);
     return munit_suite_main(&suite, &state_tracking, argc, argv);
 }
@@ -8,8 +8,10 @@
 #include "metaldata/memblklist.h"
 #include "metaldata/errors.h"
 #include "metaldata/internal/annotations.h"
+#include "metaldata/internal/memblklist.h"
 #include "munit/munit.h"
 #include <limits.h>
+#include <stdint.h>
 
 MDL_ANNOTN__NONNULL
 static void create_and_test_list_using_push(MDLMemBlkList *list, MDLState *mds,
@@ -25,6 +27,19 @@ MDL_ANNOTN__NONNULL
 MDL_ANNOTN__ACCESS_SIZED(read_write, 1, 2)
 static void randomize_buffer(void *target, size_t size);
 
+/** An element used for testing sort stability: sorted by key, then checked by order. */
+typedef struct
+{
+    int key;
+    int order;
+} KeyedElement;
+
+static int compare_element_keys(MDLState *mds, const void *left, const void *right,
+                                size_t size);
+
+/** A predicate for ints. @a udata points to the int the item must be divisible by. */
+static bool is_multiple_of(MDLState *mds, const void *item, size_t size, void *udata);
+
 MunitResult test_memblklist__length_zero(const MunitParameter params[], void *udata)
 {
     (void)params;
@@ -180,6 +195,843 @@ MunitResult test_memblklist__popfront__empty(const MunitParameter params[], void
     return MUNIT_OK;
 }
 
+// Removed nodes should be reused, up to the cache limit.
+MunitResult test_memblklist__node_cache_reuses_nodes(const MunitParameter params[],
+                                                     void *udata)
+{
+    (void)params;
+
+    MDLState *mds = (MDLState *)udata;
+    MDLMemBlkList list;
+    void *blocks[5];
+
+    mdl_memblklist_init(mds, &list, sizeof(int));
+    munit_assert_int(mdl_memblklist_setnodecache(&list, 8, 0), ==, MDL_OK);
+
+    for (int i = 0; i < 5; i++)
+        blocks[i] = mdl_memblklist_push(&list);
+    munit_assert_int(mdl_memblklist_setnodecache(&list, 8, 0), ==,
+                     MDL_ERROR_NOT_SUPPORTED);
+
+    while (mdl_memblklist_length(&list) > 0)
+        mdl_memblklist_popfront(&list);
+    munit_assert_size(list.n_free_nodes, ==, 5);
+
+    // The free list is LIFO, so the last node removed is the first one reused.
+    for (int i = 4; i >= 0; i--)
+        munit_assert_ptr_equal(mdl_memblklist_pushfront(&list), blocks[i]);
+    munit_assert_size(list.n_free_nodes, ==, 0);
+    munit_assert_ptr_equal(mdl_memblklist_head(&list), blocks[0]);
+    munit_assert_ptr_equal(mdl_memblklist_tail(&list), blocks[4]);
+
+    // Nodes removed once the cache is full are freed.
+    for (int i = 0; i < 15; i++)
+        munit_assert_not_null(mdl_memblklist_push(&list));
+    while (mdl_memblklist_length(&list) > 0)
+        mdl_memblklist_pop(&list);
+    munit_assert_size(list.n_free_nodes, ==, 8);
+
+    munit_assert_int(mdl_memblklist_destroy(&list), ==, MDL_OK);
+    return MUNIT_OK;
+}
+
+// With slabs, a list used as a queue should stop allocating once it reaches a steady
+// size.
+MunitResult test_memblklist__node_cache_slabs(const MunitParameter params[], void *udata)
+{
+    (void)params;
+
+    MDLState *mds = (MDLState *)udata;
+    MDLMemBlkList list;
+
+    // An odd element size makes sure nodes in a slab are padded correctly.
+    mdl_memblklist_init(mds, &list, 13);
+    munit_assert_int(mdl_memblklist_setnodecache(&list, 0, 16), ==, MDL_OK);
+
+    for (int i = 0; i < 40; i++)
+    {
+        char *block = mdl_memblklist_push(&list);
+        munit_assert_not_null(block);
+        munit_assert_size((uintptr_t)block % sizeof(void *), ==, 0);
+        memset(block, i, 13);
+    }
+    munit_assert_size(list.n_free_nodes, ==, 8);
+
+    size_t n_slabs = 0;
+    for (const MDLMemBlkListSlab *slab = list.slabs; slab != NULL; slab = slab->next)
+        n_slabs++;
+    munit_assert_size(n_slabs, ==, 3);
+
+    for (int i = 40; i < 1000; i++)
+    {
+        char block[13];
+
+        munit_assert_int(mdl_memblklist_popfrontcopy(&list, block), ==, MDL_OK);
+        munit_assert_char(block[12], ==, (char)(i - 40));
+        memset(mdl_memblklist_push(&list), i, 13);
+    }
+    munit_assert_size(mdl_memblklist_length(&list), ==, 40);
+    munit_assert_size(list.n_free_nodes, ==, 8);
+    munit_assert_ptr_equal(list.slabs->next->next->next, NULL);
+
+    mdl_memblklist_clear(&list);
+    munit_assert_null(list.slabs);
+    munit_assert_size(list.n_free_nodes, ==, 0);
+
+    munit_assert_int(mdl_memblklist_destroy(&list), ==, MDL_OK);
+    return MUNIT_OK;
+}
+
+// Removing elements from anywhere in the list keeps the head and length correct.
+MunitResult test_memblklist__remove_updates_list(const MunitParameter params[],
+                                                 void *udata)
+{
+    (void)params;
+
+    MDLState *mds = (MDLState *)udata;
+    MDLMemBlkList list;
+    int value;
+
+    mdl_memblklist_init(mds, &list, sizeof(int));
+    for (int i = 0; i < 10; i++)
+        *(int *)mdl_memblklist_push(&list) = i;
+
+    munit_assert_int(mdl_memblklist_removeat(&list, 0), ==, MDL_OK);
+    munit_assert_size(mdl_memblklist_length(&list), ==, 9);
+    munit_assert_int(*(int *)mdl_memblklist_head(&list), ==, 1);
+
+    munit_assert_int(mdl_memblklist_popcopy(&list, &value), ==, MDL_OK);
+    munit_assert_int(value, ==, 9);
+    munit_assert_int(*(int *)mdl_memblklist_tail(&list), ==, 8);
+
+    munit_assert_int(mdl_memblklist_removeatcopy(&list, 3, &value), ==, MDL_OK);
+    munit_assert_int(value, ==, 4);
+    munit_assert_size(mdl_memblklist_length(&list), ==, 7);
+    munit_assert_int(*(int *)mdl_memblklist_getblockat(&list, 3), ==, 5);
+
+    value = 8;
+    munit_assert_int(mdl_memblklist_removevalue(&list, &value,
+                                                mdl_default_memory_comparator),
+                     ==, 1);
+    munit_assert_size(mdl_memblklist_length(&list), ==, 6);
+    munit_assert_int(*(int *)mdl_memblklist_tail(&list), ==, 7);
+
+    while (mdl_memblklist_length(&list) > 0)
+        munit_assert_int(mdl_memblklist_removeat(&list, 0), ==, MDL_OK);
+    munit_assert_null(mdl_memblklist_head(&list));
+
+    munit_assert_int(mdl_memblklist_destroy(&list), ==, MDL_OK);
+    return MUNIT_OK;
+}
+
+// Looking up elements by index has to stay correct as the cursor moves around and the
+// list is modified underneath it.
+MunitResult test_memblklist__getblockat_cursor(const MunitParameter params[], void *udata)
+{
+    (void)params;
+
+    MDLState *mds = (MDLState *)udata;
+    MDLMemBlkList list;
+    int expected[200];
+    size_t length = 0;
+
+    mdl_memblklist_init(mds, &list, sizeof(int));
+    for (int i = 0; i < 100; i++)
+    {
+        *(int *)mdl_memblklist_push(&list) = i;
+        expected[length++] = i;
+    }
+
+    // Sequential access in both directions leaves the cursor on the last element seen.
+    for (size_t i = 0; i < length; i++)
+    {
+        int *block = mdl_memblklist_getblockatcached(&list, i);
+        munit_assert_int(*block, ==, expected[i]);
+    }
+    munit_assert_size(list.cursor_index, ==, 99);
+    for (size_t i = length; i > 0; i--)
+    {
+        int *block = mdl_memblklist_getblockatcached(&list, i - 1);
+        munit_assert_int(*block, ==, expected[i - 1]);
+    }
+    munit_assert_size(list.cursor_index, ==, 0);
+
+    // The const lookup gets the same answers without moving the cursor.
+    munit_assert_int(*(int *)mdl_memblklist_getblockat(&list, 50), ==, expected[50]);
+    munit_assert_size(list.cursor_index, ==, 0);
+
+    // Modify the list in random places, checking random lookups after each change.
+    for (int round = 0; round < 300; round++)
+    {
+        int operation = munit_rand_int_range(0, 3);
+        size_t index = (size_t)munit_rand_int_range(0, (int)length - 1);
+
+        if ((operation == 0) && (length < 200))
+        {
+            *(int *)mdl_memblklist_pushfront(&list) = 1000 + round;
+            memmove(expected + 1, expected, length * sizeof(int));
+            expected[0] = 1000 + round;
+            length++;
+        }
+        else if ((operation == 1) && (length < 200))
+        {
+            *(int *)mdl_memblklist_push(&list) = 1000 + round;
+            expected[length++] = 1000 + round;
+        }
+        else if ((operation == 2) && (length > 1))
+        {
+            munit_assert_int(mdl_memblklist_removeat(&list, index), ==, MDL_OK);
+            memmove(expected + index, expected + index + 1,
+                    (length - index - 1) * sizeof(int));
+            length--;
+        }
+        else if (length > 1)
+        {
+            munit_assert_int(mdl_memblklist_popfront(&list), ==, MDL_OK);
+            memmove(expected, expected + 1, (length - 1) * sizeof(int));
+            length--;
+        }
+
+        munit_assert_size(mdl_memblklist_length(&list), ==, length);
+        for (int i = 0; i < 5; i++)
+        {
+            index = (size_t)munit_rand_int_range(0, (int)length - 1);
+            int *block = mdl_memblklist_getblockatcached(&list, index);
+            munit_assert_int(*block, ==, expected[index]);
+        }
+    }
+
+    munit_assert_null(mdl_memblklist_getblockatcached(&list, length));
+    munit_assert_int(mdl_memblklist_destroy(&list), ==, MDL_OK);
+    return MUNIT_OK;
+}
+
+MunitResult test_memblklist__rotate(const MunitParameter params[], void *udata)
+{
+    (void)params;
+
+    MDLState *mds = (MDLState *)udata;
+    MDLMemBlkList list;
+
+    mdl_memblklist_init(mds, &list, sizeof(int));
+    munit_assert_int(mdl_memblklist_rotate(&list, 1), ==, MDL_ERROR_EMPTY);
+
+    for (int i = 0; i < 10; i++)
+        *(int *)mdl_memblklist_push(&list) = i;
+
+    // +1 moves every element to the next index, and the last element to the front.
+    munit_assert_int(mdl_memblklist_rotateone(&list), ==, MDL_OK);
+    munit_assert_int(*(int *)mdl_memblklist_head(&list), ==, 9);
+    munit_assert_int(*(int *)mdl_memblklist_tail(&list), ==, 8);
+    munit_assert_int(*(int *)mdl_memblklist_getblockat(&list, 1), ==, 0);
+
+    munit_assert_int(mdl_memblklist_rotate(&list, -1), ==, MDL_OK);
+    munit_assert_int(*(int *)mdl_memblklist_head(&list), ==, 0);
+
+    // Rotations are reduced modulo the length, in both directions.
+    munit_assert_int(mdl_memblklist_rotate(&list, 23), ==, MDL_OK);
+    munit_assert_int(*(int *)mdl_memblklist_head(&list), ==, 7);
+    munit_assert_int(mdl_memblklist_rotate(&list, -13), ==, MDL_OK);
+    munit_assert_int(*(int *)mdl_memblklist_head(&list), ==, 0);
+    munit_assert_int(mdl_memblklist_rotate(&list, 10), ==, MDL_OK);
+    munit_assert_int(*(int *)mdl_memblklist_head(&list), ==, 0);
+
+    // LONG_MIN can't be negated, so make sure it's handled. LONG_MIN % 10 is -8.
+    munit_assert_int(mdl_memblklist_rotate(&list, LONG_MIN), ==, MDL_OK);
+    munit_assert_int(*(int *)mdl_memblklist_head(&list), ==, 8);
+    munit_assert_int(mdl_memblklist_rotate(&list, -2), ==, MDL_OK);
+
+    // Lookups by index after rotating must still go through the cursor correctly.
+    munit_assert_int(*(int *)mdl_memblklist_getblockat(&list, 5), ==, 5);
+    munit_assert_int(mdl_memblklist_rotate(&list, 4), ==, MDL_OK);
+    for (size_t i = 0; i < 10; i++)
+    {
+        int *block = mdl_memblklist_getblockat(&list, i);
+        munit_assert_int(*block, ==, (int)((i + 6) % 10));
+    }
+
+    munit_assert_int(mdl_memblklist_destroy(&list), ==, MDL_OK);
+    return MUNIT_OK;
+}
+
+MunitResult test_memblklist__concat(const MunitParameter params[], void *udata)
+{
+    (void)params;
+
+    MDLState *mds = (MDLState *)udata;
+    MDLMemBlkList first, second, incompatible;
+
+    mdl_memblklist_init(mds, &first, sizeof(int));
+    mdl_memblklist_init(mds, &second, sizeof(int));
+    mdl_memblklist_init(mds, &incompatible, sizeof(long long));
+
+    for (int i = 0; i < 5; i++)
+    {
+        *(int *)mdl_memblklist_push(&first) = i;
+        *(int *)mdl_memblklist_push(&second) = i + 5;
+    }
+
+    int *moved_block = mdl_memblklist_head(&second);
+    munit_assert_int(mdl_memblklist_concat(&first, &incompatible), ==,
+                     MDL_ERROR_INVALID_ARGUMENT);
+    munit_assert_int(mdl_memblklist_concat(&first, &first), ==,
+                     MDL_ERROR_INVALID_ARGUMENT);
+
+    munit_assert_int(mdl_memblklist_concat(&first, &second), ==, MDL_OK);
+    munit_assert_size(mdl_memblklist_length(&second), ==, 0);
+    munit_assert_null(mdl_memblklist_head(&second));
+    munit_assert_size(mdl_memblklist_length(&first), ==, 10);
+
+    // Nothing was copied, so pointers into the old list still work.
+    munit_assert_ptr_equal(mdl_memblklist_getblockat(&first, 5), moved_block);
+    for (size_t i = 0; i < 10; i++)
+        munit_assert_int(*(int *)mdl_memblklist_getblockat(&first, i), ==, (int)i);
+    munit_assert_int(*(int *)mdl_memblklist_tail(&first), ==, 9);
+
+    // Concatenating onto an empty list moves everything back.
+    munit_assert_int(mdl_memblklist_concat(&second, &first), ==, MDL_OK);
+    munit_assert_size(mdl_memblklist_length(&second), ==, 10);
+    munit_assert_int(mdl_memblklist_concat(&second, &first), ==, MDL_OK);
+    munit_assert_size(mdl_memblklist_length(&second), ==, 10);
+
+    // Lists allocating from slabs can't exchange nodes.
+    munit_assert_int(mdl_memblklist_setnodecache(&first, 0, 8), ==, MDL_OK);
+    munit_assert_int(mdl_memblklist_concat(&first, &second), ==, MDL_ERROR_NOT_SUPPORTED);
+
+    munit_assert_int(mdl_memblklist_destroy(&first), ==, MDL_OK);
+    munit_assert_int(mdl_memblklist_destroy(&second), ==, MDL_OK);
+    munit_assert_int(mdl_memblklist_destroy(&incompatible), ==, MDL_OK);
+    return MUNIT_OK;
+}
+
+MunitResult test_memblklist__split(const MunitParameter params[], void *udata)
+{
+    (void)params;
+
+    MDLState *mds = (MDLState *)udata;
+    MDLMemBlkList list, rest;
+    MDLMemBlkListIterator iter;
+
+    mdl_memblklist_init(mds, &list, sizeof(int));
+    mdl_memblklist_init(mds, &rest, sizeof(int));
+    for (int i = 0; i < 10; i++)
+        *(int *)mdl_memblklist_push(&list) = i;
+
+    // Split at index 6 using a forward iterator.
+    mdl_memblklistiter_init(&list, &iter, false);
+    for (int i = 0; i < 6; i++)
+        munit_assert_int(mdl_memblklistiter_next(&iter), ==, MDL_OK);
+
+    munit_assert_int(mdl_memblklist_split(&list, &iter, &rest), ==, MDL_OK);
+    munit_assert_size(mdl_memblklist_length(&list), ==, 6);
+    munit_assert_size(mdl_memblklist_length(&rest), ==, 4);
+    munit_assert_int(*(int *)mdl_memblklist_tail(&list), ==, 5);
+    munit_assert_int(*(int *)mdl_memblklist_head(&rest), ==, 6);
+    munit_assert_int(*(int *)mdl_memblklist_tail(&rest), ==, 9);
+
+    // Split at index 4 using a reverse iterator, which starts at the tail.
+    mdl_memblklistiter_init(&list, &iter, true);
+    munit_assert_int(*(int *)mdl_memblklistiter_get(&iter), ==, 5);
+    munit_assert_int(mdl_memblklistiter_next(&iter), ==, MDL_OK);
+    munit_assert_int(mdl_memblklist_split(&list, &iter, &rest), ==, MDL_OK);
+    munit_assert_size(mdl_memblklist_length(&list), ==, 4);
+    munit_assert_size(mdl_memblklist_length(&rest), ==, 6);
+    munit_assert_int(*(int *)mdl_memblklist_tail(&rest), ==, 5);
+
+    // Splitting at the head moves everything.
+    mdl_memblklistiter_init(&list, &iter, false);
+    munit_assert_int(mdl_memblklist_split(&list, &iter, &rest), ==, MDL_OK);
+    munit_assert_size(mdl_memblklist_length(&list), ==, 0);
+    munit_assert_size(mdl_memblklist_length(&rest), ==, 10);
+
+    const int expected[] = {6, 7, 8, 9, 4, 5, 0, 1, 2, 3};
+    for (size_t i = 0; i < 10; i++)
+        munit_assert_int(*(int *)mdl_memblklist_getblockat(&rest, i), ==, expected[i]);
+
+    // An iterator over a different list is rejected.
+    mdl_memblklistiter_init(&list, &iter, false);
+    munit_assert_int(mdl_memblklist_split(&rest, &iter, &list), ==,
+                     MDL_ERROR_INVALID_ARGUMENT);
+
+    munit_assert_int(mdl_memblklist_destroy(&list), ==, MDL_OK);
+    munit_assert_int(mdl_memblklist_destroy(&rest), ==, MDL_OK);
+    return MUNIT_OK;
+}
+
+MunitResult test_memblklist__splice(const MunitParameter params[], void *udata)
+{
+    (void)params;
+
+    MDLState *mds = (MDLState *)udata;
+    MDLMemBlkList src, dest;
+    MDLMemBlkListIterator first, last;
+
+    mdl_memblklist_init(mds, &src, sizeof(int));
+    mdl_memblklist_init(mds, &dest, sizeof(int));
+    for (int i = 0; i < 10; i++)
+        *(int *)mdl_memblklist_push(&src) = i;
+    *(int *)mdl_memblklist_push(&dest) = 100;
+
+    // Move [3, 7] to the end of dest. Look something up first so the cursor has to be
+    // adjusted.
+    munit_assert_int(*(int *)mdl_memblklist_getblockat(&src, 8), ==, 8);
+    mdl_memblklistiter_init(&src, &first, false);
+    mdl_memblklistiter_init(&src, &last, false);
+    for (int i = 0; i < 3; i++)
+        mdl_memblklistiter_next(&first);
+    for (int i = 0; i < 7; i++)
+        mdl_memblklistiter_next(&last);
+
+    munit_assert_int(mdl_memblklist_splice(&dest, &src, &last, &first), ==,
+                     MDL_ERROR_INVALID_ARGUMENT);
+    munit_assert_int(mdl_memblklist_splice(&dest, &src, &first, &last), ==, MDL_OK);
+
+    const int expected_src[] = {0, 1, 2, 8, 9};
+    const int expected_dest[] = {100, 3, 4, 5, 6, 7};
+    munit_assert_size(mdl_memblklist_length(&src), ==, 5);
+    munit_assert_size(mdl_memblklist_length(&dest), ==, 6);
+    for (size_t i = 0; i < 5; i++)
+        munit_assert_int(*(int *)mdl_memblklist_getblockat(&src, i), ==, expected_src[i]);
+    for (size_t i = 0; i < 6; i++)
+    {
+        int *block = mdl_memblklist_getblockat(&dest, i);
+        munit_assert_int(*block, ==, expected_dest[i]);
+    }
+
+    // A single element at the head, using a reverse iterator for both ends.
+    mdl_memblklistiter_init(&src, &first, true);
+    for (int i = 0; i < 4; i++)
+        mdl_memblklistiter_next(&first);
+    munit_assert_int(mdl_memblklist_splice(&dest, &src, &first, &first), ==, MDL_OK);
+    munit_assert_int(*(int *)mdl_memblklist_head(&src), ==, 1);
+    munit_assert_int(*(int *)mdl_memblklist_tail(&src), ==, 9);
+    munit_assert_int(*(int *)mdl_memblklist_tail(&dest), ==, 0);
+
+    munit_assert_int(mdl_memblklist_destroy(&src), ==, MDL_OK);
+    munit_assert_int(mdl_memblklist_destroy(&dest), ==, MDL_OK);
+    return MUNIT_OK;
+}
+
+MunitResult test_memblklist__sort(const MunitParameter params[], void *udata)
+{
+    (void)params;
+
+    MDLState *mds = (MDLState *)udata;
+    MDLMemBlkList list;
+
+    mdl_memblklist_init(mds, &list, sizeof(KeyedElement));
+    munit_assert_int(mdl_memblklist_sort(&list, compare_element_keys), ==, MDL_OK);
+
+    // Use an odd length and lots of duplicate keys so we hit unbalanced merges and can
+    // check for stability.
+    for (int i = 0; i < 333; i++)
+    {
+        KeyedElement *element = mdl_memblklist_push(&list);
+        element->key = munit_rand_int_range(0, 20);
+        element->order = i;
+    }
+
+    KeyedElement *some_element = mdl_memblklist_getblockat(&list, 100);
+    KeyedElement saved_element = *some_element;
+
+    munit_assert_int(mdl_memblklist_sort(&list, compare_element_keys), ==, MDL_OK);
+    munit_assert_size(mdl_memblklist_length(&list), ==, 333);
+
+    // Walk the list in both directions to make sure all the links are right.
+    const KeyedElement *prev = NULL;
+    for (size_t i = 0; i < 333; i++)
+    {
+        const KeyedElement *element = mdl_memblklist_getblockat(&list, i);
+        if (prev != NULL)
+        {
+            munit_assert_int(prev->key, <=, element->key);
+            if (prev->key == element->key)
+                munit_assert_int(prev->order, <, element->order);
+        }
+        prev = element;
+    }
+    munit_assert_ptr_equal(mdl_memblklist_tail(&list), prev);
+    munit_assert_ptr_equal(list.head->prev->data, prev);
+
+    size_t n_seen = 0;
+    const MDLMemBlkListNode *node = list.head;
+    do
+    {
+        munit_assert_ptr_equal(node->next->prev, node);
+        node = node->next;
+        n_seen++;
+    } while (node != list.head);
+    munit_assert_size(n_seen, ==, 333);
+
+    // Nodes were relinked, not copied.
+    munit_assert_int(some_element->key, ==, saved_element.key);
+    munit_assert_int(some_element->order, ==, saved_element.order);
+
+    munit_assert_int(mdl_memblklist_destroy(&list), ==, MDL_OK);
+    return MUNIT_OK;
+}
+
+MunitResult test_memblklist__insertsorted(const MunitParameter params[], void *udata)
+{
+    (void)params;
+
+    MDLState *mds = (MDLState *)udata;
+    MDLMemBlkList list;
+    const int keys[] = {5, 3, 9, 5, 1, 9, 0, 7, 5, 10};
+    const size_t n_keys = sizeof(keys) / sizeof(keys[0]);
+
+    mdl_memblklist_init(mds, &list, sizeof(KeyedElement));
+    for (size_t i = 0; i < n_keys; i++)
+    {
+        KeyedElement element = {keys[i], (int)i};
+        KeyedElement *inserted =
+            mdl_memblklist_insertsorted(&list, &element, compare_element_keys);
+        munit_assert_not_null(inserted);
+        munit_assert_int(inserted->key, ==, keys[i]);
+
+        // Look something up so the cursor has to be kept in sync.
+        mdl_memblklist_getblockat(&list, i / 2);
+    }
+
+    const int expected_keys[] = {0, 1, 3, 5, 5, 5, 7, 9, 9, 10};
+    const int expected_order[] = {6, 4, 1, 0, 3, 8, 7, 2, 5, 9};
+    for (size_t i = 0; i < n_keys; i++)
+    {
+        const KeyedElement *element = mdl_memblklist_getblockat(&list, i);
+        munit_assert_int(element->key, ==, expected_keys[i]);
+        munit_assert_int(element->order, ==, expected_order[i]);
+    }
+
+    munit_assert_int(mdl_memblklist_destroy(&list), ==, MDL_OK);
+    return MUNIT_OK;
+}
+
+MunitResult test_memblklist__insertafter(const MunitParameter params[], void *udata)
+{
+    (void)params;
+
+    MDLState *mds = (MDLState *)udata;
+    MDLMemBlkList list;
+    int value = 0;
+
+    mdl_memblklist_init(mds, &list, sizeof(int));
+    munit_assert_int(mdl_memblklist_insertaftercopy(&list, 0, &value), ==,
+                     MDL_ERROR_OUT_OF_RANGE);
+
+    for (int i = 0; i < 10; i += 2)
+        *(int *)mdl_memblklist_push(&list) = i;
+
+    // [0, 2, 4, 6, 8] -> [0, 1, 2, ..., 9]
+    for (int i = 1; i < 10; i += 2)
+    {
+        value = i;
+        munit_assert_int(mdl_memblklist_insertaftercopy(&list, (size_t)i - 1, &value), ==,
+                         MDL_OK);
+    }
+
+    for (size_t i = 0; i < 10; i++)
+        munit_assert_int(*(int *)mdl_memblklist_getblockat(&list, i), ==, (int)i);
+    munit_assert_int(*(int *)mdl_memblklist_tail(&list), ==, 9);
+    munit_assert_int(mdl_memblklist_insertafter(&list, 10, NULL), ==,
+                     MDL_ERROR_OUT_OF_RANGE);
+
+    munit_assert_int(mdl_memblklist_destroy(&list), ==, MDL_OK);
+    return MUNIT_OK;
+}
+
+MunitResult test_memblklist__iterator_insert(const MunitParameter params[], void *udata)
+{
+    (void)params;
+
+    MDLState *mds = (MDLState *)udata;
+    MDLMemBlkList list;
+    MDLMemBlkListIterator iter;
+
+    mdl_memblklist_init(mds, &list, sizeof(int));
+    for (int i = 0; i < 3; i++)
+        *(int *)mdl_memblklist_push(&list) = i * 10;
+
+    // Going forward, surround every element with neighbors. The ones inserted after are
+    // visited next, so skip over them.
+    mdl_memblklistiter_init(&list, &iter, false);
+    do
+    {
+        int current = *(int *)mdl_memblklistiter_get(&iter);
+        int *before = mdl_memblklist_insertbeforeiter(&list, &iter);
+        munit_assert_not_null(before);
+        *before = current - 1;
+
+        int *after = mdl_memblklist_insertafteriter(&list, &iter);
+        munit_assert_not_null(after);
+        *after = current + 1;
+
+        munit_assert_int(*(int *)mdl_memblklistiter_get(&iter), ==, current);
+        munit_assert_int(mdl_memblklistiter_next(&iter), ==, MDL_OK);
+        munit_assert_int(*(int *)mdl_memblklistiter_get(&iter), ==, current + 1);
+    } while (mdl_memblklistiter_next(&iter) == MDL_OK);
+
+    const int expected[] = {-1, 0, 1, 9, 10, 11, 19, 20, 21};
+    munit_assert_size(mdl_memblklist_length(&list), ==, 9);
+    for (size_t i = 0; i < 9; i++)
+        munit_assert_int(*(int *)mdl_memblklist_getblockat(&list, i), ==, expected[i]);
+
+    // Going backward, an element inserted before the current one is visited next.
+    mdl_memblklistiter_init(&list, &iter, true);
+    *(int *)mdl_memblklist_insertafteriter(&list, &iter) = 100;
+    *(int *)mdl_memblklist_insertbeforeiter(&list, &iter) = 50;
+    munit_assert_int(*(int *)mdl_memblklistiter_get(&iter), ==, 21);
+    munit_assert_int(mdl_memblklistiter_next(&iter), ==, MDL_OK);
+    munit_assert_int(*(int *)mdl_memblklistiter_get(&iter), ==, 50);
+    munit_assert_int(mdl_memblklistiter_next(&iter), ==, MDL_OK);
+    munit_assert_int(*(int *)mdl_memblklistiter_get(&iter), ==, 20);
+    munit_assert_int(*(int *)mdl_memblklist_tail(&list), ==, 100);
+    munit_assert_size(mdl_memblklist_length(&list), ==, 11);
+
+    munit_assert_int(mdl_memblklist_destroy(&list), ==, MDL_OK);
+    return MUNIT_OK;
+}
+
+MunitResult test_memblklist__iterator_remove(const MunitParameter params[], void *udata)
+{
+    (void)params;
+
+    MDLState *mds = (MDLState *)udata;
+    MDLMemBlkList list;
+    MDLMemBlkListIterator iter;
+    int status;
+
+    mdl_memblklist_init(mds, &list, sizeof(int));
+    for (int i = 0; i < 20; i++)
+        *(int *)mdl_memblklist_push(&list) = i;
+
+    // Remove all multiples of 3 going forward, including the first and last elements.
+    mdl_memblklistiter_init(&list, &iter, false);
+    status = MDL_OK;
+    while (status == MDL_OK)
+    {
+        if (*(int *)mdl_memblklistiter_get(&iter) % 3 == 0)
+            status = mdl_memblklist_removeatiter(&list, &iter);
+        else
+            status = mdl_memblklistiter_next(&iter);
+    }
+    munit_assert_int(status, ==, MDL_EOF);
+
+    const int expected[] = {1, 2, 4, 5, 7, 8, 10, 11, 13, 14, 16, 17, 19};
+    munit_assert_size(mdl_memblklist_length(&list), ==, 13);
+    for (size_t i = 0; i < 13; i++)
+        munit_assert_int(*(int *)mdl_memblklist_getblockat(&list, i), ==, expected[i]);
+
+    // Remove the even numbers going backward, ending with the head.
+    mdl_memblklistiter_init(&list, &iter, true);
+    status = MDL_OK;
+    while (status == MDL_OK)
+    {
+        if (*(int *)mdl_memblklistiter_get(&iter) % 2 == 0)
+            status = mdl_memblklist_removeatiter(&list, &iter);
+        else
+            status = mdl_memblklistiter_next(&iter);
+    }
+
+    const int expected_odd[] = {1, 5, 7, 11, 13, 17, 19};
+    munit_assert_size(mdl_memblklist_length(&list), ==, 7);
+    for (size_t i = 0; i < 7; i++)
+    {
+        int *block = mdl_memblklist_getblockat(&list, i);
+        munit_assert_int(*block, ==, expected_odd[i]);
+    }
+
+    // Remove everything.
+    mdl_memblklistiter_init(&list, &iter, false);
+    for (int i = 0; i < 6; i++)
+        munit_assert_int(mdl_memblklist_removeatiter(&list, &iter), ==, MDL_OK);
+    munit_assert_int(mdl_memblklist_removeatiter(&list, &iter), ==, MDL_EOF);
+    munit_assert_size(mdl_memblklist_length(&list), ==, 0);
+    munit_assert_null(mdl_memblklist_head(&list));
+    munit_assert_int(mdl_memblklist_removeatiter(&list, &iter), ==,
+                     MDL_ERROR_INVALID_ARGUMENT);
+
+    munit_assert_int(mdl_memblklist_destroy(&list), ==, MDL_OK);
+    return MUNIT_OK;
+}
+
+MunitResult test_memblklist__batch_push_pop(const MunitParameter params[], void *udata)
+{
+    (void)params;
+
+    MDLState *mds = (MDLState *)udata;
+    MDLMemBlkList list;
+    int items[50];
+    int output[50];
+
+    for (int i = 0; i < 50; i++)
+        items[i] = i;
+
+    mdl_memblklist_init(mds, &list, sizeof(int));
+    munit_assert_int(mdl_memblklist_pushmany(&list, items, 0), ==, MDL_OK);
+    munit_assert_int(mdl_memblklist_popmany(&list, NULL, 1), ==, MDL_ERROR_OUT_OF_RANGE);
+
+    // [20, 50) pushed onto the back, then [0, 20) onto the front.
+    munit_assert_int(mdl_memblklist_pushmany(&list, items + 20, 30), ==, MDL_OK);
+    munit_assert_int(*(int *)mdl_memblklist_getblockat(&list, 10), ==, 30);
+    munit_assert_int(mdl_memblklist_pushfrontmany(&list, items, 20), ==, MDL_OK);
+    munit_assert_size(mdl_memblklist_length(&list), ==, 50);
+    for (size_t i = 0; i < 50; i++)
+        munit_assert_int(*(int *)mdl_memblklist_getblockat(&list, i), ==, (int)i);
+    munit_assert_int(*(int *)mdl_memblklist_tail(&list), ==, 49);
+
+    munit_assert_int(mdl_memblklist_popmany(&list, output, 51), ==,
+                     MDL_ERROR_OUT_OF_RANGE);
+    munit_assert_size(mdl_memblklist_length(&list), ==, 50);
+
+    munit_assert_int(mdl_memblklist_popmany(&list, output, 15), ==, MDL_OK);
+    for (int i = 0; i < 15; i++)
+        munit_assert_int(output[i], ==, 35 + i);
+
+    munit_assert_int(mdl_memblklist_popfrontmany(&list, output, 10), ==, MDL_OK);
+    for (int i = 0; i < 10; i++)
+        munit_assert_int(output[i], ==, i);
+
+    munit_assert_size(mdl_memblklist_length(&list), ==, 25);
+    munit_assert_int(*(int *)mdl_memblklist_head(&list), ==, 10);
+    munit_assert_int(*(int *)mdl_memblklist_tail(&list), ==, 34);
+    for (size_t i = 0; i < 25; i++)
+        munit_assert_int(*(int *)mdl_memblklist_getblockat(&list, i), ==, (int)i + 10);
+
+    munit_assert_int(mdl_memblklist_popfrontmany(&list, NULL, 25), ==, MDL_OK);
+    munit_assert_size(mdl_memblklist_length(&list), ==, 0);
+    munit_assert_null(mdl_memblklist_head(&list));
+
+    munit_assert_int(mdl_memblklist_destroy(&list), ==, MDL_OK);
+    return MUNIT_OK;
+}
+
+MunitResult test_memblklist__batch_push_slab(const MunitParameter params[], void *udata)
+{
+    (void)params;
+
+    MDLState *mds = (MDLState *)udata;
+    MDLMemBlkList list;
+    int items[100];
+
+    for (int i = 0; i < 100; i++)
+        items[i] = i;
+
+    mdl_memblklist_init(mds, &list, sizeof(int));
+    munit_assert_int(mdl_memblklist_setnodecache(&list, 0, 8), ==, MDL_OK);
+
+    // All 100 nodes should come from a single slab rather than thirteen small ones.
+    munit_assert_int(mdl_memblklist_pushmany(&list, items, 100), ==, MDL_OK);
+    munit_assert_not_null(list.slabs);
+    munit_assert_null(list.slabs->next);
+    munit_assert_size(list.n_free_nodes, ==, 0);
+
+    // Popped nodes go back on the free list and are reused by the next batch without
+    // allocating.
+    munit_assert_int(mdl_memblklist_popfrontmany(&list, NULL, 60), ==, MDL_OK);
+    munit_assert_size(list.n_free_nodes, ==, 60);
+    munit_assert_int(mdl_memblklist_pushmany(&list, items, 60), ==, MDL_OK);
+    munit_assert_size(list.n_free_nodes, ==, 0);
+    munit_assert_null(list.slabs->next);
+
+    for (size_t i = 0; i < 100; i++)
+    {
+        int *block = mdl_memblklist_getblockat(&list, i);
+        munit_assert_int(*block, ==, (int)((i + 60) % 100));
+    }
+
+    munit_assert_int(mdl_memblklist_destroy(&list), ==, MDL_OK);
+    return MUNIT_OK;
+}
+
+MunitResult test_memblklist__removeif(const MunitParameter params[], void *udata)
+{
+    (void)params;
+
+    MDLState *mds = (MDLState *)udata;
+    MDLMemBlkList list;
+    int divisor = 3;
+
+    mdl_memblklist_init(mds, &list, sizeof(int));
+    munit_assert_size(mdl_memblklist_removeif(&list, is_multiple_of, &divisor), ==, 0);
+
+    for (int i = 0; i < 20; i++)
+        *(int *)mdl_memblklist_push(&list) = i;
+
+    // Move the cursor to the end so that removals before it have to adjust its index.
+    munit_assert_int(*(int *)mdl_memblklist_getblockat(&list, 19), ==, 19);
+
+    // Removes 0, 3, 6, ..., 18, including the head and the cursor's neighbors.
+    munit_assert_size(mdl_memblklist_removeif(&list, is_multiple_of, &divisor), ==, 7);
+    munit_assert_size(mdl_memblklist_length(&list), ==, 13);
+
+    int expected = 1;
+    for (size_t i = 0; i < 13; i++, expected++)
+    {
+        if (expected % 3 == 0)
+            expected++;
+        munit_assert_int(*(int *)mdl_memblklist_getblockat(&list, i), ==, expected);
+    }
+    munit_assert_int(*(int *)mdl_memblklist_head(&list), ==, 1);
+    munit_assert_int(*(int *)mdl_memblklist_tail(&list), ==, 19);
+
+    int value = 7;
+    *(int *)mdl_memblklist_push(&list) = value;
+    *(int *)mdl_memblklist_pushfront(&list) = value;
+    munit_assert_size(
+        mdl_memblklist_removeallvalue(&list, &value, mdl_default_memory_comparator), ==,
+        3);
+    munit_assert_size(mdl_memblklist_length(&list), ==, 12);
+    munit_assert_int(*(int *)mdl_memblklist_head(&list), ==, 1);
+    munit_assert_int(*(int *)mdl_memblklist_tail(&list), ==, 19);
+    munit_assert_size(
+        mdl_memblklist_findindex(&list, &value, mdl_default_memory_comparator), ==,
+        MDL_INVALID_INDEX);
+
+    // Removing everything leaves a valid empty list.
+    divisor = 1;
+    munit_assert_size(mdl_memblklist_removeif(&list, is_multiple_of, &divisor), ==, 12);
+    munit_assert_size(mdl_memblklist_length(&list), ==, 0);
+    munit_assert_null(mdl_memblklist_head(&list));
+
+    *(int *)mdl_memblklist_push(&list) = 123;
+    munit_assert_int(*(int *)mdl_memblklist_head(&list), ==, 123);
+
+    munit_assert_int(mdl_memblklist_destroy(&list), ==, MDL_OK);
+    return MUNIT_OK;
+}
+
+MunitResult test_memblklist__removeadjacentdups(const MunitParameter params[],
+                                                void *udata)
+{
+    (void)params;
+
+    MDLState *mds = (MDLState *)udata;
+    MDLMemBlkList list;
+    const int values[] = {1, 1, 1, 2, 3, 3, 1, 4, 4, 4, 4, 5, 5};
+    const int expected[] = {1, 2, 3, 1, 4, 5};
+
+    mdl_memblklist_init(mds, &list, sizeof(int));
+    munit_assert_size(
+        mdl_memblklist_removeadjacentdups(&list, mdl_default_memory_comparator), ==, 0);
+
+    for (size_t i = 0; i < 13; i++)
+        *(int *)mdl_memblklist_push(&list) = values[i];
+
+    munit_assert_size(
+        mdl_memblklist_removeadjacentdups(&list, mdl_default_memory_comparator), ==, 7);
+    munit_assert_size(mdl_memblklist_length(&list), ==, 6);
+    for (size_t i = 0; i < 6; i++)
+        munit_assert_int(*(int *)mdl_memblklist_getblockat(&list, i), ==, expected[i]);
+    munit_assert_int(*(int *)mdl_memblklist_tail(&list), ==, 5);
+
+    // Nothing left to remove.
+    munit_assert_size(
+        mdl_memblklist_removeadjacentdups(&list, mdl_default_memory_comparator), ==, 0);
+
+    munit_assert_int(mdl_memblklist_destroy(&list), ==, MDL_OK);
+    return MUNIT_OK;
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////
 // Helpers
 
@@ -226,3 +1078,22 @@ static void randomize_buffer(void *target, size_t size)
     for (size_t i = 0; i < size; i++)
         ((char *)target)[i] = rand() % CHAR_MAX;
 }
+
+static int compare_element_keys(MDLState *mds, const void *left, const void *right,
+                                size_t size)
+{
+    (void)mds, (void)size;
+
+    const KeyedElement *left_element = left;
+    const KeyedElement *right_element = right;
+
+    if (left_element->key < right_element->key)
+        return -1;
+    return left_element->key > right_element->key;
+}
+
+static bool is_multiple_of(MDLState *mds, const void *item, size_t size, void *udata)
+{
+    (void)mds, (void)size;
+    return *(const int *)item % *(const int *)udata == 0;
+}
@@ -8,8 +8,26 @@
 #include "metaldata/reader.h"
 #include "metaldata/errors.h"
 #include "munit/munit.h"
+#include <stdint.h>
 #include <string.h>
 
+#define TEST_SOURCE_DATA "This is some test input that's longer than one chunk."
+#define TEST_SOURCE_LENGTH (sizeof(TEST_SOURCE_DATA) - 1)
+
+/** The most bytes @ref test_source_read returns per call. */
+#define TEST_SOURCE_CHUNK 5
+
+/** A callback-backed input source that counts how many times it's called. */
+typedef struct
+{
+    const char *data;
+    size_t position;
+    size_t n_calls;
+} TestSource;
+
+static size_t test_source_read(MDLReader *reader, void *buf, size_t size, void *udata);
+static int test_source_getc(MDLReader *reader, void *udata);
+
 MunitResult test_reader__buffer_init_static(const MunitParameter params[], void *udata)
 {
     (void)params;
@@ -167,3 +185,274 @@ MunitResult test_reader__buffer_unget_empty_buffer(const MunitParameter params[]
     mdl_reader_close(&reader);
     return MUNIT_OK;
 }
+
+MunitResult test_reader__block_read(const MunitParameter params[], void *udata)
+{
+    (void)params;
+    MDLState *mds = (MDLState *)udata;
+    MDLReader reader;
+    char output[64];
+    TestSource source = {TEST_SOURCE_DATA, 0, 0};
+
+    mdl_reader_initblockreader(mds, &reader, test_source_read, NULL, &source);
+
+    // Single characters go through the block reader too.
+    munit_assert_int(mdl_reader_peekc(&reader), ==, 'T');
+    munit_assert_int(mdl_reader_getc(&reader), ==, 'T');
+    munit_assert_int(mdl_reader_getc(&reader), ==, 'h');
+    munit_assert_int(mdl_reader_ungetc(&reader, 'h'), ==, MDL_OK);
+
+    // The source returns short reads, so this needs several calls to fill the buffer.
+    size_t calls_before = source.n_calls;
+    size_t n_read = mdl_reader_read(&reader, output, sizeof(output));
+    munit_assert_size(n_read, ==, TEST_SOURCE_LENGTH - 1);
+    munit_assert_memory_equal(n_read, output, TEST_SOURCE_DATA + 1);
+
+    // One call per chunk, plus the one that found the end of the input. The first two
+    // bytes were already taken from the source by getc().
+    size_t n_chunks =
+        (TEST_SOURCE_LENGTH - 2 + TEST_SOURCE_CHUNK - 1) / TEST_SOURCE_CHUNK;
+    munit_assert_size(source.n_calls - calls_before, ==, n_chunks + 1);
+
+    munit_assert_size(mdl_reader_read(&reader, output, sizeof(output)), ==, 0);
+    munit_assert_int(mdl_reader_getc(&reader), ==, MDL_EOF);
+
+    mdl_reader_close(&reader);
+    return MUNIT_OK;
+}
+
+MunitResult test_reader__getc_only_read(const MunitParameter params[], void *udata)
+{
+    (void)params;
+    MDLState *mds = (MDLState *)udata;
+    MDLReader *reader;
+    char output[64];
+    TestSource source = {TEST_SOURCE_DATA, 0, 0};
+
+    reader = mdl_reader_new(mds, test_source_getc, NULL, &source);
+    munit_assert_not_null(reader);
+
+    // ungetc() has to work for sources that don't handle it themselves.
+    munit_assert_int(mdl_reader_peekc(reader), ==, 'T');
+    munit_assert_size(mdl_reader_read(reader, output, 4), ==, 4);
+    munit_assert_memory_equal(4, output, "This");
+
+    size_t n_read = mdl_reader_read(reader, output, sizeof(output));
+    munit_assert_size(n_read, ==, TEST_SOURCE_LENGTH - 4);
+    munit_assert_memory_equal(n_read, output, TEST_SOURCE_DATA + 4);
+    munit_assert_int(mdl_reader_getc(reader), ==, MDL_EOF);
+
+    mdl_reader_close(reader);
+    return MUNIT_OK;
+}
+
+MunitResult test_reader__buffer_high_bytes(const MunitParameter params[], void *udata)
+{
+    (void)params;
+    MDLState *mds = (MDLState *)udata;
+    MDLReader reader;
+    const char data[] = {'\x7f', '\x80', '\xff', 'a'};
+
+    mdl_reader_initfrombuffer(mds, &reader, data, sizeof(data));
+
+    // Bytes with the high bit set mustn't be mistaken for the end of the input.
+    munit_assert_int(mdl_reader_getc(&reader), ==, 0x7f);
+    munit_assert_int(mdl_reader_getc(&reader), ==, 0x80);
+    munit_assert_int(mdl_reader_getc(&reader), ==, 0xff);
+    munit_assert_int(mdl_reader_getc(&reader), ==, 'a');
+    munit_assert_int(mdl_reader_getc(&reader), ==, MDL_EOF);
+
+    mdl_reader_close(&reader);
+    return MUNIT_OK;
+}
+
+MunitResult test_reader__buffer_read(const MunitParameter params[], void *udata)
+{
+    (void)params;
+    MDLState *mds = (MDLState *)udata;
+    MDLReader reader;
+    char output[64];
+
+    mdl_reader_initfrombuffer(mds, &reader, TEST_SOURCE_DATA, TEST_SOURCE_LENGTH);
+
+    // A character that didn't come from the buffer comes first.
+    munit_assert_int(mdl_reader_ungetc(&reader, '!'), ==, MDL_OK);
+    munit_assert_size(mdl_reader_read(&reader, output, 5), ==, 5);
+    munit_assert_memory_equal(5, output, "!This");
+    munit_assert_size(reader.buffer_position, ==, 4);
+
+    size_t n_read = mdl_reader_read(&reader, output, sizeof(output));
+    munit_assert_size(n_read, ==, TEST_SOURCE_LENGTH - 4);
+    munit_assert_memory_equal(n_read, output, TEST_SOURCE_DATA + 4);
+    munit_assert_size(mdl_reader_read(&reader, output, sizeof(output)), ==, 0);
+
+    mdl_reader_close(&reader);
+    return MUNIT_OK;
+}
+
+MunitResult test_reader__buffer_borrow(const MunitParameter params[], void *udata)
+{
+    (void)params;
+    MDLState *mds = (MDLState *)udata;
+    MDLReader reader;
+    const void *ptr;
+    size_t length;
+
+    mdl_reader_initfrombuffer(mds, &reader, TEST_SOURCE_DATA, TEST_SOURCE_LENGTH);
+
+    // Peeking puts the byte back into the buffer, so it doesn't get in the way.
+    munit_assert_int(mdl_reader_peekc(&reader), ==, 'T');
+    munit_assert_int(mdl_reader_borrow(&reader, 4, &ptr, &length), ==, MDL_OK);
+    munit_assert_ptr_equal(ptr, TEST_SOURCE_DATA);
+    munit_assert_size(length, ==, 4);
+
+    // Putting back several bytes we just read works too.
+    munit_assert_int(mdl_reader_getc(&reader), ==, ' ');
+    munit_assert_int(mdl_reader_getc(&reader), ==, 'i');
+    munit_assert_int(mdl_reader_ungetc(&reader, 'i'), ==, MDL_OK);
+    munit_assert_int(mdl_reader_ungetc(&reader, ' '), ==, MDL_OK);
+    munit_assert_size(reader.buffer_position, ==, 4);
+
+    // Anything else can't be borrowed.
+    munit_assert_int(mdl_reader_ungetc(&reader, '?'), ==, MDL_OK);
+    munit_assert_int(mdl_reader_borrow(&reader, 4, &ptr, &length), ==,
+                     MDL_ERROR_NOT_SUPPORTED);
+    munit_assert_int(mdl_reader_getc(&reader), ==, '?');
+
+    munit_assert_int(mdl_reader_borrow(&reader, SIZE_MAX, &ptr, &length), ==, MDL_OK);
+    munit_assert_ptr_equal(ptr, TEST_SOURCE_DATA + 4);
+    munit_assert_size(length, ==, TEST_SOURCE_LENGTH - 4);
+
+    munit_assert_int(mdl_reader_borrow(&reader, 1, &ptr, &length), ==, MDL_OK);
+    munit_assert_size(length, ==, 0);
+    munit_assert_int(mdl_reader_getc(&reader), ==, MDL_EOF);
+
+    mdl_reader_close(&reader);
+
+    // Readers that don't read from a buffer have nothing to lend.
+    TestSource source = {TEST_SOURCE_DATA, 0, 0};
+    mdl_reader_initblockreader(mds, &reader, test_source_read, NULL, &source);
+    munit_assert_int(mdl_reader_borrow(&reader, 4, &ptr, &length), ==,
+                     MDL_ERROR_NOT_SUPPORTED);
+    mdl_reader_close(&reader);
+    return MUNIT_OK;
+}
+
+MunitResult test_reader__buffered_block_reader(const MunitParameter params[],
+                                               void *udata)
+{
+    (void)params;
+    MDLState *mds = (MDLState *)udata;
+    MDLReader reader;
+    char output[64];
+    TestSource source = {TEST_SOURCE_DATA, 0, 0};
+
+    mdl_reader_initblockreader(mds, &reader, test_source_read, NULL, &source);
+    munit_assert_int(mdl_reader_setbuffer(&reader, NULL, 0), ==,
+                     MDL_ERROR_INVALID_ARGUMENT);
+    munit_assert_int(mdl_reader_setbuffer(&reader, NULL, TEST_SOURCE_CHUNK), ==, MDL_OK);
+    munit_assert_int(mdl_reader_setbuffer(&reader, NULL, TEST_SOURCE_CHUNK), ==,
+                     MDL_ERROR_ALREADY_EXISTS);
+
+    // The first getc fills the buffer, and the rest of the chunk comes from it.
+    munit_assert_int(mdl_reader_getc(&reader), ==, 'T');
+    munit_assert_size(source.n_calls, ==, 1);
+    munit_assert_int(mdl_reader_peekc(&reader), ==, 'h');
+    munit_assert_int(mdl_reader_getc(&reader), ==, 'h');
+    munit_assert_int(mdl_reader_getc(&reader), ==, 'i');
+    munit_assert_size(source.n_calls, ==, 1);
+
+    // Put back more than one character.
+    munit_assert_int(mdl_reader_ungetc(&reader, 'i'), ==, MDL_OK);
+    munit_assert_int(mdl_reader_ungetc(&reader, 'h'), ==, MDL_OK);
+    munit_assert_int(mdl_reader_ungetc(&reader, 'T'), ==, MDL_OK);
+    munit_assert_size(mdl_reader_read(&reader, output, 4), ==, 4);
+    munit_assert_memory_equal(4, output, "This");
+    munit_assert_size(source.n_calls, ==, 1);
+
+    // This is bigger than the buffer, so everything after the byte left in the buffer is
+    // read straight from the source.
+    size_t n_read = mdl_reader_read(&reader, output, sizeof(output));
+    munit_assert_size(n_read, ==, TEST_SOURCE_LENGTH - 4);
+    munit_assert_memory_equal(n_read, output, TEST_SOURCE_DATA + 4);
+    munit_assert_int(mdl_reader_getc(&reader), ==, MDL_EOF);
+
+    mdl_reader_close(&reader);
+    return MUNIT_OK;
+}
+
+MunitResult test_reader__buffered_lookahead(const MunitParameter params[], void *udata)
+{
+    (void)params;
+    MDLState *mds = (MDLState *)udata;
+    MDLReader reader;
+    char buffer[8];
+    const void *ptr;
+    size_t length;
+    TestSource source = {TEST_SOURCE_DATA, 0, 0};
+
+    mdl_reader_init(mds, &reader, test_source_getc, NULL, &source);
+    munit_assert_int(mdl_reader_lookahead(&reader, 4, &ptr, &length), ==,
+                     MDL_ERROR_NOT_SUPPORTED);
+
+    // A character pushed back before buffering is turned on isn't lost.
+    munit_assert_int(mdl_reader_ungetc(&reader, '>'), ==, MDL_OK);
+    munit_assert_int(mdl_reader_setbuffer(&reader, buffer, sizeof(buffer)), ==, MDL_OK);
+
+    // Sources without block reads are only read as far as needed.
+    munit_assert_int(mdl_reader_lookahead(&reader, 5, &ptr, &length), ==, MDL_OK);
+    munit_assert_size(length, ==, 5);
+    munit_assert_memory_equal(5, ptr, ">This");
+    munit_assert_size(source.n_calls, ==, 4);
+
+    munit_assert_int(mdl_reader_lookahead(&reader, sizeof(buffer) + 1, &ptr, &length), ==,
+                     MDL_ERROR_OUT_OF_RANGE);
+
+    // Fill the buffer with pushed-back characters until there's no more room.
+    munit_assert_int(mdl_reader_ungetc(&reader, '1'), ==, MDL_OK);
+    munit_assert_int(mdl_reader_ungetc(&reader, '2'), ==, MDL_OK);
+    munit_assert_int(mdl_reader_ungetc(&reader, '3'), ==, MDL_OK);
+    munit_assert_int(mdl_reader_ungetc(&reader, '4'), ==, MDL_ERROR_FULL);
+
+    munit_assert_int(mdl_reader_lookahead(&reader, sizeof(buffer), &ptr, &length), ==,
+                     MDL_OK);
+    munit_assert_size(length, ==, sizeof(buffer));
+    munit_assert_memory_equal(sizeof(buffer), ptr, "321>This");
+
+    // Looking ahead doesn't consume anything.
+    munit_assert_int(mdl_reader_getc(&reader), ==, '3');
+
+    mdl_reader_close(&reader);
+    return MUNIT_OK;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// Helpers
+
+static size_t test_source_read(MDLReader *reader, void *buf, size_t size, void *udata)
+{
+    (void)reader;
+    TestSource *source = udata;
+    size_t n_remaining = TEST_SOURCE_LENGTH - source->position;
+
+    source->n_calls++;
+    if (size > TEST_SOURCE_CHUNK)
+        size = TEST_SOURCE_CHUNK;
+    if (size > n_remaining)
+        size = n_remaining;
+
+    memcpy(buf, source->data + source->position, size);
+    source->position += size;
+    return size;
+}
+
+static int test_source_getc(MDLReader *reader, void *udata)
+{
+    (void)reader;
+    TestSource *source = udata;
+
+    source->n_calls++;
+    if (source->position >= TEST_SOURCE_LENGTH)
+        return MDL_EOF;
+    return (unsigned char)source->data[source->position++];
+}
@@ -0,0 +1,362 @@
+// SPDX-License-Identifier: MPL-2.0+
+// Copyright (C) 2020-2025  Diego Argueta
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "metaldata/unrolledlist.h"
+#include "metaldata/errors.h"
+#include "metaldata/internal/annotations.h"
+#include "munit/munit.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+MDL_ANNOTN__NONNULL
+static void assert_list_contents(const MDLUnrolledList *list, const int *expected,
+                                 size_t length);
+
+MDL_ANNOTN__NONNULL
+static void assert_chunks_valid(const MDLUnrolledList *list);
+
+MunitResult test_unrolledlist__init(const MunitParameter params[], void *udata)
+{
+    (void)params;
+
+    MDLState *mds = (MDLState *)udata;
+    MDLUnrolledList list;
+
+    munit_assert_int(mdl_unrolledlist_init(mds, &list, sizeof(int)), ==, MDL_OK);
+    munit_assert_size(list.chunk_capacity, ==, MDL_DEFAULT_UNROLLEDLIST_CHUNK_CAPACITY);
+    munit_assert_size(mdl_unrolledlist_length(&list), ==, 0);
+    munit_assert_size(mdl_unrolledlist_getelementsize(&list), ==, sizeof(int));
+    munit_assert_null(mdl_unrolledlist_head(&list));
+    munit_assert_null(mdl_unrolledlist_tail(&list));
+    munit_assert_int(mdl_unrolledlist_pop(&list), ==, MDL_ERROR_EMPTY);
+    munit_assert_int(mdl_unrolledlist_popfront(&list), ==, MDL_ERROR_EMPTY);
+    munit_assert_int(mdl_unrolledlist_destroy(&list), ==, MDL_OK);
+
+    munit_assert_int(mdl_unrolledlist_initwithchunkcapacity(mds, &list, sizeof(int), 1),
+                     ==, MDL_ERROR_INVALID_ARGUMENT);
+    munit_assert_null(mdl_unrolledlist_newwithchunkcapacity(mds, sizeof(int), 0));
+
+    MDLUnrolledList *allocated = mdl_unrolledlist_new(mds, sizeof(int));
+    munit_assert_not_null(allocated);
+    munit_assert_int(mdl_unrolledlist_destroy(allocated), ==, MDL_OK);
+    return MUNIT_OK;
+}
+
+MunitResult test_unrolledlist__push_pop_both_ends(const MunitParameter params[],
+                                                  void *udata)
+{
+    (void)params;
+
+    MDLState *mds = (MDLState *)udata;
+    MDLUnrolledList list;
+    int expected[40];
+
+    munit_assert_int(mdl_unrolledlist_initwithchunkcapacity(mds, &list, sizeof(int), 4),
+                     ==, MDL_OK);
+
+    // Build [-1, -2, ..., -20] reversed in front of [0, 1, ..., 19].
+    for (int i = 0; i < 20; i++)
+    {
+        int *block = mdl_unrolledlist_push(&list);
+        munit_assert_not_null(block);
+        *block = i;
+
+        block = mdl_unrolledlist_pushfront(&list);
+        munit_assert_not_null(block);
+        *block = -(i + 1);
+    }
+
+    for (int i = 0; i < 40; i++)
+        expected[i] = i - 20;
+
+    assert_list_contents(&list, expected, 40);
+    munit_assert_int(*(int *)mdl_unrolledlist_head(&list), ==, -20);
+    munit_assert_int(*(int *)mdl_unrolledlist_tail(&list), ==, 19);
+
+    int value;
+    munit_assert_int(mdl_unrolledlist_popcopy(&list, &value), ==, MDL_OK);
+    munit_assert_int(value, ==, 19);
+    munit_assert_int(mdl_unrolledlist_popfrontcopy(&list, &value), ==, MDL_OK);
+    munit_assert_int(value, ==, -20);
+    assert_list_contents(&list, expected + 1, 38);
+
+    // Drain it completely from both ends; every chunk should be freed along the way.
+    for (int i = 0; i < 19; i++)
+    {
+        munit_assert_int(mdl_unrolledlist_pop(&list), ==, MDL_OK);
+        munit_assert_int(mdl_unrolledlist_popfront(&list), ==, MDL_OK);
+        assert_chunks_valid(&list);
+    }
+
+    munit_assert_size(mdl_unrolledlist_length(&list), ==, 0);
+    munit_assert_size(list.n_chunks, ==, 0);
+    munit_assert_null(list.head);
+    munit_assert_null(list.tail);
+    munit_assert_int(mdl_unrolledlist_destroy(&list), ==, MDL_OK);
+    return MUNIT_OK;
+}
+
+MunitResult test_unrolledlist__insert_splits_chunks(const MunitParameter params[],
+                                                    void *udata)
+{
+    (void)params;
+
+    MDLState *mds = (MDLState *)udata;
+    MDLUnrolledList list;
+    int expected[32];
+
+    munit_assert_int(mdl_unrolledlist_initwithchunkcapacity(mds, &list, sizeof(int), 4),
+                     ==, MDL_OK);
+
+    // Insert only even numbers, then fill in the odd numbers after each of them. This
+    // hits every position in a chunk, and forces a lot of splits.
+    for (int i = 0; i < 32; i += 2)
+    {
+        int *block = mdl_unrolledlist_push(&list);
+        munit_assert_not_null(block);
+        *block = i;
+    }
+    munit_assert_size(list.n_chunks, ==, 4);
+
+    for (int i = 1; i < 32; i += 2)
+    {
+        munit_assert_int(mdl_unrolledlist_insertaftercopy(&list, (size_t)(i - 1), &i), ==,
+                         MDL_OK);
+        assert_chunks_valid(&list);
+    }
+
+    for (int i = 0; i < 32; i++)
+        expected[i] = i;
+
+    assert_list_contents(&list, expected, 32);
+    munit_assert_size(list.n_chunks, >=, 8);
+
+    int value = 100;
+    munit_assert_int(mdl_unrolledlist_insertaftercopy(&list, 32, &value), ==,
+                     MDL_ERROR_OUT_OF_RANGE);
+    munit_assert_int(mdl_unrolledlist_set(&list, 32, &value), ==, MDL_ERROR_OUT_OF_RANGE);
+    munit_assert_int(mdl_unrolledlist_set(&list, 31, &value), ==, MDL_OK);
+    munit_assert_int(*(int *)mdl_unrolledlist_getblockat(&list, 31), ==, 100);
+    munit_assert_null(mdl_unrolledlist_getblockat(&list, 32));
+
+    munit_assert_int(mdl_unrolledlist_destroy(&list), ==, MDL_OK);
+    return MUNIT_OK;
+}
+
+MunitResult test_unrolledlist__remove_merges_chunks(const MunitParameter params[],
+                                                    void *udata)
+{
+    (void)params;
+
+    MDLState *mds = (MDLState *)udata;
+    MDLUnrolledList list;
+    int expected[64];
+    size_t length = 64;
+
+    munit_assert_int(mdl_unrolledlist_initwithchunkcapacity(mds, &list, sizeof(int), 8),
+                     ==, MDL_OK);
+
+    for (int i = 0; i < 64; i++)
+    {
+        int *block = mdl_unrolledlist_push(&list);
+        munit_assert_not_null(block);
+        *block = i;
+        expected[i] = i;
+    }
+    munit_assert_size(list.n_chunks, ==, 8);
+
+    // Remove every third element from the middle of the list, checking that the contents
+    // and chunks are still valid each time.
+    size_t index = 1;
+    while (index < length)
+    {
+        int value;
+        munit_assert_int(mdl_unrolledlist_removeatcopy(&list, index, &value), ==, MDL_OK);
+        munit_assert_int(value, ==, expected[index]);
+
+        for (size_t i = index; i + 1 < length; i++)
+            expected[i] = expected[i + 1];
+        length--;
+
+        assert_chunks_valid(&list);
+        assert_list_contents(&list, expected, length);
+        index += 2;
+    }
+
+    // Rebalancing should have kept the list from degrading into mostly-empty chunks.
+    munit_assert_size(list.n_chunks, <=, (length + 3) / 4);
+
+    munit_assert_int(mdl_unrolledlist_removeat(&list, length), ==,
+                     MDL_ERROR_OUT_OF_RANGE);
+    while (mdl_unrolledlist_length(&list) > 0)
+    {
+        munit_assert_int(mdl_unrolledlist_removeat(&list, 0), ==, MDL_OK);
+        assert_chunks_valid(&list);
+    }
+    munit_assert_size(list.n_chunks, ==, 0);
+
+    munit_assert_int(mdl_unrolledlist_destroy(&list), ==, MDL_OK);
+    return MUNIT_OK;
+}
+
+MunitResult test_unrolledlist__find(const MunitParameter params[], void *udata)
+{
+    (void)params;
+
+    MDLState *mds = (MDLState *)udata;
+    MDLUnrolledList list;
+    const int values[] = {5, 3, 8, 3, 9, 1, 3, 7, 2};
+    const size_t n_values = sizeof(values) / sizeof(values[0]);
+
+    munit_assert_int(mdl_unrolledlist_initwithchunkcapacity(mds, &list, sizeof(int), 2),
+                     ==, MDL_OK);
+    for (size_t i = 0; i < n_values; i++)
+        *(int *)mdl_unrolledlist_push(&list) = values[i];
+
+    int needle = 3;
+    const void *found;
+    munit_assert_size(mdl_unrolledlist_findindex(&list, &needle,
+                                                 mdl_default_memory_comparator),
+                      ==, 1);
+    munit_assert_size(mdl_unrolledlist_rfindindex(&list, &needle,
+                                                  mdl_default_memory_comparator),
+                      ==, 6);
+    munit_assert_int(
+        mdl_unrolledlist_find(&list, &needle, mdl_default_memory_comparator, &found), ==,
+        MDL_OK);
+    munit_assert_int(*(const int *)found, ==, 3);
+
+    munit_assert_int(
+        mdl_unrolledlist_removevalue(&list, &needle, mdl_default_memory_comparator), ==,
+        1);
+    munit_assert_size(mdl_unrolledlist_findindex(&list, &needle,
+                                                 mdl_default_memory_comparator),
+                      ==, 2);
+
+    needle = 4;
+    munit_assert_size(mdl_unrolledlist_findindex(&list, &needle,
+                                                 mdl_default_memory_comparator),
+                      ==, MDL_INVALID_INDEX);
+    munit_assert_size(mdl_unrolledlist_rfindindex(&list, &needle,
+                                                  mdl_default_memory_comparator),
+                      ==, MDL_INVALID_INDEX);
+    munit_assert_int(
+        mdl_unrolledlist_find(&list, &needle, mdl_default_memory_comparator, &found), ==,
+        MDL_ERROR_NOT_FOUND);
+    munit_assert_int(
+        mdl_unrolledlist_removevalue(&list, &needle, mdl_default_memory_comparator), ==,
+        0);
+
+    munit_assert_int(mdl_unrolledlist_destroy(&list), ==, MDL_OK);
+    return MUNIT_OK;
+}
+
+MunitResult test_unrolledlist__iterate(const MunitParameter params[], void *udata)
+{
+    (void)params;
+
+    MDLState *mds = (MDLState *)udata;
+    MDLUnrolledList list;
+    MDLUnrolledListIterator iter;
+
+    munit_assert_int(mdl_unrolledlist_initwithchunkcapacity(mds, &list, sizeof(int), 4),
+                     ==, MDL_OK);
+    for (int i = 0; i < 10; i++)
+        *(int *)mdl_unrolledlist_push(&list) = i;
+
+    // Element by element, forward and backward.
+    mdl_unrolledlistiter_init(&list, &iter, false);
+    for (int i = 0; i < 10; i++)
+    {
+        munit_assert_int(*(int *)mdl_unrolledlistiter_get(&iter), ==, i);
+        munit_assert(mdl_unrolledlistiter_hasnext(&iter) == (i < 9));
+        munit_assert_int(mdl_unrolledlistiter_next(&iter), ==,
+                         (i < 9) ? MDL_OK : MDL_EOF);
+    }
+
+    MDLUnrolledListIterator *reverse = mdl_unrolledlist_getiterator(&list, true);
+    munit_assert_not_null(reverse);
+    for (int i = 9; i >= 0; i--)
+    {
+        munit_assert_int(*(int *)mdl_unrolledlistiter_get(reverse), ==, i);
+        munit_assert_int(mdl_unrolledlistiter_next(reverse), ==,
+                         (i > 0) ? MDL_OK : MDL_EOF);
+    }
+    mdl_unrolledlistiter_destroy(reverse);
+
+    // By chunk, starting partway through the first one.
+    const void *span;
+    size_t span_length;
+    int next_expected = 1;
+
+    mdl_unrolledlistiter_init(&list, &iter, false);
+    munit_assert_int(mdl_unrolledlistiter_next(&iter), ==, MDL_OK);
+    while ((span_length = mdl_unrolledlistiter_nextspan(&iter, &span)) > 0)
+    {
+        const int *values = span;
+        munit_assert_size(span_length, <=, 4);
+        for (size_t i = 0; i < span_length; i++)
+            munit_assert_int(values[i], ==, next_expected++);
+    }
+    munit_assert_int(next_expected, ==, 10);
+    munit_assert_int(*(int *)mdl_unrolledlistiter_get(&iter), ==, 9);
+
+    mdl_unrolledlistiter_init(&list, &iter, true);
+    next_expected = 9;
+    while ((span_length = mdl_unrolledlistiter_nextspan(&iter, &span)) > 0)
+    {
+        const int *values = span;
+        for (size_t i = span_length; i > 0; i--)
+            munit_assert_int(values[i - 1], ==, next_expected--);
+    }
+    munit_assert_int(next_expected, ==, -1);
+    munit_assert_int(*(int *)mdl_unrolledlistiter_get(&iter), ==, 0);
+
+    munit_assert_int(mdl_unrolledlist_destroy(&list), ==, MDL_OK);
+    return MUNIT_OK;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// Helpers
+
+static void assert_list_contents(const MDLUnrolledList *list, const int *expected,
+                                 size_t length)
+{
+    munit_assert_size(mdl_unrolledlist_length(list), ==, length);
+    for (size_t i = 0; i < length; i++)
+    {
+        const int *block = mdl_unrolledlist_getblockat(list, i);
+        munit_assert_not_null(block);
+        munit_assert_int(*block, ==, expected[i]);
+    }
+}
+
+/**
+ * Check that the chunks are linked correctly, none of them are empty or overfull, and
+ * their lengths add up to the length of the list.
+ */
+static void assert_chunks_valid(const MDLUnrolledList *list)
+{
+    size_t total_length = 0;
+    size_t n_chunks = 0;
+    const MDLUnrolledListChunk *prev = NULL;
+
+    for (const MDLUnrolledListChunk *chunk = list->head; chunk != NULL;
+         chunk = chunk->next)
+    {
+        munit_assert_ptr_equal(chunk->prev, prev);
+        munit_assert_size(chunk->length, >, 0);
+        munit_assert_size(chunk->length, <=, list->chunk_capacity);
+        total_length += chunk->length;
+        n_chunks++;
+        prev = chunk;
+    }
+
+    munit_assert_ptr_equal(list->tail, prev);
+    munit_assert_size(total_length, ==, list->length);
+    munit_assert_size(n_chunks, ==, list->n_chunks);
+}
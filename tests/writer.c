@@ -8,6 +8,23 @@
 #include "metaldata/writer.h"
 #include "metaldata/errors.h"
 #include "munit/munit.h"
+#include <string.h>
+
+/** The most bytes @ref test_sink_write accepts per call. */
+#define TEST_SINK_CHUNK 4
+
+/** The total number of bytes a @ref TestSink can hold. */
+#define TEST_SINK_CAPACITY 26
+
+/** A callback-backed output that counts how many times it's called. */
+typedef struct
+{
+    char data[TEST_SINK_CAPACITY];
+    size_t position;
+    size_t n_calls;
+} TestSink;
+
+static size_t test_sink_write(MDLWriter *writer, const void *data, size_t size);
 
 MunitResult test_writer__buffer_init_static(const MunitParameter params[], void *udata)
 {
@@ -50,3 +67,152 @@ MunitResult test_writer__buffer_putc(const MunitParameter params[], void *udata)
     mdl_writer_close(&writer);
     return MUNIT_OK;
 }
+
+MunitResult test_writer__buffer_write(const MunitParameter params[], void *udata)
+{
+    (void)params;
+    MDLState *mds = (MDLState *)udata;
+    char buffer[8];
+
+    MDLWriter *writer = mdl_writer_newwithbuffer(mds, buffer, sizeof(buffer));
+    munit_assert_not_null(writer);
+
+    munit_assert_size(mdl_writer_write(writer, "abc", 3), ==, 3);
+    munit_assert_int(mdl_writer_putc(writer, 'd'), ==, MDL_OK);
+
+    // Only part of this fits.
+    munit_assert_size(mdl_writer_write(writer, "efghijk", 7), ==, 4);
+    munit_assert_memory_equal(8, buffer, "abcdefgh");
+    munit_assert_size(writer->buffer_position, ==, 8);
+
+    munit_assert_size(mdl_writer_write(writer, "x", 1), ==, 0);
+    munit_assert_int(mdl_writer_putc(writer, 'x'), ==, MDL_ERROR_FULL);
+
+    mdl_writer_close(writer);
+    return MUNIT_OK;
+}
+
+MunitResult test_writer__block_writer(const MunitParameter params[], void *udata)
+{
+    (void)params;
+    MDLState *mds = (MDLState *)udata;
+    MDLWriter writer;
+    TestSink sink = {{0}, 0, 0};
+
+    mdl_writer_initblockwriter(mds, &writer, test_sink_write, NULL, &sink);
+    munit_assert_ptr_equal(mdl_writer_getudata(&writer), &sink);
+
+    munit_assert_int(mdl_writer_putc(&writer, '<'), ==, MDL_OK);
+    munit_assert_size(sink.n_calls, ==, 1);
+
+    // The sink takes short writes, so this needs one call per chunk.
+    munit_assert_size(mdl_writer_write(&writer, "0123456789abcdef", 16), ==, 16);
+    munit_assert_size(sink.n_calls, ==, 1 + 16 / TEST_SINK_CHUNK);
+
+    // Writing past the end of the sink gives back how much it took.
+    munit_assert_size(mdl_writer_write(&writer, "ghijklmnopqrstuvwxyz", 20), ==,
+                      TEST_SINK_CAPACITY - 17);
+    munit_assert_memory_equal(TEST_SINK_CAPACITY, sink.data,
+                              "<0123456789abcdefghijklmno");
+    munit_assert_int(mdl_writer_putc(&writer, '>'), ==, MDL_ERROR_FULL);
+
+    mdl_writer_close(&writer);
+    return MUNIT_OK;
+}
+
+MunitResult test_writer__buffered_writer(const MunitParameter params[], void *udata)
+{
+    (void)params;
+    MDLState *mds = (MDLState *)udata;
+    MDLWriter writer;
+    TestSink sink = {{0}, 0, 0};
+
+    mdl_writer_initblockwriter(mds, &writer, test_sink_write, NULL, &sink);
+    munit_assert_int(mdl_writer_setbuffer(&writer, NULL, 0), ==,
+                     MDL_ERROR_INVALID_ARGUMENT);
+    munit_assert_int(mdl_writer_setbuffer(&writer, NULL, 8), ==, MDL_OK);
+    munit_assert_int(mdl_writer_setbuffer(&writer, NULL, 8), ==,
+                     MDL_ERROR_ALREADY_EXISTS);
+
+    // Nothing reaches the output until the buffer fills up.
+    munit_assert_int(mdl_writer_putc(&writer, 'a'), ==, MDL_OK);
+    munit_assert_int(mdl_writer_putc(&writer, 'b'), ==, MDL_OK);
+    munit_assert_int(mdl_writer_putc(&writer, 'c'), ==, MDL_OK);
+    munit_assert_size(mdl_writer_write(&writer, "defg", 4), ==, 4);
+    munit_assert_size(sink.n_calls, ==, 0);
+
+    // This overflows the buffer, so the first eight bytes are flushed in two chunks and
+    // the rest is kept.
+    munit_assert_size(mdl_writer_write(&writer, "hij", 3), ==, 3);
+    munit_assert_size(sink.n_calls, ==, 2);
+    munit_assert_size(sink.position, ==, 8);
+
+    munit_assert_int(mdl_writer_flush(&writer), ==, MDL_OK);
+    munit_assert_size(sink.n_calls, ==, 3);
+    munit_assert_int(mdl_writer_flush(&writer), ==, MDL_OK);
+    munit_assert_size(sink.n_calls, ==, 3);
+
+    // After the buffer is flushed, what's left is too big for it and is written directly.
+    munit_assert_size(mdl_writer_write(&writer, "klmnopqrstuvwxyz", 16), ==, 16);
+    munit_assert_size(sink.n_calls, ==, 7);
+    munit_assert_memory_equal(TEST_SINK_CAPACITY, sink.data,
+                              "abcdefghijklmnopqrstuvwxyz");
+
+    // The sink is full now, so flushing fails and the data stays in the buffer.
+    munit_assert_int(mdl_writer_putc(&writer, '!'), ==, MDL_OK);
+    munit_assert_int(mdl_writer_flush(&writer), ==, MDL_ERROR_FULL);
+    munit_assert_size(writer.staging_length, ==, 1);
+
+    // Closing tries to flush too.
+    munit_assert_int(mdl_writer_close(&writer), ==, MDL_ERROR_FULL);
+    return MUNIT_OK;
+}
+
+MunitResult test_writer__buffered_close_flushes(const MunitParameter params[],
+                                                void *udata)
+{
+    (void)params;
+    MDLState *mds = (MDLState *)udata;
+    char buffer[4];
+    char staging[16];
+    TestSink sink = {{0}, 0, 0};
+
+    // Memory writers don't need a staging buffer.
+    MDLWriter *writer = mdl_writer_newwithbuffer(mds, buffer, sizeof(buffer));
+    munit_assert_not_null(writer);
+    munit_assert_int(mdl_writer_setbuffer(writer, staging, sizeof(staging)), ==,
+                     MDL_ERROR_NOT_SUPPORTED);
+    mdl_writer_close(writer);
+
+    writer = mdl_writer_newblockwriter(mds, test_sink_write, NULL, &sink);
+    munit_assert_not_null(writer);
+    munit_assert_int(mdl_writer_setbuffer(writer, staging, sizeof(staging)), ==, MDL_OK);
+
+    munit_assert_size(mdl_writer_write(writer, "hello", 5), ==, 5);
+    munit_assert_int(mdl_writer_putc(writer, '!'), ==, MDL_OK);
+    munit_assert_size(sink.n_calls, ==, 0);
+
+    munit_assert_int(mdl_writer_close(writer), ==, MDL_OK);
+    munit_assert_size(sink.position, ==, 6);
+    munit_assert_memory_equal(6, sink.data, "hello!");
+    return MUNIT_OK;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// Helpers
+
+static size_t test_sink_write(MDLWriter *writer, const void *data, size_t size)
+{
+    TestSink *sink = mdl_writer_getudata(writer);
+    size_t n_remaining = TEST_SINK_CAPACITY - sink->position;
+
+    sink->n_calls++;
+    if (size > TEST_SINK_CHUNK)
+        size = TEST_SINK_CHUNK;
+    if (size > n_remaining)
+        size = n_remaining;
+
+    memcpy(sink->data + sink->position, data, size);
+    sink->position += size;
+    return size;
+}